@@ -6,9 +6,17 @@ static const char INI_FILE[] = "mediabrowser.ini";
 #define SETTINGS_LIST	\
 	X(ffmpegPath,		"ffmpeg", "ffmpeg.exe")	\
 	X(tagsPath,			"tags",	  "tags.txt")	\
+	X(tagsDbPath,		"tags_db", "")	\
+	X(metadataCachePath, "metadata_cache", "metadata.cache")	\
+	X(stallLogPath,		"stall_log", "stalls.log")	\
+	X(stallThresholdMs,	"stall_ms", 50)	\
 	X(sourceRoot,		"source", ".")	\
 	X(targetRoot,		"target", ".")	\
 	X(thumbnailSize,	"size",   "200")\
+	X(justifiedLayout,	"justified", false)\
+	X(sortField,		"sort", 0)\
+	X(sortDescending,	"sort_desc", false)\
+	X(groupBySort,		"group", false)\
 	X(windowGeometry,	"win_geometry", QVariant())\
 	X(windowState,		"win_state", QVariant())\
 	X(leftPanelWidth,	"cats_width", Settings::DEFAULT_LEFT_PANEL_WIDTH)\
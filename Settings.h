@@ -13,9 +13,17 @@ struct Settings
 
 	QString ffmpegPath;
 	QString tagsPath;
+	QString tagsDbPath;		//  -   sidecar-
+	QString metadataCachePath;	//  -     
+	QString stallLogPath;		//   GUI-
+	int stallThresholdMs;		// 0 -  
 	QString sourceRoot;
 	QString targetRoot;
 	int thumbnailSize;
+	bool justifiedLayout;	//     
+	int sortField;			// MetadataColumns::Field
+	bool sortDescending;
+	bool groupBySort;		//     
 
 	QByteArray windowGeometry;
 	QByteArray windowState;
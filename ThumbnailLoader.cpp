@@ -11,12 +11,15 @@
 #include <QDebug>
 #include <QProcess>
 #include "FFmpegThumbnailer.h"
+#include "perfstats.h"
 
 ThumbnailLoader::ThumbnailLoader(const QString &ffmpeg_path, int tn_size, QObject *parent)
 	: QObject(parent)
 	, m_ffmpegPath(ffmpeg_path)
 	, m_thumbnailSize(tn_size)
 	, m_abortFlag(false)
+	, m_scrollingFast(false)
+	, m_readAspectRatios(false)
 {
 }
 
@@ -45,17 +48,100 @@ void ThumbnailLoader::loadThumbnails(const QString& folderPath)
 		<< "*.MP4" << "*.AVI" << "*.MKV" << "*.MOV";
 
 	QStringList allFilters = imageFilters + videoFilters;
+	PerfTimer enumerateTimer(PerfStats::Enumerate);
 	QStringList files = dir.entryList(allFilters, QDir::Files, QDir::Name);
+	enumerateTimer.stop();
 		
+	QStringList filePaths;
+	for (const QString &file : files) {
+		filePaths.append(dir.absoluteFilePath(file));
+	}
+	loadFiles(filePaths);
+}
+
+void ThumbnailLoader::loadFileList(const QStringList& filePaths)
+{
+	QMutexLocker locker(&m_mutex);
+	m_abortFlag = false;
 
-	for (int i = 0; i < files.size(); ++i) {
+	locker.unlock();
+
+	loadFiles(filePaths);
+}
+
+void ThumbnailLoader::setDecodeFocus(const QVector<int>& indices, bool scrollingFast)
+{
+	QMutexLocker locker(&m_mutex);
+	m_focus = indices;
+	m_scrollingFast = scrollingFast;
+}
+
+void ThumbnailLoader::setReadAspectRatios(bool enabled)
+{
+	QMutexLocker locker(&m_mutex);
+	m_readAspectRatios = enabled;
+}
+
+//  :  ,   ;   
+//    focusOnly -   (-1 -  )
+int ThumbnailLoader::nextFileIndex(const QVector<bool>& done, int& sequential, bool focusOnly)
+{
+	QMutexLocker locker(&m_mutex);
+	for (int index : m_focus) {
+		if (index >= 0 && index < done.size() && !done[index]) {
+			return index;
+		}
+	}
+	if (m_scrollingFast || focusOnly) {
+		return -1;
+	}
+
+	while (sequential < done.size() && done[sequential]) {
+		++sequential;
+	}
+	return sequential < done.size() ? sequential : -1;
+}
+
+void ThumbnailLoader::loadFiles(const QStringList& filePaths)
+{
+	QStringList videoFilters;
+	videoFilters << "*.mp4" << "*.avi" << "*.mkv" << "*.mov" << "*.wmv"
+		<< "*.flv" << "*.m4v" << "*.mpg" << "*.mpeg" << "*.3gp";
+
+	QVector<bool> done(filePaths.size(), false);
+	int remaining = filePaths.size();
+	int sequential = 0;
+	int headersRead = 0;		//      
+
+	while (remaining > 0) {
 		//  
 		{
 			QMutexLocker locker(&m_mutex);
 			if (m_abortFlag) break;
 		}
 
-		QString filePath = dir.absoluteFilePath(files[i]);
+		// ,    ,  . 
+		//    ,     :
+		//     ,    
+		bool headersPending;
+		{
+			QMutexLocker locker(&m_mutex);
+			headersPending = m_readAspectRatios && headersRead < filePaths.size();
+		}
+		const int i = nextFileIndex(done, sequential, headersPending);
+		if (i < 0) {
+			if (headersPending) {
+				headersRead = readAspectRatios(filePaths, headersRead);
+			}
+			else {
+				QThread::msleep(10);
+			}
+			continue;
+		}
+		done[i] = true;
+		--remaining;
+
+		const QString &filePath = filePaths[i];
 		QPixmap thumbnail;
 
 		QFileInfo fileInfo(filePath);
@@ -72,7 +158,7 @@ void ThumbnailLoader::loadThumbnails(const QString& folderPath)
 		}
 
 		if (!thumbnail.isNull()) {
-			emit thumbnailLoaded(i, thumbnail);
+			emit thumbnailLoaded(i, thumbnail, PerfStats::now());
 		}
 
 		//    
@@ -82,14 +168,42 @@ void ThumbnailLoader::loadThumbnails(const QString& folderPath)
 	emit loadingFinished();
 }
 
+//     first; ,  .
+// QImageReader::size()   ,  
+int ThumbnailLoader::readAspectRatios(const QStringList& filePaths, int first)
+{
+	const int batchSize = 256;
+	const int last = qMin(filePaths.size(), first + batchSize);
+
+	QVector<float> ratios(last - first, 0.0f);
+	for (int i = first; i < last; ++i) {
+		PerfTimer timer(PerfStats::HeaderRead);
+		QImageReader reader(filePaths[i]);
+		QSize size = reader.size();
+		if (!size.isValid() || size.isEmpty()) {
+			continue;	//    -  
+		}
+		if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+			size.transpose();
+		}
+		ratios[i - first] = float(size.width()) / size.height();
+	}
+
+	emit aspectRatiosLoaded(first, ratios);
+	return last;
+}
+
 QPixmap ThumbnailLoader::generateImageThumbnail(const QString& filePath, int size)
 {
 	QMutexLocker locker(&m_mutex);
 	if (m_abortFlag) return QPixmap();
 	locker.unlock();
 
+	PerfTimer decodeTimer(PerfStats::ImageDecode, filePath);
 	QImageReader reader(filePath);
 	if (!reader.canRead()) {
+		decodeTimer.discard();
+		PerfStats::add(PerfStats::DecodeFailed);
 		return QPixmap();
 	}
 
@@ -103,11 +217,17 @@ QPixmap ThumbnailLoader::generateImageThumbnail(const QString& filePath, int siz
 	}
 
 	QImage image = reader.read();
+	decodeTimer.stop();
 	if (image.isNull()) {
+		PerfStats::add(PerfStats::DecodeFailed);
 		return QPixmap();
 	}
 
-	QImage scaled = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	PerfTimer scaleTimer(PerfStats::Scale);
+
+	//  :       
+	//  thumbnailSize,      
+	QImage scaled = image.scaled(size * 4, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
 	return QPixmap::fromImage(scaled);
 }
 
@@ -117,10 +237,13 @@ QPixmap ThumbnailLoader::generateVideoThumbnail(const QString& filePath, int siz
 	if (m_abortFlag) return QPixmap();
 	locker.unlock();
 
+	PerfTimer frameTimer(PerfStats::FFmpegFrame, filePath);
 	QPixmap thumbnail = extractFrameWithFFmpeg(filePath, size);
+	frameTimer.stop();
 
 	//   ,  
 	if (thumbnail.isNull()) {
+		PerfStats::add(PerfStats::FFmpegFailed);
 		thumbnail = QPixmap(size, size);
 		thumbnail.fill(QColor(50, 50, 60));
 
@@ -169,12 +292,17 @@ QPixmap ThumbnailLoader::extractFrameWithFFmpeg(const QString& videoPath, int si
 		<< "-c:v" << "png"                 //  PNG
 		<< "-" << "-y";                    // "-"    stdout
 
+	TraceProcess trace("ffmpeg", videoPath);
+	PerfTimer spawnTimer(PerfStats::FFmpegSpawn);
 	ffmpeg.start(m_ffmpegPath, args);
 
 	if (!ffmpeg.waitForStarted(2000)) {
+		spawnTimer.discard();
 		emit errorOccurred("Failed to start FFmpeg");
 		return QPixmap();
 	}
+	spawnTimer.stop();
+	trace.started(ffmpeg);
 
 	//   
 	if (!ffmpeg.waitForFinished(5000)) {
@@ -9,6 +9,7 @@
 #include <QWaitCondition>
 #include <QMediaPlayer>
 #include <QVideoProbe>
+#include <QVector>
 
 
 class ThumbnailLoader : public QObject
@@ -19,12 +20,24 @@ public:
 	explicit ThumbnailLoader(const QString &ffmpeg_path, int tn_size, QObject *parent = nullptr);
 	~ThumbnailLoader();
 
+	//      ( ).   
+	//  (scrollingFast),   . 
+	//   GUI-,  cancelLoading
+	void setDecodeFocus(const QVector<int>& indices, bool scrollingFast);
+	//      -    ;
+	//    ,     
+	void setReadAspectRatios(bool enabled);
+
 public slots:
 	void loadThumbnails(const QString& folderPath);
+	void loadFileList(const QStringList& filePaths);	//    
 	void cancelLoading();
 
 signals:
-	void thumbnailLoaded(int index, const QPixmap& pixmap);
+	// emittedUs - PerfStats::now()    ( )
+	void thumbnailLoaded(int index, const QPixmap& pixmap, qint64 emittedUs);
+	//  (/)  first..  , 0 - 
+	void aspectRatiosLoaded(int first, const QVector<float>& ratios);
 	void loadingFinished();
 	void errorOccurred(const QString& error);
 
@@ -32,11 +45,17 @@ private slots:
 //	void onVideoFrameAvailable(const QVideoFrame &frame);
 
 private:
+	void loadFiles(const QStringList& filePaths);
+	int nextFileIndex(const QVector<bool>& done, int& sequential, bool focusOnly);
+	int readAspectRatios(const QStringList& filePaths, int first);
 	QPixmap generateImageThumbnail(const QString& imagePath, int size);
 	QPixmap generateVideoThumbnail(const QString& videoPath, int size);
 	QPixmap extractFrameWithFFmpeg(const QString& videoPath, int size);
 
 	bool m_abortFlag;
+	QVector<int> m_focus;		//   (   )
+	bool m_scrollingFast;
+	bool m_readAspectRatios;
 	QMutex m_mutex;
 	QString m_ffmpegPath;
 	int m_thumbnailSize = 200; 
@@ -7,6 +7,8 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QListWidget>
+#include <QAction>
 
 CategoriesPanel::CategoriesPanel(QWidget *parent)
 	: QDockWidget(parent)
@@ -16,6 +18,8 @@ CategoriesPanel::CategoriesPanel(QWidget *parent)
 	, m_moveSelectedButton(nullptr)
 	, m_moveAllButton(nullptr)
 	, m_newCategoryButton(nullptr)
+	, m_smartFolderList(nullptr)
+	, m_newSmartFolderButton(nullptr)
 {
 	setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
 
@@ -30,6 +34,14 @@ CategoriesPanel::CategoriesPanel(QWidget *parent)
 	m_categoryTree = new QTreeView();
 	m_newCategoryButton = new QPushButton("New category");
 
+	//   (   )
+	m_smartFolderList = new QListWidget();
+	m_smartFolderList->setMaximumHeight(150);
+	m_smartFolderList->setContextMenuPolicy(Qt::ActionsContextMenu);
+	QAction *deleteAction = new QAction("Delete smart folder", m_smartFolderList);
+	m_smartFolderList->addAction(deleteAction);
+	m_newSmartFolderButton = new QPushButton("New smart folder");
+
 	//  
 	m_categoryTree->setHeaderHidden(true);
 	m_categoryTree->setAnimated(true);
@@ -58,6 +70,9 @@ CategoriesPanel::CategoriesPanel(QWidget *parent)
 	mainLayout->addWidget(m_labDst);
 	mainLayout->addWidget(m_categoryTree, 1); //  
 	mainLayout->addWidget(m_newCategoryButton);
+	mainLayout->addWidget(new QLabel("Smart folders:"));
+	mainLayout->addWidget(m_smartFolderList);
+	mainLayout->addWidget(m_newSmartFolderButton);
 	mainLayout->addStretch();
 
 	contentWidget->setLayout(mainLayout);
@@ -77,6 +92,12 @@ CategoriesPanel::CategoriesPanel(QWidget *parent)
 		this, &CategoriesPanel::onNewCategoryClicked);
 	connect(m_categoryTree->selectionModel(), &QItemSelectionModel::selectionChanged,
 		this, &CategoriesPanel::onTreeSelectionChanged);
+	connect(m_newSmartFolderButton, &QPushButton::clicked,
+		this, &CategoriesPanel::onNewSmartFolderClicked);
+	connect(m_smartFolderList, &QListWidget::itemClicked,
+		this, &CategoriesPanel::onSmartFolderClicked);
+	connect(deleteAction, &QAction::triggered,
+		this, &CategoriesPanel::onDeleteSmartFolderClicked);
 }
 
 CategoriesPanel::~CategoriesPanel()
@@ -142,6 +163,25 @@ void CategoriesPanel::refreshTree()
 	}
 }
 
+void CategoriesPanel::setSmartFolders(const QList<QPair<QString, int>>& folders)
+{
+	//   -      
+	QString current;
+	if (m_smartFolderList->currentItem()) {
+		current = m_smartFolderList->currentItem()->data(Qt::UserRole).toString();
+	}
+
+	m_smartFolderList->clear();
+	for (const auto &folder : folders) {
+		QListWidgetItem *item = new QListWidgetItem(
+			QString("%1 (%2)").arg(folder.first).arg(folder.second), m_smartFolderList);
+		item->setData(Qt::UserRole, folder.first);
+		if (folder.first == current) {
+			m_smartFolderList->setCurrentItem(item);
+		}
+	}
+}
+
 //  
 void CategoriesPanel::onMoveSelectedClicked()
 {
@@ -250,3 +290,59 @@ void CategoriesPanel::updateTreeRoot()
 		m_categoryTree->setRootIndex(m_categoriesModel->index(m_targetRoot));
 	}
 }
+
+void CategoriesPanel::onSmartFolderClicked(QListWidgetItem *item)
+{
+	if (item) {
+		emit smartFolderSelected(item->data(Qt::UserRole).toString());
+	}
+}
+
+void CategoriesPanel::onNewSmartFolderClicked()
+{
+	bool ok;
+	QString expression = QInputDialog::getText(
+		this,
+		"New Smart Folder",
+		"Tag query (e.g. \"todo AND NOT reviewed\"):",
+		QLineEdit::Normal,
+		"",
+		&ok
+	).trimmed();
+
+	if (!ok || expression.isEmpty()) {
+		return;
+	}
+
+	QString name = QInputDialog::getText(
+		this,
+		"New Smart Folder",
+		"Enter smart folder name:",
+		QLineEdit::Normal,
+		expression,
+		&ok
+	).trimmed();
+
+	if (!ok || name.isEmpty()) {
+		return;
+	}
+
+	emit smartFolderCreated(name, expression);
+}
+
+void CategoriesPanel::onDeleteSmartFolderClicked()
+{
+	QListWidgetItem *item = m_smartFolderList->currentItem();
+	if (!item) {
+		return;
+	}
+
+	const QString name = item->data(Qt::UserRole).toString();
+	if (QMessageBox::question(this, "Delete Smart Folder",
+		QString("Delete smart folder '%1'?\nTagged files are not affected.").arg(name),
+		QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+		return;
+	}
+
+	emit smartFolderRemoved(name);
+}
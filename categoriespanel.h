@@ -6,6 +6,8 @@
 #include <QFileSystemModel>
 
 class QPushButton;
+class QListWidget;
+class QListWidgetItem;
 
 class CategoriesPanel : public QDockWidget
 {
@@ -27,17 +29,25 @@ public:
 	void updateLabels();
 	void refreshTree();
 
+	//  : (,  )
+	void setSmartFolders(const QList<QPair<QString, int>>& folders);
+
 signals:
 	//    
 	void moveSelectedRequested(const QString& targetCategory);
 	void moveAllRequested(const QString& targetCategory);
 	void newCategoryRequested(const QString& parentPath);
 	void categorySelected(const QString& categoryPath);
+	void smartFolderSelected(const QString& name);
+	void smartFolderCreated(const QString& name, const QString& expression);
+	void smartFolderRemoved(const QString& name);
 
 public slots:
 	void onMoveSelectedClicked();
 	void onMoveAllClicked();
 	void onNewCategoryClicked();
+	void onNewSmartFolderClicked();
+	void onDeleteSmartFolderClicked();
 
 private:
 	// UI 
@@ -48,6 +58,8 @@ private:
 	QPushButton *m_moveSelectedButton;
 	QPushButton *m_moveAllButton;
 	QPushButton *m_newCategoryButton;
+	QListWidget *m_smartFolderList;
+	QPushButton *m_newSmartFolderButton;
 
 	// 
 	QString m_targetRoot;
@@ -55,4 +67,5 @@ private:
 private slots:
 	void onTreeSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
 	void updateTreeRoot();
+	void onSmartFolderClicked(QListWidgetItem *item);
 };
@@ -0,0 +1,460 @@
+#include "imageviewer.h"
+#include "tracer.h"
+#include <QImageReader>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QFileInfo>
+#include <QThread>
+#include <QDebug>
+#include <QtConcurrent>
+#include <cmath>
+
+static const int TILE_SIZE = 512;					//     
+static const int TILE_CACHE_KB = 256 * 1024;		//   
+static const qint64 MAX_WHOLE_PIXELS = 64 * 1024 * 1024;	//   -  
+static const double MAX_ZOOM = 8.0;
+
+ImageViewer::ImageViewer(QWidget *parent)
+	: QWidget(parent, Qt::Window)
+	, m_current(-1)
+	, m_zoom(1.0)
+	, m_fit(true)
+	, m_generation(0)
+{
+	m_info.rotated = false;
+	m_info.tiled = false;
+
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setFocusPolicy(Qt::StrongFocus);
+	resize(1280, 800);
+
+	m_tiles.setMaxCost(TILE_CACHE_KB);
+	m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+}
+
+ImageViewer::~ImageViewer()
+{
+	//      
+	m_generation.fetchAndAddOrdered(1);
+	m_pool.clear();
+	m_pool.waitForDone();
+}
+
+//  ,   :     
+bool ImageViewer::canView(const QString& filePath)
+{
+	static const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+	return formats.contains(QFileInfo(filePath).suffix().toLower().toLatin1());
+}
+
+void ImageViewer::setFiles(const QStringList& filePaths, int current)
+{
+	m_files = filePaths;
+	m_current = qBound(-1, current, m_files.size() - 1);
+	showCurrent();
+}
+
+//  ,  
+ImageViewer::ImageInfo ImageViewer::readInfo(const QString& filePath)
+{
+	QImageReader reader(filePath);
+
+	ImageInfo info;
+	info.size = reader.size();
+	info.rotated = false;
+	info.tiled = false;
+	if (!info.size.isValid() || info.size.isEmpty()) {
+		info.size = QSize();
+		return info;
+	}
+
+	const QImageIOHandler::Transformations transformation = reader.transformation();
+	info.rotated = transformation & QImageIOHandler::TransformationRotate90;
+	if (info.rotated) {
+		info.size.transpose();
+	}
+
+	//  -      ; 
+	//  EXIF     
+	info.tiled = transformation == QImageIOHandler::TransformationNone
+		&& reader.supportsOption(QImageIOHandler::ClipRect)
+		&& reader.supportsOption(QImageIOHandler::ScaledSize);
+	return info;
+}
+
+//   . level < 0 -    overviewSize;
+//    1/2^level (   -  )
+ImageViewer::TileResult ImageViewer::decodeTile(TileKey key, ImageInfo info, QSize overviewSize,
+	int generation, const QAtomicInt *current)
+{
+	TileResult result;
+	result.key = key;
+	result.generation = generation;
+
+	//    -   
+	if (generation >= 0 && current->loadAcquire() != generation) {
+		return result;
+	}
+
+	TraceScope trace(key.level < 0 ? "viewer_overview" : "viewer_tile", key.path);
+	QImageReader reader(key.path);
+	QSize scaledSize;
+
+	if (key.level < 0) {
+		scaledSize = info.size;
+		if (scaledSize.width() > overviewSize.width() || scaledSize.height() > overviewSize.height()) {
+			scaledSize.scale(overviewSize, Qt::KeepAspectRatio);
+		}
+		reader.setAutoTransform(true);
+	}
+	else if (info.tiled) {
+		const int scale = 1 << key.level;
+		const int span = TILE_SIZE * scale;
+		const QRect source = QRect(key.x * span, key.y * span, span, span)
+			& QRect(QPoint(0, 0), info.size);
+		if (source.isEmpty()) {
+			return result;
+		}
+		reader.setAutoTransform(false);
+		reader.setClipRect(source);
+		scaledSize = QSize((source.width() + scale - 1) / scale, (source.height() + scale - 1) / scale);
+	}
+	else {
+		const int scale = 1 << key.level;
+		scaledSize = QSize((info.size.width() + scale - 1) / scale, (info.size.height() + scale - 1) / scale);
+		reader.setAutoTransform(true);
+	}
+
+	//    
+	if (info.rotated) {
+		scaledSize.transpose();
+	}
+	reader.setScaledSize(scaledSize.expandedTo(QSize(1, 1)));
+
+	result.image = reader.read();
+	if (result.image.isNull()) {
+		qDebug() << "Cannot decode" << key.path << "level" << key.level << ":" << reader.errorString();
+	}
+	return result;
+}
+
+void ImageViewer::showCurrent()
+{
+	//      ,  
+	m_generation.fetchAndAddOrdered(1);
+	for (auto it = m_pending.begin(); it != m_pending.end();) {
+		if (it->level >= 0)
+			it = m_pending.erase(it);
+		else
+			++it;
+	}
+
+	if (m_current < 0) {
+		m_info = ImageInfo();
+		m_info.rotated = false;
+		m_info.tiled = false;
+		update();
+		return;
+	}
+
+	m_info = readInfo(m_files[m_current]);
+	m_fit = true;
+	m_pan = QPointF();
+	m_zoom = fitZoom();
+
+	//  ,  
+	requestOverview(m_current);
+	requestOverview(m_current + 1);
+	requestOverview(m_current - 1);
+
+	updateTitle();
+	update();
+	emit currentChanged(m_current);
+}
+
+void ImageViewer::navigate(int delta)
+{
+	if (m_files.isEmpty()) return;
+
+	const int index = qBound(0, m_current + delta, m_files.size() - 1);
+	if (index == m_current) return;
+
+	m_current = index;
+	showCurrent();
+}
+
+void ImageViewer::updateTitle()
+{
+	if (m_current < 0) {
+		setWindowTitle("Viewer");
+		return;
+	}
+
+	setWindowTitle(QString("%1 - %2% (%3/%4)")
+		.arg(QFileInfo(m_files[m_current]).fileName())
+		.arg(qRound(m_zoom * 100))
+		.arg(m_current + 1)
+		.arg(m_files.size()));
+}
+
+double ImageViewer::fitZoom() const
+{
+	if (!m_info.size.isValid()) return 1.0;
+
+	const double zx = double(width()) / m_info.size.width();
+	const double zy = double(height()) / m_info.size.height();
+	return qMin(1.0, qMin(zx, zy));
+}
+
+//   ,      zoom
+int ImageViewer::levelFor(double zoom) const
+{
+	int level = 0;
+	while (level < 16 && (1 << (level + 1)) * zoom <= 1.0) {
+		++level;
+	}
+
+	//    -   MAX_WHOLE_PIXELS
+	if (!m_info.tiled) {
+		while (level < 16 && qint64(m_info.size.width() >> level) * (m_info.size.height() >> level) > MAX_WHOLE_PIXELS) {
+			++level;
+		}
+	}
+	return level;
+}
+
+QRectF ImageViewer::imageRect() const
+{
+	QRectF target(QPointF(0, 0), QSizeF(m_info.size) * m_zoom);
+	target.moveCenter(QRectF(rect()).center() + m_pan);
+	return target;
+}
+
+QSize ImageViewer::overviewSize() const
+{
+	return size().expandedTo(QSize(640, 480));
+}
+
+void ImageViewer::requestTile(const TileKey& key, const ImageInfo& info, bool cancellable)
+{
+	if (m_tiles.contains(key) || m_pending.contains(key)) {
+		return;
+	}
+	m_pending.insert(key);
+
+	auto watcher = new QFutureWatcher<TileResult>(this);
+	connect(watcher, &QFutureWatcher<TileResult>::finished, this, [this, watcher]() {
+		onTileDecoded(watcher->result());
+		watcher->deleteLater();
+	});
+
+	const int generation = cancellable ? m_generation.loadAcquire() : -1;
+	watcher->setFuture(QtConcurrent::run(&m_pool, &ImageViewer::decodeTile,
+		key, info, overviewSize(), generation, &m_generation));
+}
+
+void ImageViewer::requestOverview(int index)
+{
+	if (index < 0 || index >= m_files.size()) return;
+
+	const TileKey key = { m_files[index], -1, 0, 0 };
+	if (m_tiles.contains(key) || m_pending.contains(key)) {
+		return;
+	}
+
+	const ImageInfo info = index == m_current ? m_info : readInfo(m_files[index]);
+	if (info.size.isValid()) {
+		requestTile(key, info, false);
+	}
+}
+
+void ImageViewer::onTileDecoded(const TileResult& result)
+{
+	if (result.key.level < 0 || result.generation == m_generation.loadAcquire()) {
+		m_pending.remove(result.key);
+	}
+	if (result.image.isNull()) {
+		return;
+	}
+
+	const int cost = qMax(1, int(result.image.sizeInBytes() / 1024));
+	m_tiles.insert(result.key, new QImage(result.image), cost);
+
+	if (m_current >= 0 && result.key.path == m_files[m_current]) {
+		update();
+	}
+}
+
+void ImageViewer::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event);
+
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+
+	if (m_current < 0) return;
+
+	const QString &path = m_files[m_current];
+	if (!m_info.size.isValid()) {
+		painter.setPen(Qt::lightGray);
+		painter.drawText(rect(), Qt::AlignCenter,
+			QString("Cannot display\n%1").arg(QFileInfo(path).fileName()));
+		return;
+	}
+
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, m_zoom != 1.0);
+	const QRectF target = imageRect();
+
+	//   - ,   
+	const QImage *overview = m_tiles.object({ path, -1, 0, 0 });
+	double overviewZoom = 0.0;
+	if (overview) {
+		painter.drawImage(target, *overview);
+		overviewZoom = double(overview->width()) / m_info.size.width();
+	}
+	else {
+		requestOverview(m_current);
+	}
+
+	//   - 
+	if (overviewZoom >= m_zoom * 0.99) {
+		return;
+	}
+
+	const int level = levelFor(m_zoom);
+	if (!m_info.tiled) {
+		const TileKey key = { path, level, 0, 0 };
+		if (const QImage *whole = m_tiles.object(key))
+			painter.drawImage(target, *whole);
+		else
+			requestTile(key, m_info, true);
+		return;
+	}
+
+	//     
+	const QRectF visible = QRectF(rect()).intersected(target);
+	if (visible.isEmpty()) return;
+	const QRectF source((visible.topLeft() - target.topLeft()) / m_zoom, visible.size() / m_zoom);
+
+	const int span = TILE_SIZE << level;
+	const QRect bounds(QPoint(0, 0), m_info.size);
+	const int x0 = qMax(0, int(source.left()) / span);
+	const int y0 = qMax(0, int(source.top()) / span);
+	const int x1 = qMin((m_info.size.width() - 1) / span, int(std::ceil(source.right())) / span);
+	const int y1 = qMin((m_info.size.height() - 1) / span, int(std::ceil(source.bottom())) / span);
+
+	for (int ty = y0; ty <= y1; ++ty) {
+		for (int tx = x0; tx <= x1; ++tx) {
+			const TileKey key = { path, level, tx, ty };
+			const QImage *tile = m_tiles.object(key);
+			if (!tile) {
+				requestTile(key, m_info, true);
+				continue;
+			}
+
+			const QRect area = QRect(tx * span, ty * span, span, span) & bounds;
+			const QRectF destination(target.left() + area.x() * m_zoom, target.top() + area.y() * m_zoom,
+				area.width() * m_zoom, area.height() * m_zoom);
+			painter.drawImage(destination, *tile);
+		}
+	}
+}
+
+void ImageViewer::resizeEvent(QResizeEvent *event)
+{
+	QWidget::resizeEvent(event);
+
+	if (m_fit) {
+		m_zoom = fitZoom();
+		updateTitle();
+	}
+}
+
+void ImageViewer::zoomAt(const QPointF& pos, double zoom)
+{
+	zoom = qBound(fitZoom(), zoom, MAX_ZOOM);
+
+	//       
+	const QRectF target = imageRect();
+	const QPointF point = (pos - target.topLeft()) / m_zoom;
+	const QPointF topLeft = pos - point * zoom;
+
+	m_zoom = zoom;
+	m_fit = qFuzzyCompare(zoom, fitZoom());
+	m_pan = m_fit ? QPointF()
+		: topLeft + QPointF(m_info.size.width(), m_info.size.height()) * zoom / 2 - QRectF(rect()).center();
+
+	updateTitle();
+	update();
+}
+
+void ImageViewer::keyPressEvent(QKeyEvent *event)
+{
+	switch (event->key()) {
+	case Qt::Key_Left:
+	case Qt::Key_PageUp:
+	case Qt::Key_Backspace:
+		navigate(-1);
+		break;
+	case Qt::Key_Right:
+	case Qt::Key_PageDown:
+	case Qt::Key_Space:
+		navigate(1);
+		break;
+	case Qt::Key_Home:
+		navigate(-m_current);
+		break;
+	case Qt::Key_End:
+		navigate(m_files.size() - 1 - m_current);
+		break;
+	case Qt::Key_F:
+		zoomAt(QRectF(rect()).center(), fitZoom());
+		break;
+	case Qt::Key_1:
+		zoomAt(QRectF(rect()).center(), 1.0);
+		break;
+	case Qt::Key_Escape:
+		close();
+		break;
+	default:
+		QWidget::keyPressEvent(event);
+	}
+}
+
+void ImageViewer::wheelEvent(QWheelEvent *event)
+{
+	const double steps = event->angleDelta().y() / 120.0;
+	zoomAt(event->pos(), m_zoom * std::pow(1.25, steps));
+	event->accept();
+}
+
+void ImageViewer::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() == Qt::LeftButton) {
+		m_dragStart = event->pos();
+		m_panStart = m_pan;
+	}
+}
+
+void ImageViewer::mouseMoveEvent(QMouseEvent *event)
+{
+	if (!(event->buttons() & Qt::LeftButton) || m_fit) {
+		return;
+	}
+
+	m_pan = m_panStart + (event->pos() - m_dragStart);
+	update();
+}
+
+//  <-> 100%   
+void ImageViewer::mouseDoubleClickEvent(QMouseEvent *event)
+{
+	if (event->button() != Qt::LeftButton) {
+		return;
+	}
+
+	zoomAt(event->pos(), m_fit ? 1.0 : fitZoom());
+}
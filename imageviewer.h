@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QWidget>
+#include <QCache>
+#include <QSet>
+#include <QImage>
+#include <QStringList>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QPointF>
+
+//     .   
+//      (1/2^level)   
+// ;       .   
+//       -     
+//    ,     .
+class ImageViewer : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit ImageViewer(QWidget *parent = nullptr);
+	~ImageViewer();
+
+	//        
+	void setFiles(const QStringList& filePaths, int current);
+	int currentIndex() const { return m_current; }
+
+	//       
+	static bool canView(const QString& filePath);
+
+signals:
+	void currentChanged(int index);
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void keyPressEvent(QKeyEvent *event) override;
+	void wheelEvent(QWheelEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
+	void mouseMoveEvent(QMouseEvent *event) override;
+	void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+	struct TileKey
+	{
+		QString path;
+		int level;		// -1 -  
+		int x;
+		int y;
+
+		bool operator==(const TileKey& other) const
+		{
+			return level == other.level && x == other.x && y == other.y && path == other.path;
+		}
+	};
+	friend uint qHash(const TileKey& key, uint seed)
+	{
+		return ::qHash(key.path, seed) ^ uint(key.level * 73856093) ^ uint(key.x * 19349663) ^ uint(key.y * 83492791);
+	}
+
+	struct TileResult
+	{
+		TileKey key;
+		int generation;
+		QImage image;
+	};
+
+	//      
+	struct ImageInfo
+	{
+		QSize size;			//     EXIF
+		bool rotated;		//   90   EXIF
+		bool tiled;			//     (  )
+	};
+
+	QStringList m_files;
+	int m_current;
+	ImageInfo m_info;
+
+	// :  (    )   
+	double m_zoom;
+	bool m_fit;
+	QPointF m_pan;
+	QPoint m_dragStart;
+	QPointF m_panStart;
+
+	QCache<TileKey, QImage> m_tiles;	//  - 
+	QSet<TileKey> m_pending;			//   
+	QAtomicInt m_generation;		//     
+	QThreadPool m_pool;
+
+	static ImageInfo readInfo(const QString& filePath);
+	static TileResult decodeTile(TileKey key, ImageInfo info, QSize overviewSize,
+		int generation, const QAtomicInt *current);
+
+	void showCurrent();
+	void navigate(int delta);
+	void updateTitle();
+
+	double fitZoom() const;
+	int levelFor(double zoom) const;
+	QRectF imageRect() const;		//    
+	QSize overviewSize() const;
+	void zoomAt(const QPointF& pos, double zoom);
+
+	void requestTile(const TileKey& key, const ImageInfo& info, bool cancellable);
+	void requestOverview(int index);
+	void onTileDecoded(const TileResult& result);
+};
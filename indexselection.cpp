@@ -0,0 +1,226 @@
+#include "indexselection.h"
+#include <algorithm>
+#include <climits>
+
+int IndexSelection::lowerBound(int index) const
+{
+	int lo = 0;
+	int hi = m_runs.size();
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (m_runs[mid].last < index)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+void IndexSelection::recount()
+{
+	m_count = 0;
+	for (const Run &run : m_runs) {
+		m_count += run.last - run.first + 1;
+	}
+}
+
+bool IndexSelection::contains(int index) const
+{
+	const int i = lowerBound(index);
+	return i < m_runs.size() && m_runs[i].first <= index;
+}
+
+void IndexSelection::insertRange(int first, int last)
+{
+	if (first > last) return;
+
+	// ,     [first, last],   
+	int i = lowerBound(first - 1);
+	int j = i;
+	while (j < m_runs.size() && m_runs[j].first <= last + 1) {
+		first = qMin(first, m_runs[j].first);
+		last = qMax(last, m_runs[j].last);
+		m_count -= m_runs[j].last - m_runs[j].first + 1;
+		++j;
+	}
+
+	Run merged = { first, last };
+	if (j == i) {
+		m_runs.insert(i, merged);
+	}
+	else {
+		m_runs[i] = merged;
+		m_runs.remove(i + 1, j - i - 1);
+	}
+	m_count += last - first + 1;
+}
+
+void IndexSelection::removeRange(int first, int last)
+{
+	if (first > last) return;
+
+	int i = lowerBound(first);
+	if (i >= m_runs.size() || m_runs[i].first > last) return;
+
+	// ,   ,   
+	if (m_runs[i].first < first && m_runs[i].last > last) {
+		Run tail = { last + 1, m_runs[i].last };
+		m_runs[i].last = first - 1;
+		m_runs.insert(i + 1, tail);
+		m_count -= last - first + 1;
+		return;
+	}
+
+	//  
+	if (m_runs[i].first < first) {
+		m_count -= m_runs[i].last - first + 1;
+		m_runs[i].last = first - 1;
+		++i;
+	}
+
+	//  
+	int j = i;
+	while (j < m_runs.size() && m_runs[j].last <= last) {
+		m_count -= m_runs[j].last - m_runs[j].first + 1;
+		++j;
+	}
+	m_runs.remove(i, j - i);
+
+	//  
+	if (i < m_runs.size() && m_runs[i].first <= last) {
+		m_count -= last - m_runs[i].first + 1;
+		m_runs[i].first = last + 1;
+	}
+}
+
+void IndexSelection::invert(int size)
+{
+	QVector<Run> result;
+	result.reserve(m_runs.size() + 1);
+
+	int next = 0;
+	for (const Run &run : m_runs) {
+		if (run.first >= size) break;
+		if (run.first > next) {
+			result.append({ next, run.first - 1 });
+		}
+		next = run.last + 1;
+	}
+	if (next < size) {
+		result.append({ next, size - 1 });
+	}
+
+	m_runs = result;
+	recount();
+}
+
+//      
+IndexSelection IndexSelection::combine(const IndexSelection& a, const IndexSelection& b, Operation op)
+{
+	IndexSelection result;
+	int i = 0;
+	int j = 0;
+	int pos = INT_MIN;
+
+	auto take = [&result](int first, int last) {
+		if (first > last) return;
+		if (!result.m_runs.isEmpty() && result.m_runs.last().last + 1 >= first) {
+			result.m_runs.last().last = qMax(result.m_runs.last().last, last);
+		}
+		else {
+			result.m_runs.append({ first, last });
+		}
+	};
+
+	while (i < a.m_runs.size() || j < b.m_runs.size()) {
+		//   ,     
+		const int startA = i < a.m_runs.size() ? qMax(pos, a.m_runs[i].first) : INT_MAX;
+		const int startB = j < b.m_runs.size() ? qMax(pos, b.m_runs[j].first) : INT_MAX;
+		const int start = qMin(startA, startB);
+
+		const bool inA = i < a.m_runs.size() && a.m_runs[i].first <= start;
+		const bool inB = j < b.m_runs.size() && b.m_runs[j].first <= start;
+
+		int end = INT_MAX;
+		if (inA) end = qMin(end, a.m_runs[i].last);
+		else if (i < a.m_runs.size()) end = qMin(end, a.m_runs[i].first - 1);
+		if (inB) end = qMin(end, b.m_runs[j].last);
+		else if (j < b.m_runs.size()) end = qMin(end, b.m_runs[j].first - 1);
+
+		bool keep = false;
+		switch (op) {
+		case OpOr: keep = inA || inB; break;
+		case OpAnd: keep = inA && inB; break;
+		case OpAndNot: keep = inA && !inB; break;
+		case OpXor: keep = inA != inB; break;
+		}
+		if (keep) {
+			take(start, end);
+		}
+
+		if (inA && a.m_runs[i].last == end) ++i;
+		if (inB && b.m_runs[j].last == end) ++j;
+		if (end == INT_MAX) break;
+		pos = end + 1;
+	}
+
+	result.recount();
+	return result;
+}
+
+void IndexSelection::removeIndices(const QVector<int>& removed)
+{
+	if (removed.isEmpty() || m_runs.isEmpty()) return;
+
+	QVector<Run> result;
+	result.reserve(m_runs.size());
+
+	// k -     
+	int k = 0;
+	for (const Run &run : m_runs) {
+		while (k < removed.size() && removed[k] < run.first) ++k;
+		const int before = k;
+		while (k < removed.size() && removed[k] <= run.last) ++k;
+
+		//       
+		const int survivors = (run.last - run.first + 1) - (k - before);
+		if (survivors <= 0) continue;
+
+		const int first = run.first - before;
+		const int last = first + survivors - 1;
+		if (!result.isEmpty() && result.last().last + 1 >= first) {
+			result.last().last = last;
+		}
+		else {
+			result.append({ first, last });
+		}
+	}
+
+	m_runs = result;
+	recount();
+}
+
+QList<int> IndexSelection::toList() const
+{
+	QList<int> result;
+	result.reserve(m_count);
+	for (const Run &run : m_runs) {
+		for (int i = run.first; i <= run.last; ++i) {
+			result.append(i);
+		}
+	}
+	return result;
+}
+
+bool IndexSelection::operator==(const IndexSelection& other) const
+{
+	if (m_count != other.m_count || m_runs.size() != other.m_runs.size()) {
+		return false;
+	}
+	for (int i = 0; i < m_runs.size(); ++i) {
+		if (m_runs[i].first != other.m_runs[i].first || m_runs[i].last != other.m_runs[i].last) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QVector>
+#include <QList>
+#include <iterator>
+
+//      
+//  [first, last].  , ,  
+//    - O(),   O(); 
+//   -    .
+class IndexSelection
+{
+public:
+	struct Run
+	{
+		int first;
+		int last;
+	};
+
+	//      
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef int value_type;
+		typedef int difference_type;
+		typedef const int* pointer;
+		typedef const int& reference;
+
+		const_iterator(const QVector<Run>* runs, int run, int value)
+			: m_runs(runs), m_run(run), m_value(value) {}
+
+		const int& operator*() const { return m_value; }
+		const_iterator& operator++()
+		{
+			if (++m_value > (*m_runs)[m_run].last) {
+				++m_run;
+				m_value = m_run < m_runs->size() ? (*m_runs)[m_run].first : 0;
+			}
+			return *this;
+		}
+		bool operator==(const const_iterator& other) const { return m_run == other.m_run && m_value == other.m_value; }
+		bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+	private:
+		const QVector<Run>* m_runs;
+		int m_run;
+		int m_value;
+	};
+
+	IndexSelection() : m_count(0) {}
+
+	bool isEmpty() const { return m_runs.isEmpty(); }
+	int count() const { return m_count; }
+	int size() const { return m_count; }
+	bool contains(int index) const;
+	int first() const { return m_runs.isEmpty() ? -1 : m_runs.first().first; }
+	const QVector<Run>& runs() const { return m_runs; }
+
+	const_iterator begin() const { return const_iterator(&m_runs, 0, m_runs.isEmpty() ? 0 : m_runs.first().first); }
+	const_iterator end() const { return const_iterator(&m_runs, m_runs.size(), 0); }
+
+	void clear() { m_runs.clear(); m_count = 0; }
+	void insert(int index) { insertRange(index, index); }
+	void remove(int index) { removeRange(index, index); }
+	void insertRange(int first, int last);
+	void removeRange(int first, int last);
+
+	//    [0, size)
+	void invert(int size);
+
+	//     
+	IndexSelection operator|(const IndexSelection& other) const { return combine(*this, other, OpOr); }
+	IndexSelection operator&(const IndexSelection& other) const { return combine(*this, other, OpAnd); }
+	IndexSelection operator-(const IndexSelection& other) const { return combine(*this, other, OpAndNot); }
+	IndexSelection operator^(const IndexSelection& other) const { return combine(*this, other, OpXor); }
+
+	//     removed ( ): 
+	// ,     -  
+	void removeIndices(const QVector<int>& removed);
+
+	QList<int> toList() const;
+
+	bool operator==(const IndexSelection& other) const;
+	bool operator!=(const IndexSelection& other) const { return !(*this == other); }
+
+private:
+	enum Operation { OpOr, OpAnd, OpAndNot, OpXor };
+
+	QVector<Run> m_runs;
+	int m_count;
+
+	int lowerBound(int index) const;	//    last >= index
+	void recount();
+	static IndexSelection combine(const IndexSelection& a, const IndexSelection& b, Operation op);
+};
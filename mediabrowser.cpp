@@ -1,5 +1,9 @@
 #include "mediabrowser.h"
 #include "thumbnailloader.h"
+#include "imageviewer.h"
+#include "metadataloader.h"
+#include "perfpanel.h"
+#include "stallwatchdog.h"
 #include <QMenuBar>
 #include <QToolBar>
 #include <QStatusBar>
@@ -14,14 +18,27 @@
 #include <QMessageBox>
 #include <QGroupBox>
 #include <QDockWidget>
+#include <QApplication>
+#include <QInputDialog>
+#include <QActionGroup>
 
 MediaBrowser::MediaBrowser(QWidget *parent)
     : QMainWindow(parent)
 	, categoriesPanel(nullptr)
 	, tagsPanel(nullptr)
+	, imageViewer(nullptr)
+	, perfPanel(nullptr)
 	, previewArea(nullptr)
 	, thumbnailLoader(nullptr)
 	, loaderThread(nullptr)
+	, pendingTagRequest(-1)
+	, metadataLoader(nullptr)
+	, metadataThread(nullptr)
+	, metadataRequest(0)
+	, sortTimer(nullptr)
+	, stallWatchdog(nullptr)
+	, watchdogThread(nullptr)
+	, heartbeatTimer(nullptr)
 {
 	//  
 	cfg.loadSettings();
@@ -31,13 +48,44 @@ MediaBrowser::MediaBrowser(QWidget *parent)
 	if (!cfg.tagsPath.isEmpty()) {
 		tagManager->loadTags(cfg.tagsPath);
 	}
+	if (!cfg.tagsDbPath.isEmpty()) {
+		tagManager->openDatabase(cfg.tagsDbPath);
+	}
+	connect(tagManager, &TagManager::indexRebuilt, this, [this]() {
+		statusBar()->showMessage(QString("Tag index rebuilt: %1 tagged objects")
+			.arg(tagManager->index().objectCount()), 5000);
+	});
+	connect(tagManager, &TagManager::objectTagsReady,
+		this, &MediaBrowser::onObjectTagsReady);
+	connect(tagManager, &TagManager::tagOperationProgress, this, [this](int done, int total) {
+		statusBar()->showMessage(QString("Rewriting tags: %1 of %2 objects").arg(done).arg(total));
+	});
+	connect(tagManager, &TagManager::tagOperationFinished, this, [this](int changed, int failed) {
+		tagsPanel->setEnabled(true);
+		statusBar()->showMessage(failed == 0
+			? QString("Tags rewritten in %1 objects").arg(changed)
+			: QString("Tags rewritten in %1 objects, %2 failed (will retry on next start)")
+				.arg(changed).arg(failed), 5000);
+		updateTagsPanel();
+	});
+	tagManager->setIndexRoots({ cfg.sourceRoot, cfg.targetRoot });
 
 	//  UI 
 	initPreviewArea();
 	initSidebar();
 	initTagsbar();
+
+	perfPanel = new PerfPanel(this);
+	addDockWidget(Qt::BottomDockWidgetArea, perfPanel);
+	perfPanel->hide();
+
 	initMenu();
 	initGeometry();
+
+	//   / 
+	if (tagManager->resumeTagOperation()) {
+		tagsPanel->setEnabled(false);
+	}
 	
 	//      (  UI)
 	QTimer::singleShot(100, this, &MediaBrowser::loadNextUnprocessedFolder);
@@ -69,6 +117,19 @@ MediaBrowser::~MediaBrowser()
 		loaderThread->wait(1000);
 		delete loaderThread;
 	}
+
+	if (metadataThread) {
+		metadataLoader->setLatestRequest(-1);
+		metadataThread->quit();
+		metadataThread->wait(1000);
+		delete metadataThread;
+	}
+
+	if (watchdogThread) {
+		watchdogThread->quit();
+		watchdogThread->wait(1000);
+		delete watchdogThread;
+	}
 }
 
 void MediaBrowser::initPreviewArea()
@@ -76,18 +137,23 @@ void MediaBrowser::initPreviewArea()
 	//   
 	previewArea = new PreviewArea(this);
 	previewArea->setThumbnailSize(cfg.thumbnailSize);
+	previewArea->setLayoutMode(cfg.justifiedLayout ? PreviewArea::JustifiedLayout : PreviewArea::GridLayout);
 
 	//    
 	setCentralWidget(previewArea);
 	
 	//      
 	thumbnailLoader = new ThumbnailLoader(cfg.ffmpegPath, cfg.thumbnailSize);
+	thumbnailLoader->setReadAspectRatios(cfg.justifiedLayout);
 	loaderThread = new QThread();
+	loaderThread->setObjectName("ThumbnailLoader");
 	thumbnailLoader->moveToThread(loaderThread);
 
 	//     PreviewArea
 	connect(thumbnailLoader, &ThumbnailLoader::thumbnailLoaded,
 		previewArea, &PreviewArea::onThumbnailLoaded);
+	connect(thumbnailLoader, &ThumbnailLoader::aspectRatiosLoaded,
+		previewArea, &PreviewArea::onAspectRatiosLoaded);
 	connect(thumbnailLoader, &ThumbnailLoader::loadingFinished,
 		this, &MediaBrowser::onThumbnailsFinished);
 	connect(thumbnailLoader, &ThumbnailLoader::errorOccurred,
@@ -104,9 +170,58 @@ void MediaBrowser::initPreviewArea()
 		this, &MediaBrowser::onSelectionChanged);
 	connect(previewArea, &PreviewArea::selectionCleared,
 		this, &MediaBrowser::onSelectionCleared);
+	connect(previewArea, &PreviewArea::visibleRangeChanged,
+		this, &MediaBrowser::onVisibleRangeChanged);
+
+	//   - ,  cancelLoading: 
+	//          
+	connect(previewArea, &PreviewArea::decodeFocusChanged, this,
+		[this](const QVector<int>& indices, bool scrollingFast) {
+			thumbnailLoader->setDecodeFocus(indices, scrollingFast);
+		});
 
 	//   
 	loaderThread->start();
+
+	//    -   ,   
+	metadataLoader = new MetadataLoader(cfg.ffmpegPath, cfg.metadataCachePath);
+	metadataThread = new QThread();
+	metadataThread->setObjectName("MetadataLoader");
+	metadataLoader->moveToThread(metadataThread);
+	connect(metadataLoader, &MetadataLoader::metadataLoaded,
+		this, &MediaBrowser::onMetadataLoaded);
+	connect(metadataThread, &QThread::finished,
+		metadataLoader, &QObject::deleteLater);
+	metadataThread->start();
+
+	//   ,   ffmpeg -  
+	sortTimer = new QTimer(this);
+	sortTimer->setSingleShot(true);
+	sortTimer->setInterval(300);
+	connect(sortTimer, &QTimer::timeout, this, &MediaBrowser::applySortOrder);
+
+	//  :    GUI-   
+	if (cfg.stallThresholdMs > 0) {
+		StallWatchdog::attachGuiThread();
+		heartbeatTimer = new QTimer(this);
+		heartbeatTimer->setTimerType(Qt::PreciseTimer);
+		heartbeatTimer->setInterval(StallWatchdog::HEARTBEAT_INTERVAL);
+		connect(heartbeatTimer, &QTimer::timeout, this, &StallWatchdog::heartbeat);
+		heartbeatTimer->start();
+
+		stallWatchdog = new StallWatchdog(cfg.stallLogPath, cfg.stallThresholdMs);
+		watchdogThread = new QThread();
+		watchdogThread->setObjectName("StallWatchdog");
+		stallWatchdog->moveToThread(watchdogThread);
+		connect(watchdogThread, &QThread::started,
+			stallWatchdog, &StallWatchdog::start);
+		connect(watchdogThread, &QThread::finished,
+			stallWatchdog, &QObject::deleteLater);
+		connect(stallWatchdog, &StallWatchdog::stallDetected, this, [this](qint64 ms, const QString& operations) {
+			statusBar()->showMessage(QString("UI was unresponsive for %1 ms: %2").arg(ms).arg(operations), 5000);
+		});
+		watchdogThread->start();
+	}
 }
 
 void MediaBrowser::initSidebar()
@@ -122,6 +237,49 @@ void MediaBrowser::initSidebar()
 		this, &MediaBrowser::onMoveSelectedClicked);
 	connect(categoriesPanel, &CategoriesPanel::moveAllRequested,
 		this, &MediaBrowser::onMoveAllClicked);
+
+	//  :   ,   
+	connect(categoriesPanel, &CategoriesPanel::smartFolderSelected,
+		this, &MediaBrowser::loadSmartFolder);
+	connect(categoriesPanel, &CategoriesPanel::smartFolderCreated,
+		this, &MediaBrowser::onSmartFolderCreated);
+	connect(categoriesPanel, &CategoriesPanel::smartFolderRemoved, this, [this](const QString& name) {
+		tagManager->removeSmartFolder(name);
+	});
+	connect(tagManager, &TagManager::smartFoldersChanged,
+		this, &MediaBrowser::updateSmartFolders);
+	connect(tagManager, &TagManager::snapshotPublished,
+		this, &MediaBrowser::updateSmartFolders);
+	connect(tagManager, &TagManager::indexRebuilt,
+		this, &MediaBrowser::updateSmartFolders);
+	updateSmartFolders();
+}
+
+void MediaBrowser::updateSmartFolders()
+{
+	QList<QPair<QString, int>> folders;
+	for (const TagManager::SmartFolder &folder : tagManager->smartFolders()) {
+		folders.append(qMakePair(folder.name, tagManager->smartFolderCount(folder.name)));
+	}
+	categoriesPanel->setSmartFolders(folders);
+}
+
+void MediaBrowser::onSmartFolderCreated(const QString& name, const QString& expression)
+{
+	TagQuery query(expression);
+	if (!query.isValid()) {
+		QMessageBox::warning(this, "Error",
+			QString("Invalid tag query:\n%1").arg(query.errorString()));
+		return;
+	}
+
+	if (!tagManager->addSmartFolder(name, expression)) {
+		QMessageBox::warning(this, "Error",
+			QString("Smart folder '%1' already exists").arg(name));
+		return;
+	}
+
+	loadSmartFolder(name);
 }
 
 void MediaBrowser::initTagsbar()
@@ -136,6 +294,11 @@ void MediaBrowser::initTagsbar()
 		this, &MediaBrowser::onTagToggled);
 	connect(tagsPanel, &TagsPanel::addTagClicked,
 		this, &MediaBrowser::onAddTagClicked);
+
+	//       
+	tagsPanel->setUsageProvider([this](const QString& tag) {
+		return tagManager->index().tagCount(tag);
+	});
 }
 
 void MediaBrowser::initMenu()
@@ -184,6 +347,115 @@ void MediaBrowser::initMenu()
 	connect(quitAction, &QAction::triggered, this, &QWidget::close);
 
 
+	QMenu *tagsMenu = menuBar()->addMenu("&Tags");
+
+	QAction *filterAction = tagsMenu->addAction("&Filter view by tags...");
+	filterAction->setShortcut(QKeySequence("Ctrl+F"));
+	connect(filterAction, &QAction::triggered, this, [this]() {
+		bool ok = false;
+		QString expression = QInputDialog::getText(this, "Filter by Tags",
+			"Tag query (e.g. \"todo AND NOT reviewed\", empty shows all):",
+			QLineEdit::Normal, tagFilter, &ok).trimmed();
+		if (!ok) return;
+
+		TagQuery query(expression);
+		if (!expression.isEmpty() && !query.isValid()) {
+			QMessageBox::warning(this, "Error",
+				QString("Invalid tag query:\n%1").arg(query.errorString()));
+			return;
+		}
+
+		tagFilter = expression;
+		applyTagFilter();
+	});
+
+	QAction *clearFilterAction = tagsMenu->addAction("&Clear tag filter");
+	connect(clearFilterAction, &QAction::triggered, this, [this]() {
+		tagFilter.clear();
+		applyTagFilter();
+	});
+
+	tagsMenu->addSeparator();
+
+	QAction *rebuildIndexAction = tagsMenu->addAction("&Rebuild tag index");
+	connect(rebuildIndexAction, &QAction::triggered, this, [this]() {
+		tagManager->rebuildIndex();
+		statusBar()->showMessage("Rebuilding tag index...");
+	});
+
+	tagsMenu->addSeparator();
+
+	QAction *renameTagAction = tagsMenu->addAction("Re&name or merge tag...");
+	connect(renameTagAction, &QAction::triggered, this, [this]() {
+		QStringList tags = tagManager->getAllTags().values();
+		std::sort(tags.begin(), tags.end());
+		if (tags.isEmpty() || tagManager->isTagOperationRunning()) return;
+
+		bool ok = false;
+		QString oldName = QInputDialog::getItem(this, "Rename Tag", "Tag:", tags, 0, false, &ok);
+		if (!ok || oldName.isEmpty()) return;
+
+		//    -   
+		QString newName = QInputDialog::getItem(this, "Rename Tag",
+			QString("New name for '%1' (an existing tag merges them):").arg(oldName),
+			tags, tags.indexOf(oldName), true, &ok).trimmed();
+		if (!ok || newName.isEmpty() || newName == oldName) return;
+
+		if (tagManager->renameTag(oldName, newName)) {
+			tagsPanel->setEnabled(!tagManager->isTagOperationRunning());
+		}
+	});
+
+	QAction *deleteTagAction = tagsMenu->addAction("&Delete tag...");
+	connect(deleteTagAction, &QAction::triggered, this, [this]() {
+		QStringList tags = tagManager->getAllTags().values();
+		std::sort(tags.begin(), tags.end());
+		if (tags.isEmpty() || tagManager->isTagOperationRunning()) return;
+
+		bool ok = false;
+		QString tag = QInputDialog::getItem(this, "Delete Tag", "Tag:", tags, 0, false, &ok);
+		if (!ok || tag.isEmpty()) return;
+
+		QMessageBox::StandardButton reply = QMessageBox::question(this, "Delete Tag",
+			QString("Remove tag '%1' from all objects (%2 tagged)?")
+				.arg(tag).arg(tagManager->index().tagCount(tag)),
+			QMessageBox::Yes | QMessageBox::No);
+		if (reply != QMessageBox::Yes) return;
+
+		if (tagManager->deleteTag(tag)) {
+			tagsPanel->setEnabled(!tagManager->isTagOperationRunning());
+		}
+	});
+
+	tagsMenu->addSeparator();
+
+	QAction *importSidecarsAction = tagsMenu->addAction("&Import .tags files into database");
+	importSidecarsAction->setEnabled(tagManager->isDatabaseOpen());
+	connect(importSidecarsAction, &QAction::triggered, this, [this]() {
+		QMessageBox::StandardButton reply = QMessageBox::question(this, "Import Tags",
+			"Remove .tags files after importing them into the database?",
+			QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, QMessageBox::No);
+		if (reply == QMessageBox::Cancel) return;
+
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+		int count = tagManager->importSidecars(reply == QMessageBox::Yes);
+		QApplication::restoreOverrideCursor();
+
+		statusBar()->showMessage(QString("Imported tags of %1 objects").arg(count), 5000);
+		updateTagsPanel();
+	});
+
+	QAction *exportSidecarsAction = tagsMenu->addAction("&Export database to .tags files");
+	exportSidecarsAction->setEnabled(tagManager->isDatabaseOpen());
+	connect(exportSidecarsAction, &QAction::triggered, this, [this]() {
+		QApplication::setOverrideCursor(Qt::WaitCursor);
+		int count = tagManager->exportSidecars();
+		QApplication::restoreOverrideCursor();
+
+		statusBar()->showMessage(QString("Exported tags of %1 objects").arg(count), 5000);
+	});
+
+
 	QMenu *viewMenu = menuBar()->addMenu("&View");
 
 	QAction *showCategoriesAction = viewMenu->addAction("Show &categories panel");
@@ -192,6 +464,59 @@ void MediaBrowser::initMenu()
 	connect(showCategoriesAction, &QAction::toggled,
 		categoriesPanel, &QDockWidget::setVisible);
 
+	QAction *justifiedAction = viewMenu->addAction("&Justified rows");
+	justifiedAction->setCheckable(true);
+	justifiedAction->setChecked(cfg.justifiedLayout);
+	connect(justifiedAction, &QAction::toggled, this, [this](bool checked) {
+		cfg.justifiedLayout = checked;
+		thumbnailLoader->setReadAspectRatios(checked);
+		previewArea->setLayoutMode(checked ? PreviewArea::JustifiedLayout : PreviewArea::GridLayout);
+	});
+
+	QAction *showPerfAction = perfPanel->toggleViewAction();
+	showPerfAction->setText("Show &performance panel");
+	viewMenu->addAction(showPerfAction);
+
+	viewMenu->addSeparator();
+	QMenu *sortMenu = viewMenu->addMenu("&Sort by");
+	QActionGroup *sortGroup = new QActionGroup(this);
+	const QList<QPair<QString, int>> sortFields = {
+		{ "&Name", MetadataColumns::Name },
+		{ "&Date taken", MetadataColumns::DateTaken },
+		{ "&Size", MetadataColumns::FileSize },
+		{ "D&uration", MetadataColumns::Duration },
+		{ "&Resolution", MetadataColumns::Resolution },
+		{ "&Type", MetadataColumns::Type }
+	};
+	for (const auto &field : sortFields) {
+		QAction *action = sortMenu->addAction(field.first);
+		action->setCheckable(true);
+		action->setChecked(cfg.sortField == field.second);
+		sortGroup->addAction(action);
+		const int value = field.second;
+		connect(action, &QAction::triggered, this, [this, value]() {
+			cfg.sortField = value;
+			applySortOrder();
+		});
+	}
+	sortMenu->addSeparator();
+
+	QAction *descendingAction = sortMenu->addAction("D&escending");
+	descendingAction->setCheckable(true);
+	descendingAction->setChecked(cfg.sortDescending);
+	connect(descendingAction, &QAction::toggled, this, [this](bool checked) {
+		cfg.sortDescending = checked;
+		applySortOrder();
+	});
+
+	QAction *groupAction = viewMenu->addAction("&Group by sort key");
+	groupAction->setCheckable(true);
+	groupAction->setChecked(cfg.groupBySort);
+	connect(groupAction, &QAction::toggled, this, [this](bool checked) {
+		cfg.groupBySort = checked;
+		applySortOrder();
+	});
+
 
 	QMenu *helpMenu = menuBar()->addMenu("&Help");
 
@@ -233,6 +558,8 @@ void MediaBrowser::initGeometry()
 
 void MediaBrowser::loadFolderThumbnails(const QString& folderPath)
 {
+	StallScope stall("load_folder", folderPath);
+
 	//   ,  
 	if (thumbnailLoader) {
 		thumbnailLoader->cancelLoading();
@@ -240,6 +567,7 @@ void MediaBrowser::loadFolderThumbnails(const QString& folderPath)
 	}
 
 	currentFolder = folderPath;
+	currentSmartFolder.clear();
 	setWindowTitle("Media Browser - " + folderPath);
 		
 	//     
@@ -257,6 +585,9 @@ void MediaBrowser::loadFolderThumbnails(const QString& folderPath)
 	QStringList allFilters = imageFilters + videoFilters;
 	currentFiles = dir.entryList(allFilters, QDir::Files, QDir::Name).toVector();
 
+	//       
+	tagManager->prefetchDirectory(folderPath);
+
 	//    PreviewArea
 	previewArea->clearThumbnails();
 	previewArea->setTotalCount(currentFiles.size());
@@ -265,11 +596,14 @@ void MediaBrowser::loadFolderThumbnails(const QString& folderPath)
 	for (int i = 0; i < currentFiles.size(); ++i) {
 		previewArea->setFilename(i, currentFiles[i]);
 	}
+	applyTagFilter();
 
 	//  -   
 	statusLoading = QString("Loading %1 files...").arg(currentFiles.size());
 	updateStatusBar();
 
+	requestMetadata();
+
 	//   
 	if (thumbnailLoader) {
 		QMetaObject::invokeMethod(thumbnailLoader, "loadThumbnails",
@@ -278,8 +612,163 @@ void MediaBrowser::loadFolderThumbnails(const QString& folderPath)
 	}
 }
 
+void MediaBrowser::loadSmartFolder(const QString& name)
+{
+	StallScope stall("load_smart_folder", name);
+
+	//     , loadFileList   -
+	//   GUI-  
+	if (thumbnailLoader) {
+		thumbnailLoader->cancelLoading();
+	}
+
+	//    :  currentFiles  , 
+	// (    )    
+	QStringList filePaths;
+	for (const QString &path : tagManager->smartFolderObjects(name)) {
+		if (QFileInfo(path).isFile()) {
+			filePaths.append(path);
+		}
+	}
+	std::sort(filePaths.begin(), filePaths.end());
+
+	currentFolder.clear();
+	currentSmartFolder = name;
+	currentFiles = filePaths.toVector();
+	selectedFileIndices.clear();
+	setWindowTitle("Media Browser - [" + name + "]");
+
+	tagManager->prefetchObjectTags(filePaths);
+
+	previewArea->clearThumbnails();
+	previewArea->setTotalCount(currentFiles.size());
+	for (int i = 0; i < currentFiles.size(); ++i) {
+		previewArea->setFilename(i, QFileInfo(currentFiles[i]).fileName());
+	}
+	applyTagFilter();
+
+	statusLoading = QString("Loading %1 files...").arg(currentFiles.size());
+	updateStatusBar();
+	updateTagsPanel();
+	requestMetadata();
+
+	if (thumbnailLoader) {
+		QMetaObject::invokeMethod(thumbnailLoader, "loadFileList",
+			Qt::QueuedConnection,
+			Q_ARG(QStringList, filePaths));
+	}
+}
+
+//     ;   .
+//  resetColumns   -    
+void MediaBrowser::requestMetadata(bool resetColumns)
+{
+	if (resetColumns) {
+		currentMetadata.reset(currentFiles);
+		applySortOrder();
+	}
+	if (!metadataLoader) return;
+
+	const QDir folder(currentFolder);
+	QStringList paths;
+	paths.reserve(currentFiles.size());
+	for (const QString &file : currentFiles) {
+		paths.append(folder.absoluteFilePath(file));
+	}
 
-void MediaBrowser::onSelectionChanged(const QSet<int>& selectedIndices)
+	const int requestId = ++metadataRequest;
+	metadataLoader->setLatestRequest(requestId);
+	QMetaObject::invokeMethod(metadataLoader, "loadMetadata",
+		Qt::QueuedConnection,
+		Q_ARG(int, requestId),
+		Q_ARG(QStringList, paths));
+}
+
+void MediaBrowser::onMetadataLoaded(int requestId, int first, const QVector<MediaMetadata>& metadata)
+{
+	//        
+	if (requestId != metadataRequest || first + metadata.size() > currentMetadata.size()) {
+		return;
+	}
+
+	TraceScope trace("metadata_batch", QString::number(metadata.size()));
+	//        -   
+	//    
+	QVector<float> ratios(metadata.size(), 0.0f);
+	for (int i = 0; i < metadata.size(); ++i) {
+		currentMetadata.set(first + i, metadata[i]);
+		if (metadata[i].width > 0 && metadata[i].height > 0) {
+			ratios[i] = float(metadata[i].width) / metadata[i].height;
+		}
+	}
+	previewArea->onAspectRatiosLoaded(first, ratios);
+
+	//    -    ,   
+	//  ( ,      ffmpeg, )
+	if (cfg.sortField != MetadataColumns::Name && cfg.sortField != MetadataColumns::Type
+		&& !sortTimer->isActive()) {
+		sortTimer->start();
+	}
+
+	const int selected = selectedFileIndices.size() == 1 ? selectedFileIndices.first() : -1;
+	if (selected >= first && selected < first + metadata.size()) {
+		updateStatusBar();
+	}
+}
+
+//       .   
+//  -       
+void MediaBrowser::applySortOrder()
+{
+	sortTimer->stop();
+	const MetadataColumns::Field field = MetadataColumns::Field(cfg.sortField);
+
+	if (field == MetadataColumns::Name && !cfg.sortDescending && !cfg.groupBySort) {
+		previewArea->setOrder(QVector<int>());
+		return;
+	}
+
+	QVector<int> groupOf;
+	QStringList groupNames;
+	if (cfg.groupBySort) {
+		currentMetadata.groups(field, groupOf, groupNames);
+	}
+	previewArea->setOrder(currentMetadata.sortedOrder(field, cfg.sortDescending), groupOf, groupNames);
+}
+
+void MediaBrowser::applyTagFilter()
+{
+	if (tagFilter.isEmpty()) {
+		if (previewArea->isFiltered()) {
+			previewArea->clearFilter();
+			if (!selectedFileIndices.isEmpty()) {
+				updateTagsPanel();
+			}
+		}
+		return;
+	}
+
+	//    :     
+	StallScope stall("tag_filter", tagFilter);
+	QDir dir(currentFolder);
+	QStringList filePaths;
+	filePaths.reserve(currentFiles.size());
+	for (const QString &file : currentFiles) {
+		filePaths.append(dir.absoluteFilePath(file));
+	}
+	PerfTimer queryTimer(PerfStats::TagQuery);
+	const QVector<quint64> mask = tagManager->matchObjects(tagFilter, filePaths);
+	queryTimer.stop();
+	previewArea->setFilter(mask);
+	if (!selectedFileIndices.isEmpty()) {
+		updateTagsPanel();		//  -    
+	}
+
+	statusBar()->showMessage(QString("Filter '%1': %2 of %3 files")
+		.arg(tagFilter).arg(previewArea->getVisibleCount()).arg(currentFiles.size()), 5000);
+}
+
+void MediaBrowser::onSelectionChanged(const IndexSelection& selectedIndices)
 {
 	//       
 	selectedFileIndices = selectedIndices;
@@ -299,39 +788,93 @@ void MediaBrowser::onSelectionCleared()
 
 void MediaBrowser::updateTagsPanel()
 {
-	if (selectedFileIndices.isEmpty()) {
+	StallScope stall("update_tags_panel");
+	const IndexSelection selected = previewArea->getShownSelection();
+
+	if (selected.isEmpty()) {
 		//     -    
-		QSet<QString> folderTags = tagManager->getObjectTags(currentFolder);
-		tagsPanel->setObjectTags(folderTags);
-		tagsPanel->setObjectName(QFileInfo(currentFolder).fileName());
-	}
-	else if (selectedFileIndices.size() == 1) {
-		//    
-		int index = *selectedFileIndices.begin();
-		if (index < currentFiles.size()) {
-			QString filePath = QDir(currentFolder).absoluteFilePath(currentFiles[index]);
-			QSet<QString> fileTags = tagManager->getObjectTags(filePath);
-			tagsPanel->setObjectTags(fileTags);
-			tagsPanel->setObjectName(currentFiles[index]);
+		pendingTagRequest = -1;
+		QSet<QString> folderTags;
+		if (!currentFolder.isEmpty()) {
+			folderTags = tagManager->getObjectTags(currentFolder);
 		}
+		tagsPanel->setLoading(false);
+		tagsPanel->setObjectTags(folderTags);
+		tagsPanel->setSuggestedTags(tagManager->suggestTags(folderTags, 8));
+		tagsPanel->setObjectName(currentFolder.isEmpty()
+			? currentSmartFolder : QFileInfo(currentFolder).fileName());
 	}
 	else {
-		//     -  
-		QSet<QString> allFileTags;
-		for (int index : selectedFileIndices) {
+		QDir dir(currentFolder);
+		QStringList filePaths;
+		for (int index : selected) {
 			if (index < currentFiles.size()) {
-				QString filePath = QDir(currentFolder).absoluteFilePath(currentFiles[index]);
-				allFileTags.unite(tagManager->getObjectTags(filePath));
+				filePaths.append(dir.absoluteFilePath(currentFiles[index]));
 			}
 		}
-		tagsPanel->setObjectTags(allFileTags);
-		tagsPanel->setObjectName(QString("%1 files").arg(selectedFileIndices.size()));
+
+		//     -   ,  id :
+		//    - ,   -  
+		const TagDictionary &dictionary = tagManager->dictionary();
+		TagCounts counts(dictionary.size());
+		bool complete = true;
+		for (const QString &filePath : filePaths) {
+			TagSet fileTags;
+			if (!tagManager->cachedObjectTags(filePath, fileTags)) {
+				complete = false;
+				break;
+			}
+			counts.add(fileTags);
+		}
+
+		if (!complete) {
+			//    ,    objectTagsReady
+			pendingTagRequest = tagManager->requestObjectTags(filePaths);
+			tagsPanel->setLoading(true);
+			return;
+		}
+
+		pendingTagRequest = -1;
+		tagsPanel->setLoading(false);
+		const QSet<QString> commonTags = dictionary.toStrings(counts.common());
+		tagsPanel->setObjectTags(commonTags, dictionary.toStrings(counts.partial()));
+		tagsPanel->setSuggestedTags(tagManager->suggestTags(commonTags, 8));
+		if (selected.size() == 1) {
+			int index = *selected.begin();
+			tagsPanel->setObjectName(index < currentFiles.size() ? currentFiles[index] : QString());
+		}
+		else {
+			tagsPanel->setObjectName(QString("%1 files").arg(selected.size()));
+		}
 	}
 
 	//    
 	tagsPanel->setAllTags(tagManager->getAllTags());
 }
 
+void MediaBrowser::onObjectTagsReady(int requestId)
+{
+	//     -   
+	if (requestId != pendingTagRequest) {
+		return;
+	}
+	updateTagsPanel();
+}
+
+void MediaBrowser::onVisibleRangeChanged(int first, int last)
+{
+	//     ,   
+	QDir dir(currentFolder);
+	QStringList filePaths;
+	for (int i = qMax(0, first); i <= last && i < previewArea->getVisibleCount(); ++i) {
+		const int index = previewArea->itemAt(i);
+		if (index < currentFiles.size()) {
+			filePaths.append(dir.absoluteFilePath(currentFiles[index]));
+		}
+	}
+	tagManager->prefetchObjectTags(filePaths);
+}
+
 void MediaBrowser::onThumbnailsFinished()
 {
 	statusLoading = "Loading finished";
@@ -384,7 +927,41 @@ void MediaBrowser::openFile(int index)
 
 	qDebug() << "Opening file:" << filePath;
 
-	//    
+	//  -   ,    
+	if (ImageViewer::canView(filePath)) {
+		const QDir folder(currentFolder);
+		QStringList paths;
+		int current = -1;
+		const int count = previewArea->getVisibleCount();
+		paths.reserve(count);
+		for (int position = 0; position < count; ++position) {
+			const int item = previewArea->itemAt(position);
+			const QString path = folder.absoluteFilePath(currentFiles[item]);
+			//       -    
+			if (item != index && !ImageViewer::canView(path)) {
+				continue;
+			}
+			if (item == index) {
+				current = paths.size();
+			}
+			paths.append(path);
+		}
+		if (current < 0) {
+			paths = QStringList{ filePath };
+			current = 0;
+		}
+
+		if (!imageViewer) {
+			imageViewer = new ImageViewer(this);
+		}
+		imageViewer->setFiles(paths, current);
+		imageViewer->show();
+		imageViewer->raise();
+		imageViewer->activateWindow();
+		return;
+	}
+
+	//    
 	bool success = QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
 
 	if (!success) {
@@ -417,12 +994,17 @@ void MediaBrowser::keyPressEvent(QKeyEvent *event)
 
 	// Ctrl+A -  
 	if (event->key() == Qt::Key_A && event->modifiers() == Qt::ControlModifier) {
-		if (previewArea && previewArea->getTotalCount() > 0) {
-			QSet<int> allIndices;
-			for (int i = 0; i < previewArea->getTotalCount(); ++i) {
-				allIndices.insert(i);
-			}
-			previewArea->setSelection(allIndices);
+		if (previewArea && previewArea->getVisibleCount() > 0) {
+			previewArea->selectAll();
+		}
+		event->accept();
+		return;
+	}
+
+	// Ctrl+I -  
+	if (event->key() == Qt::Key_I && event->modifiers() == Qt::ControlModifier) {
+		if (previewArea && previewArea->getVisibleCount() > 0) {
+			previewArea->invertSelection();
 		}
 		event->accept();
 		return;
@@ -475,12 +1057,13 @@ void MediaBrowser::loadNextUnprocessedFolder()
 //      
 void MediaBrowser::onMoveSelectedClicked(const QString& targetCategory)
 {
-	if (selectedFileIndices.isEmpty()) {
+	const IndexSelection selected = previewArea->getShownSelection();
+	if (selected.isEmpty()) {
 		QMessageBox::warning(this, "Error", "No files selected");
 		return;
 	}
 
-	if (currentFolder.isEmpty()) {
+	if (currentFolder.isEmpty() && currentSmartFolder.isEmpty()) {
 		QMessageBox::warning(this, "Error", "No current folder");
 		return;
 	}
@@ -509,6 +1092,7 @@ void MediaBrowser::onMoveAllClicked(const QString& targetCategory)
 //      
 void MediaBrowser::moveSelectedFiles(const QString& targetCategory, const SelectedFilesInfo& selectedInfo)
 {
+	StallScope stall("move_files", targetCategory);
 	qDebug() << "Moving selected files to:" << targetCategory;
 
 	if (selectedInfo.isEmpty()) {
@@ -530,16 +1114,27 @@ void MediaBrowser::moveSelectedFiles(const QString& targetCategory, const Select
 	QDir sourceDir(currentFolder);
 	QList<int> successfullyMovedIndices;
 
+	//      (sidecar    ) 
+	// .     :  
+	// ,     
+	QVector<QPair<QString, QString>> movedPaths;
+	auto flushMovedTags = [this, &movedPaths]() {
+		tagManager->objectsMoved(movedPaths);
+		movedPaths.clear();
+	};
+
 	for (int i = 0; i < selectedInfo.filenames.size(); ++i) {
 		const QString& filename = selectedInfo.filenames[i];
 		int index = selectedInfo.indices[i];
+		//    filename -  ,      
 		QString sourcePath = sourceDir.absoluteFilePath(filename);
-		QString targetPath = targetDir.absoluteFilePath(filename);
+		QString targetPath = targetDir.absoluteFilePath(QFileInfo(filename).fileName());
 
 		// ,       
 		if (QFile::exists(targetPath)) {
+			flushMovedTags();
 			int result = QMessageBox::question(this, "Confirm Overwrite",
-				QString("File '%1' already exists in target folder.\nOverwrite?").arg(filename),
+				QString("File '%1' already exists in target folder.\nOverwrite?").arg(QFileInfo(filename).fileName()),
 				QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
 
 			if (result == QMessageBox::No) {
@@ -552,23 +1147,23 @@ void MediaBrowser::moveSelectedFiles(const QString& targetCategory, const Select
 		}
 
 		//  
-		if (QFile::rename(sourcePath, targetPath)) {
+		PerfTimer moveTimer(PerfStats::FileMove, sourcePath);
+		const bool moved = QFile::rename(sourcePath, targetPath);
+		moveTimer.stop();
+		if (moved) {
 			movedCount++;
 			successfullyMovedIndices.append(index);
-
-			//   .tags    
-			QString tagsSourcePath = sourcePath + ".tags";
-			QString tagsTargetPath = targetPath + ".tags";
-			if (QFile::exists(tagsSourcePath)) {
-				QFile::rename(tagsSourcePath, tagsTargetPath);
-			}
+			movedPaths.append(qMakePair(sourcePath, targetPath));
 		}
 		else {
 			failedCount++;
+			PerfStats::add(PerfStats::FileOpFailed);
+			flushMovedTags();
 			QMessageBox::warning(this, "Error",
 				QString("Failed to move file:\n%1").arg(filename));
 		}
 	}
+	flushMovedTags();
 
 	//    
 	//  GUI   
@@ -580,6 +1175,7 @@ void MediaBrowser::moveSelectedFiles(const QString& targetCategory, const Select
 
 void MediaBrowser::deleteSelectedFiles(const SelectedFilesInfo& selectedInfo)
 {
+	StallScope stall("delete_files");
 	qDebug() << "Deleting files:" << selectedInfo.filenames;
 
 	if (selectedInfo.isEmpty()) return;
@@ -588,6 +1184,7 @@ void MediaBrowser::deleteSelectedFiles(const SelectedFilesInfo& selectedInfo)
 	int failedCount = 0;
 	QDir sourceDir(currentFolder);
 	QList<int> successfullyDeletedIndices;
+	QStringList deletedPaths;
 
 	for (int i = 0; i < selectedInfo.filenames.size(); ++i) {
 		const QString& filename = selectedInfo.filenames[i];
@@ -595,24 +1192,26 @@ void MediaBrowser::deleteSelectedFiles(const SelectedFilesInfo& selectedInfo)
 		QString filePath = sourceDir.absoluteFilePath(filename);
 
 		//  
-		if (QFile::remove(filePath)) {
+		PerfTimer deleteTimer(PerfStats::FileDelete, filePath);
+		const bool deleted = QFile::remove(filePath);
+		deleteTimer.stop();
+		if (deleted) {
 			deletedCount++;
 			successfullyDeletedIndices.append(index);
-
-			//  .tags    
-			QString tagsPath = filePath + ".tags";
-			if (QFile::exists(tagsPath)) {
-				QFile::remove(tagsPath);
-			}
+			deletedPaths.append(filePath);
 
 			qDebug() << "Deleted:" << filename;
 		}
 		else {
 			failedCount++;
+			PerfStats::add(PerfStats::FileOpFailed);
 			qDebug() << "Failed to delete:" << filename;
 		}
 	}
 
+	//    -  
+	tagManager->objectsRemoved(deletedPaths);
+
 	//    
 	//  GUI   
 	updateAfterFileOperation(successfullyDeletedIndices,
@@ -631,6 +1230,9 @@ void MediaBrowser::reloadCurrentFolder()
 	if (!currentFolder.isEmpty()) {
 		loadFolderThumbnails(currentFolder);
 	}
+	else if (!currentSmartFolder.isEmpty()) {
+		loadSmartFolder(currentSmartFolder);
+	}
 
 	//  
 	updateTagsPanel();
@@ -668,11 +1270,13 @@ void MediaBrowser::moveCurrentFolder(const QString& targetCategory)
 
 		//  ,   
 		//@ todo !
+		StallScope stall("delete_folder", targetPath);
 		if (!QDir(targetPath).removeRecursively()) {
 			QMessageBox::warning(this, "Error",
 				QString("Failed to remove existing folder:\n%1").arg(targetPath));
 			return;
 		}
+		tagManager->objectRemoved(targetPath);
 	}
 
 	//  
@@ -680,12 +1284,8 @@ void MediaBrowser::moveCurrentFolder(const QString& targetCategory)
 	if (dir.rename(currentFolder, targetPath)) {
 		statusBar()->showMessage(QString("Folder moved to: %1").arg(targetPath), 5000);
 
-		//      
-		QString tagsSourcePath = currentFolder + ".tags";
-		QString tagsTargetPath = targetPath + ".tags";
-		if (QFile::exists(tagsSourcePath)) {
-			QFile::rename(tagsSourcePath, tagsTargetPath);
-		}
+		//      
+		tagManager->objectMoved(currentFolder, targetPath);
 
 		//   
 		loadNextUnprocessedFolder();
@@ -708,6 +1308,7 @@ void MediaBrowser::onSelectSourceRoot()
 	if (!folder.isEmpty()) {
 		cfg.sourceRoot = folder;
 		cfg.saveSettings();
+		tagManager->setIndexRoots({ cfg.sourceRoot, cfg.targetRoot });
 		loadNextUnprocessedFolder(); //     
 	}
 }
@@ -725,6 +1326,7 @@ void MediaBrowser::onSelectTargetRoot()
 	if (!folder.isEmpty()) {
 		cfg.targetRoot = folder;
 		cfg.saveSettings();
+		tagManager->setIndexRoots({ cfg.sourceRoot, cfg.targetRoot });
 		categoriesPanel->setTargetRoot(folder);  //   
 	}
 }
@@ -732,12 +1334,9 @@ void MediaBrowser::onSelectTargetRoot()
 //   
 void MediaBrowser::onTagToggled(const QString& tag, bool checked)
 {
-	Q_UNUSED(tag);
-	Q_UNUSED(checked);
-
 	//    (,    )
-	//   
-	updateObjectTags(tagsPanel->getSelectedTags());
+	//    
+	updateObjectTags(tag, checked);
 }
 
 //   
@@ -748,38 +1347,52 @@ void MediaBrowser::onAddTagClicked(const QString& newTag)
 	//     
 	tagManager->addGlobalTag(newTag);
 
-	//   
-	QSet<QString> currentTags = tagsPanel->getSelectedTags();
-	currentTags.insert(newTag);
-
-	// 
-	updateObjectTags(currentTags);
+	//     
+	updateObjectTags(newTag, true);
 
 	//   
 	tagsPanel->clearInput();
 }
 
-//   
-void MediaBrowser::updateObjectTags(const QSet<QString>& newTags)
+// /      .
+//     .
+void MediaBrowser::updateObjectTags(const QString& tag, bool checked)
 {
-	if (selectedFileIndices.isEmpty()) {
+	const IndexSelection selected = previewArea->getShownSelection();
+	QStringList objectPaths;
+	if (selected.isEmpty()) {
 		//   
 		if (!currentFolder.isEmpty()) {
-			tagManager->setObjectTags(currentFolder, newTags);
+			objectPaths.append(currentFolder);
 		}
 	}
 	else {
 		//   
-		for (int index : selectedFileIndices) {
+		QDir dir(currentFolder);
+		for (int index : selected) {
 			if (index < currentFiles.size()) {
-				QString filePath = QDir(currentFolder).absoluteFilePath(currentFiles[index]);
-				tagManager->setObjectTags(filePath, newTags);
+				objectPaths.append(dir.absoluteFilePath(currentFiles[index]));
 			}
 		}
 	}
 
-	//    
-	tagsPanel->setAllTags(tagManager->getAllTags());
+	//   ,      -  
+	TagMap changes;
+	for (const QString &objectPath : objectPaths) {
+		QSet<QString> tags = tagManager->getObjectTags(objectPath);
+		if (tags.contains(tag) == checked) {
+			continue;
+		}
+		if (checked)
+			tags.insert(tag);
+		else
+			tags.remove(tag);
+		changes.insert(objectPath, tags);
+	}
+	tagManager->applyTagChanges(changes);
+
+	//    (   )
+	updateTagsPanel();
 }
 
 void MediaBrowser::onMoveSelectedToCustomFolder()
@@ -789,7 +1402,7 @@ void MediaBrowser::onMoveSelectedToCustomFolder()
 	if (!checkSelectedFiles())
 		return;
 
-	if (currentFolder.isEmpty()) {
+	if (currentFolder.isEmpty() && currentSmartFolder.isEmpty()) {
 		QMessageBox::warning(this, "Error", "No current folder");
 		return;
 	}
@@ -922,10 +1535,12 @@ void MediaBrowser::deleteFolder(const QString& folderPath)
 	QString folderName = dir.dirName();
 
 	//    
+	StallScope stall("delete_folder", folderPath);
 	bool success = dir.removeRecursively();
 
 	if (success) {
 		statusBar()->showMessage(QString("Deleted folder: %1").arg(folderPath), 5000);
+		tagManager->objectRemoved(folderPath);
 
 		//   
 		loadNextUnprocessedFolder();
@@ -938,6 +1553,31 @@ void MediaBrowser::deleteFolder(const QString& folderPath)
 	}
 }
 
+// " | 4000x3000, 2023-05-01 12:00, 01:02, h264, 5000 kb/s" -  
+static QString describeMetadata(const MediaMetadata& meta)
+{
+	QStringList parts;
+	if (meta.width > 0 && meta.height > 0) {
+		parts << QString("%1x%2").arg(meta.width).arg(meta.height);
+	}
+	if (meta.captured.isValid()) {
+		parts << meta.captured.toString("yyyy-MM-dd HH:mm");
+	}
+	if (meta.durationMs > 0) {
+		const qint64 seconds = meta.durationMs / 1000;
+		parts << (seconds >= 3600
+			? QString("%1:%2:%3").arg(seconds / 3600).arg(seconds / 60 % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'))
+			: QString("%1:%2").arg(seconds / 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0')));
+	}
+	if (!meta.codec.isEmpty()) {
+		parts << meta.codec;
+	}
+	if (meta.bitrate > 0) {
+		parts << QString("%1 kb/s").arg(meta.bitrate);
+	}
+	return parts.isEmpty() ? QString() : " | " + parts.join(", ");
+}
+
 void MediaBrowser::updateStatusBar()
 {
 	if (!statusBar()) return;
@@ -962,9 +1602,20 @@ void MediaBrowser::updateStatusBar()
 			statusText += QString(", %1 other").arg(otherFiles);
 		}
 	}
+	else if (!currentSmartFolder.isEmpty()) {
+		statusText += QString(" Smart folder '%1' | %2 media").arg(currentSmartFolder).arg(currentFiles.size());
+	}
 
 	// 2.   
-	if (!selectedFileIndices.isEmpty()) {
+	if (selectedFileIndices.size() == 1) {
+		statusText += QString(" | Selected: %1").arg(currentFiles.value(selectedFileIndices.first()));
+		const int index = selectedFileIndices.first();
+		const MediaMetadata meta = currentMetadata.at(index);
+		if (meta.isValid()) {
+			statusText += describeMetadata(meta);
+		}
+	}
+	else if (!selectedFileIndices.isEmpty()) {
 		statusText += QString(" | Selected: %1 files").arg(selectedFileIndices.size());
 	}
 	else {
@@ -984,6 +1635,7 @@ void MediaBrowser::updateStatusBar()
 //     
 int MediaBrowser::getTotalFilesCount(const QString& folderPath)
 {
+	StallScope stall("count_files", folderPath);
 	QDir dir(folderPath);
 	dir.setFilter(QDir::Files | QDir::NoDotAndDotDot);
 	return dir.entryList().count();
@@ -991,6 +1643,7 @@ int MediaBrowser::getTotalFilesCount(const QString& folderPath)
 
 int MediaBrowser::getTotalFoldersCount(const QString& folderPath)
 {
+	StallScope stall("count_folders", folderPath);
 	QDir dir(folderPath);
 	dir.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
 	return dir.entryList().count();
@@ -1010,19 +1663,20 @@ void MediaBrowser::updateAfterFileOperation(const QList<int>& successfullyProces
 		return;
 	}
 
-	//          
-	// (  getSelectedFilesInfo)
+	//     currentFiles -  
+	const QVector<int> removed = sortedRemovalIndices(successfullyProcessedIndices, currentFiles.size());
+	currentMetadata.removeIndices(removed);
+	removeSortedIndices(currentFiles, removed);
 
-	//     currentFiles
-	for (int index : successfullyProcessedIndices) {
-		if (index >= 0 && index < currentFiles.size()) {
-			currentFiles.removeAt(index);
-		}
-	}
-
-	//  PreviewArea
+	//  PreviewArea (     )
 	previewArea->removeFiles(successfullyProcessedIndices);
 
+	//        - 
+	// (    )
+	if (currentMetadata.loadedCount() < currentMetadata.size()) {
+		requestMetadata(false);
+	}
+
 	//  
 	selectedFileIndices.clear();
 	previewArea->clearSelection();
@@ -1047,7 +1701,8 @@ void MediaBrowser::updateAfterFileOperation(const QList<int>& successfullyProces
 
 bool MediaBrowser::checkSelectedFiles() const
 {
-	if (!selectedFileIndices.isEmpty()) {
+	const IndexSelection selected = previewArea->getShownSelection();
+	if (!selected.isEmpty()) {
 		return true;
 	}
 	QMessageBox::warning(const_cast<MediaBrowser*>(this), "Error", "No files selected");
@@ -1110,21 +1765,24 @@ bool MediaBrowser::confirmFolderDeletion(const QString& folderPath, int fileCoun
 	return true;
 }
 
+//     ,   (,
+// , )   
 SelectedFilesInfo MediaBrowser::getSelectedFilesInfo() const
 {
+	const IndexSelection selected = previewArea->getShownSelection();
 	SelectedFilesInfo info;
 
-	if (selectedFileIndices.isEmpty() || currentFolder.isEmpty()) {
+	if (selected.isEmpty() || (currentFolder.isEmpty() && currentSmartFolder.isEmpty())) {
 		return info;
 	}
 
-	//       (  )
-	info.indices = selectedFileIndices.values();
-	std::sort(info.indices.begin(), info.indices.end(), std::greater<int>());
-
-	//       
-	for (int index : info.indices) {
-		if (index >= 0 && index < currentFiles.size()) {
+	//    -     (  )
+	const QVector<IndexSelection::Run> &runs = selected.runs();
+	info.indices.reserve(selected.count());
+	info.filenames.reserve(selected.count());
+	for (int r = runs.size() - 1; r >= 0; --r) {
+		for (int index = qMin(runs[r].last, currentFiles.size() - 1); index >= runs[r].first; --index) {
+			info.indices.append(index);
 			info.filenames.append(currentFiles[index]);
 		}
 	}
@@ -16,15 +16,20 @@
 #include <QLabel>
 #include <QTreeWidget>
 #include <QPushButton>
+#include <QTimer>
 #include "Settings.h"
-#include "ThumbnailWidget.h"
 #include "previewarea.h"
 #include "categoriespanel.h"
 #include "tagspanel.h"
 #include "tagmanager.h"
+#include "metadatacolumns.h"
 #include "utils.h"
 
 class ThumbnailLoader;
+class MetadataLoader;
+class ImageViewer;
+class PerfPanel;
+class StallWatchdog;
 
 class MediaBrowser : public QMainWindow
 {
@@ -43,12 +48,17 @@ private slots:
 	void onThumbnailLoaderError(const QString& error);
 	void onThumbnailClicked(int index, Qt::KeyboardModifiers modifiers);
 	void onThumbnailDoubleClicked(int index);
-	void onSelectionChanged(const QSet<int>& selectedIndices);
+	void onSelectionChanged(const IndexSelection& selectedIndices);
 	void onSelectionCleared();
+	void onVisibleRangeChanged(int first, int last);
+	void onObjectTagsReady(int requestId);
+	void onMetadataLoaded(int requestId, int first, const QVector<MediaMetadata>& metadata);
 
 	//   
 	void onMoveSelectedClicked(const QString& targetCategory);
 	void onMoveAllClicked(const QString& targetCategory);
+	void onSmartFolderCreated(const QString& name, const QString& expression);
+	void updateSmartFolders();
 	
 	//   
 	void onTagToggled(const QString& tag, bool checked);
@@ -77,11 +87,15 @@ private:
 	QString findNextUnprocessedDir();
 	void loadNextUnprocessedFolder();
 	void loadFolderThumbnails(const QString& folderPath);
+	void loadSmartFolder(const QString& name);
+	void applyTagFilter();
 	void openFile(int index);
 	void updateTagsPanel();
-	void updateObjectTags(const QSet<QString>& newTags);
+	void updateObjectTags(const QString& tag, bool checked);
 	
 	void reloadCurrentFolder();
+	void requestMetadata(bool resetColumns = true);
+	void applySortOrder();
 	void updateStatusBar();
 	int getTotalFilesCount(const QString& folderPath);
 	int getTotalFoldersCount(const QString& folderPath);
@@ -105,17 +119,34 @@ private:
 	PreviewArea *previewArea;
 	CategoriesPanel *categoriesPanel;
 	TagsPanel *tagsPanel;
+	ImageViewer *imageViewer;		//    
+	PerfPanel *perfPanel;			//   ()
 
 	//  
 	TagManager *tagManager;
 
 	//   
 	QString currentFolder;          //   
+	QString currentSmartFolder;     //    (currentFolder )
 	QVector<QString> currentFiles;  //    
-	QSet<int> selectedFileIndices;	//  
+	IndexSelection selectedFileIndices;	//  
+	int pendingTagRequest;			//     
+	QString tagFilter;				//    ( - )
 	
 	 //  
 	ThumbnailLoader *thumbnailLoader;
 	QThread *loaderThread;
 	QString statusLoading;
+
+	//    (   currentFiles)
+	MetadataLoader *metadataLoader;
+	QThread *metadataThread;
+	int metadataRequest;
+	MetadataColumns currentMetadata;
+	QTimer *sortTimer;				//    
+
+	//   GUI- ( ,    )
+	StallWatchdog *stallWatchdog;
+	QThread *watchdogThread;
+	QTimer *heartbeatTimer;
 };
@@ -0,0 +1,468 @@
+#include "mediametadata.h"
+#include "tracer.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QImageReader>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QDebug>
+#include <cstring>
+
+static const quint32 METADATA_STREAM_VERSION = 1;
+static const int EXIF_SEARCH_BYTES = 128 * 1024;		// APP1   
+static const qint64 MAX_MOOV_BYTES = 64 * 1024 * 1024;
+static const int FFMPEG_BATCH_FILES = 64;
+static const int FFMPEG_BATCH_CHARS = 24000;			//    Windows - 32K
+
+QDataStream& operator<<(QDataStream& out, const MediaMetadata& meta)
+{
+	out << METADATA_STREAM_VERSION << meta.fileSize << meta.modified << meta.captured
+		<< qint32(meta.width) << qint32(meta.height) << meta.durationMs << meta.codec << qint32(meta.bitrate);
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, MediaMetadata& meta)
+{
+	quint32 version = 0;
+	qint32 width = 0;
+	qint32 height = 0;
+	qint32 bitrate = 0;
+	in >> version;
+	if (version != METADATA_STREAM_VERSION) {
+		in.setStatus(QDataStream::ReadCorruptData);
+		return in;
+	}
+	in >> meta.fileSize >> meta.modified >> meta.captured
+		>> width >> height >> meta.durationMs >> meta.codec >> bitrate;
+	meta.width = width;
+	meta.height = height;
+	meta.bitrate = bitrate;
+	return in;
+}
+
+namespace
+{
+	quint16 read16(const uchar *p, bool littleEndian)
+	{
+		return littleEndian ? quint16(p[0] | (p[1] << 8)) : quint16((p[0] << 8) | p[1]);
+	}
+
+	quint32 read32(const uchar *p, bool littleEndian)
+	{
+		return littleEndian
+			? quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24)
+			: (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+	}
+
+	quint64 read64(const uchar *p)
+	{
+		return (quint64(read32(p, false)) << 32) | read32(p + 4, false);
+	}
+
+	// EXIF (TIFF  APP1): DateTimeOriginal,  DateTime
+	class ExifParser
+	{
+	public:
+		ExifParser(const uchar *tiff, int size) : m_tiff(tiff), m_size(size), m_littleEndian(false) {}
+
+		QDateTime captured()
+		{
+			if (m_size < 8) return QDateTime();
+			if (m_tiff[0] == 'I' && m_tiff[1] == 'I') m_littleEndian = true;
+			else if (m_tiff[0] != 'M' || m_tiff[1] != 'M') return QDateTime();
+
+			const quint32 ifd0 = read32(m_tiff + 4, m_littleEndian);
+			QString dateTime = asciiTag(ifd0, 0x0132);
+
+			const quint32 exifIfd = valueTag(ifd0, 0x8769);
+			if (exifIfd) {
+				const QString original = asciiTag(exifIfd, 0x9003);
+				if (!original.isEmpty()) {
+					dateTime = original;
+				}
+			}
+			return QDateTime::fromString(dateTime.trimmed(), "yyyy:MM:dd HH:mm:ss");
+		}
+
+	private:
+		const uchar *m_tiff;
+		int m_size;
+		bool m_littleEndian;
+
+		//    IFD  nullptr
+		const uchar *findEntry(quint32 ifd, quint16 tag) const
+		{
+			if (ifd == 0 || qint64(ifd) + 2 > m_size) return nullptr;
+			const int count = read16(m_tiff + ifd, m_littleEndian);
+			for (int i = 0; i < count; ++i) {
+				const qint64 entry = qint64(ifd) + 2 + i * 12;
+				if (entry + 12 > m_size) return nullptr;
+				if (read16(m_tiff + entry, m_littleEndian) == tag) {
+					return m_tiff + entry;
+				}
+			}
+			return nullptr;
+		}
+
+		quint32 valueTag(quint32 ifd, quint16 tag) const
+		{
+			const uchar *entry = findEntry(ifd, tag);
+			return entry ? read32(entry + 8, m_littleEndian) : 0;
+		}
+
+		QString asciiTag(quint32 ifd, quint16 tag) const
+		{
+			const uchar *entry = findEntry(ifd, tag);
+			if (!entry || read16(entry + 2, m_littleEndian) != 2) return QString();
+
+			const quint32 count = read32(entry + 4, m_littleEndian);
+			const uchar *value = entry + 8;
+			if (count > 4) {
+				const quint32 offset = read32(entry + 8, m_littleEndian);
+				if (qint64(offset) + count > m_size) return QString();
+				value = m_tiff + offset;
+			}
+			return QString::fromLatin1(reinterpret_cast<const char*>(value), int(qstrnlen(reinterpret_cast<const char*>(value), count)));
+		}
+	};
+
+	QDateTime readExifDate(const QString& filePath)
+	{
+		QFile file(filePath);
+		if (!file.open(QIODevice::ReadOnly)) return QDateTime();
+
+		const QByteArray data = file.read(EXIF_SEARCH_BYTES);
+		const uchar *d = reinterpret_cast<const uchar*>(data.constData());
+		const int size = data.size();
+		if (size < 4 || d[0] != 0xFF || d[1] != 0xD8) return QDateTime();
+
+		//  JPEG    
+		int pos = 2;
+		while (pos + 4 <= size && d[pos] == 0xFF) {
+			const uchar marker = d[pos + 1];
+			if (marker == 0xDA || marker == 0xD9) break;
+
+			const int length = (d[pos + 2] << 8) | d[pos + 3];
+			if (marker == 0xE1 && length >= 16 && pos + 2 + length <= size
+				&& std::memcmp(d + pos + 4, "Exif\0\0", 6) == 0) {
+				return ExifParser(d + pos + 10, length - 8).captured();
+			}
+			pos += 2 + length;
+		}
+		return QDateTime();
+	}
+
+	//  MP4:    [begin, end)
+	struct Mp4Box
+	{
+		QByteArray type;
+		int content;	//  
+		int end;
+	};
+
+	QVector<Mp4Box> childBoxes(const QByteArray& data, int begin, int end)
+	{
+		QVector<Mp4Box> boxes;
+		const uchar *d = reinterpret_cast<const uchar*>(data.constData());
+		int pos = begin;
+		while (pos + 8 <= end) {
+			qint64 size = read32(d + pos, false);
+			int header = 8;
+			if (size == 1) {
+				if (pos + 16 > end) break;
+				size = qint64(read64(d + pos + 8));
+				header = 16;
+			}
+			else if (size == 0) {
+				size = end - pos;
+			}
+			if (size < header || pos + size > end) break;
+
+			boxes.append({ data.mid(pos + 4, 4), pos + header, int(pos + size) });
+			pos += int(size);
+		}
+		return boxes;
+	}
+
+	const Mp4Box *findBox(const QVector<Mp4Box>& boxes, const char *type)
+	{
+		for (const Mp4Box &box : boxes) {
+			if (box.type == type) return &box;
+		}
+		return nullptr;
+	}
+
+	QString codecName(const QByteArray& fourcc)
+	{
+		if (fourcc == "avc1" || fourcc == "avc3") return "h264";
+		if (fourcc == "hvc1" || fourcc == "hev1") return "hevc";
+		if (fourcc == "mp4v") return "mpeg4";
+		if (fourcc == "av01") return "av1";
+		if (fourcc == "vp09") return "vp9";
+		return QString::fromLatin1(fourcc).trimmed();
+	}
+
+	// moov   ;   - 
+	QByteArray readMoov(QFile& file)
+	{
+		const qint64 fileSize = file.size();
+		qint64 pos = 0;
+		while (pos + 8 <= fileSize) {
+			if (!file.seek(pos)) break;
+			const QByteArray header = file.read(16);
+			if (header.size() < 8) break;
+
+			const uchar *h = reinterpret_cast<const uchar*>(header.constData());
+			qint64 size = read32(h, false);
+			int headerSize = 8;
+			if (size == 1) {
+				if (header.size() < 16) break;
+				size = qint64(read64(h + 8));
+				headerSize = 16;
+			}
+			else if (size == 0) {
+				size = fileSize - pos;
+			}
+			if (size < headerSize) break;
+
+			if (header.mid(4, 4) == "moov") {
+				if (size - headerSize > MAX_MOOV_BYTES) break;
+				file.seek(pos + headerSize);
+				return file.read(size - headerSize);
+			}
+			pos += size;
+		}
+		return QByteArray();
+	}
+}
+
+bool MetadataExtractor::isMp4Family(const QString& suffix)
+{
+	static const QStringList suffixes = { "mp4", "mov", "m4v", "3gp" };
+	return suffixes.contains(suffix, Qt::CaseInsensitive);
+}
+
+bool MetadataExtractor::isVideo(const QString& suffix)
+{
+	static const QStringList suffixes = { "mp4", "avi", "mkv", "mov", "wmv",
+		"flv", "m4v", "mpg", "mpeg", "3gp" };
+	return suffixes.contains(suffix, Qt::CaseInsensitive);
+}
+
+bool MetadataExtractor::readImage(const QString& filePath, MediaMetadata& meta)
+{
+	QImageReader reader(filePath);
+	QSize size = reader.size();
+	if (!size.isValid()) {
+		return false;
+	}
+	if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+		size.transpose();
+	}
+
+	meta.width = size.width();
+	meta.height = size.height();
+	meta.codec = QString::fromLatin1(reader.format());
+	if (reader.format() == "jpeg") {
+		meta.captured = readExifDate(filePath);
+	}
+	return true;
+}
+
+bool MetadataExtractor::readMp4(const QString& filePath, MediaMetadata& meta)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	const QByteArray moov = readMoov(file);
+	if (moov.isEmpty()) {
+		return false;
+	}
+	const uchar *d = reinterpret_cast<const uchar*>(moov.constData());
+	const QVector<Mp4Box> boxes = childBoxes(moov, 0, moov.size());
+
+	// mvhd:   (  1904 , UTC)  
+	if (const Mp4Box *mvhd = findBox(boxes, "mvhd")) {
+		const int c = mvhd->content;
+		const bool v1 = c < mvhd->end && d[c] == 1;
+		if (c + (v1 ? 32 : 20) <= mvhd->end) {
+			const quint64 created = v1 ? read64(d + c + 4) : read32(d + c + 4, false);
+			const quint32 timescale = read32(d + c + (v1 ? 20 : 12), false);
+			const quint64 duration = v1 ? read64(d + c + 24) : read32(d + c + 16, false);
+			if (created > 0) {
+				meta.captured = QDateTime(QDate(1904, 1, 1), QTime(0, 0), Qt::UTC)
+					.addSecs(qint64(created)).toLocalTime();
+			}
+			if (timescale > 0) {
+				meta.durationMs = qint64(duration * 1000 / timescale);
+			}
+		}
+	}
+
+	//  :     tkhd,   stsd
+	for (const Mp4Box &trak : boxes) {
+		if (trak.type != "trak") continue;
+
+		const QVector<Mp4Box> trakBoxes = childBoxes(moov, trak.content, trak.end);
+		const Mp4Box *mdia = findBox(trakBoxes, "mdia");
+		const Mp4Box *tkhd = findBox(trakBoxes, "tkhd");
+		if (!mdia || !tkhd) continue;
+
+		const QVector<Mp4Box> mdiaBoxes = childBoxes(moov, mdia->content, mdia->end);
+		const Mp4Box *hdlr = findBox(mdiaBoxes, "hdlr");
+		if (!hdlr || hdlr->content + 12 > hdlr->end || moov.mid(hdlr->content + 8, 4) != "vide") continue;
+
+		if (tkhd->end - tkhd->content >= 84) {
+			meta.width = int(read32(d + tkhd->end - 8, false) >> 16);
+			meta.height = int(read32(d + tkhd->end - 4, false) >> 16);
+
+			//  : a = d = 0 -   90/270
+			const int matrix = tkhd->content + (d[tkhd->content] == 1 ? 52 : 40);
+			if (matrix + 36 <= tkhd->end && read32(d + matrix, false) == 0 && read32(d + matrix + 16, false) == 0) {
+				qSwap(meta.width, meta.height);
+			}
+		}
+
+		if (const Mp4Box *minf = findBox(mdiaBoxes, "minf")) {
+			const QVector<Mp4Box> minfBoxes = childBoxes(moov, minf->content, minf->end);
+			if (const Mp4Box *stbl = findBox(minfBoxes, "stbl")) {
+				const QVector<Mp4Box> stblBoxes = childBoxes(moov, stbl->content, stbl->end);
+				const Mp4Box *stsd = findBox(stblBoxes, "stsd");
+				if (stsd && stsd->content + 16 <= stsd->end) {
+					meta.codec = codecName(moov.mid(stsd->content + 12, 4));
+				}
+			}
+		}
+		break;
+	}
+
+	if (meta.durationMs > 0) {
+		meta.bitrate = int(file.size() * 8 / meta.durationMs);	// / = /
+	}
+	return meta.durationMs > 0 || meta.width > 0;
+}
+
+// ffmpeg       ("Input #N ...");
+//       -  
+//     
+QVector<MediaMetadata> MetadataExtractor::readWithFFmpeg(const QString& ffmpegPath, const QStringList& filePaths,
+	const std::function<bool()>& cancelled, QVector<bool> *described)
+{
+	QVector<MediaMetadata> result(filePaths.size());
+	QVector<bool> inputDescribed(filePaths.size(), false);
+
+	QFileInfo ffmpegInfo(ffmpegPath);
+	if (!ffmpegInfo.exists() || !ffmpegInfo.isFile()) {
+		qDebug() << "FFmpeg not found:" << ffmpegPath;
+		if (described) {
+			described->clear();
+		}
+		return QVector<MediaMetadata>();
+	}
+
+	static const QRegularExpression inputRe("^Input #(\\d+),");
+	static const QRegularExpression durationRe("Duration: (\\d+):(\\d+):(\\d+(?:\\.\\d+)?)");
+	static const QRegularExpression bitrateRe("bitrate: (\\d+) kb/s");
+	static const QRegularExpression creationRe("creation_time\\s*:\\s*(\\S+)");
+	static const QRegularExpression videoRe("Stream #\\d+:\\d+.*: Video: (\\w+)(.*)$");
+	static const QRegularExpression sizeRe(", (\\d{2,5})x(\\d{2,5})");
+	static const QRegularExpression rotateRe("(?:rotate\\s*:\\s*|rotation of )(-?\\d+)");
+
+	int start = 0;
+	while (start < filePaths.size()) {
+		if (cancelled && cancelled()) {
+			break;
+		}
+
+		QStringList args;
+		args << "-hide_banner" << "-nostdin";
+		int end = start;
+		int length = 0;
+		while (end < filePaths.size() && (end == start
+			|| (end - start < FFMPEG_BATCH_FILES && length + filePaths[end].size() < FFMPEG_BATCH_CHARS))) {
+			args << "-i" << QDir::toNativeSeparators(filePaths[end]);
+			length += filePaths[end].size() + 6;
+			++end;
+		}
+
+		//    ffmpeg    -  
+		QProcess ffmpeg;
+		TraceProcess trace("ffmpeg_probe", QString("%1 files").arg(end - start));
+		ffmpeg.start(ffmpegPath, args);
+		//  -     ,  
+		if (!ffmpeg.waitForStarted(2000)) {
+			qDebug() << "Failed to start FFmpeg:" << ffmpegPath;
+			break;
+		}
+		trace.started(ffmpeg);
+		if (!ffmpeg.waitForFinished(30000)) {
+			ffmpeg.kill();
+			qDebug() << "FFmpeg timeout while reading metadata";
+			break;
+		}
+
+		const QStringList lines = QString::fromLocal8Bit(ffmpeg.readAllStandardError()).split('\n');
+		int current = -1;
+		int parsed = 0;
+		bool rotated = false;
+		auto finishInput = [&]() {
+			if (current >= 0 && rotated) {
+				qSwap(result[start + current].width, result[start + current].height);
+			}
+			rotated = false;
+		};
+
+		for (const QString &line : lines) {
+			QRegularExpressionMatch match = inputRe.match(line);
+			if (match.hasMatch()) {
+				finishInput();
+				current = match.captured(1).toInt();
+				if (current >= end - start) {
+					current = -1;
+					continue;
+				}
+				parsed = qMax(parsed, current + 1);
+				inputDescribed[start + current] = true;
+				continue;
+			}
+			if (current < 0) continue;
+
+			MediaMetadata &meta = result[start + current];
+			if ((match = durationRe.match(line)).hasMatch()) {
+				meta.durationMs = qint64((match.captured(1).toInt() * 3600 + match.captured(2).toInt() * 60
+					+ match.captured(3).toDouble()) * 1000);
+				if ((match = bitrateRe.match(line)).hasMatch()) {
+					meta.bitrate = match.captured(1).toInt();
+				}
+			}
+			else if (!meta.captured.isValid() && (match = creationRe.match(line)).hasMatch()) {
+				meta.captured = QDateTime::fromString(match.captured(1), Qt::ISODateWithMs).toLocalTime();
+			}
+			else if (meta.codec.isEmpty() && (match = videoRe.match(line)).hasMatch()) {
+				meta.codec = match.captured(1);
+				const QRegularExpressionMatch size = sizeRe.match(match.captured(2));
+				if (size.hasMatch()) {
+					meta.width = size.captured(1).toInt();
+					meta.height = size.captured(2).toInt();
+				}
+			}
+			else if ((match = rotateRe.match(line)).hasMatch()) {
+				rotated = qAbs(match.captured(1).toInt()) % 180 == 90;
+			}
+		}
+		finishInput();
+
+		//   
+		start += parsed < end - start ? parsed + 1 : parsed;
+	}
+
+	result.resize(start);
+	if (described) {
+		inputDescribed.resize(start);
+		*described = inputDescribed;
+	}
+	return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QVector>
+#include <QDataStream>
+#include <QMetaType>
+#include <functional>
+
+//      (  )
+struct MediaMetadata
+{
+	//  :  ,       
+	qint64 fileSize = -1;
+	qint64 modified = 0;		//   
+
+	QDateTime captured;			//   (EXIF,  )
+	int width = 0;				//   
+	int height = 0;
+	qint64 durationMs = 0;		// 
+	QString codec;				// : h264, hevc, ...; : 
+	int bitrate = 0;			// /
+
+	bool isValid() const { return fileSize >= 0; }
+	bool matches(qint64 size, qint64 mtime) const { return fileSize == size && modified == mtime; }
+};
+Q_DECLARE_METATYPE(MediaMetadata)
+
+QDataStream& operator<<(QDataStream& out, const MediaMetadata& meta);
+QDataStream& operator>>(QDataStream& in, MediaMetadata& meta);
+
+//  . ,    ,  
+namespace MetadataExtractor
+{
+	// JPEG (EXIF:  , )     Qt
+	bool readImage(const QString& filePath, MediaMetadata& meta);
+
+	// MP4/MOV/M4V/3GP:   moov   
+	bool readMp4(const QString& filePath, MediaMetadata& meta);
+
+	//  :   ffmpeg   -i   ,
+	//     .  -   ;
+	// cancelled   .     ffmpeg
+	//  ; described[i] - ffmpeg   i (
+	//   )
+	QVector<MediaMetadata> readWithFFmpeg(const QString& ffmpegPath, const QStringList& filePaths,
+		const std::function<bool()>& cancelled = std::function<bool()>(),
+		QVector<bool> *described = nullptr);
+
+	bool isMp4Family(const QString& suffix);
+	bool isVideo(const QString& suffix);
+}
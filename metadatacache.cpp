@@ -0,0 +1,93 @@
+#include "metadatacache.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+
+static const quint32 CACHE_MAGIC = 0x4D424D43;	// "MBMC"
+static const quint32 CACHE_VERSION = 1;
+
+MetadataCache::MetadataCache()
+	: m_dirty(false)
+{
+}
+
+bool MetadataCache::load(const QString& cachePath)
+{
+	m_cachePath = cachePath;
+	m_entries.clear();
+	m_dirty = false;
+
+	QFile file(cachePath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		qDebug() << "Cannot open metadata cache:" << cachePath << file.errorString();
+		return false;
+	}
+
+	QDataStream in(&file);
+	quint32 magic = 0;
+	quint32 version = 0;
+	in >> magic >> version;
+	if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+		qDebug() << "Metadata cache has unknown format:" << cachePath;
+		return false;
+	}
+
+	in >> m_entries;
+	if (in.status() != QDataStream::Ok) {
+		qDebug() << "Metadata cache is corrupted:" << cachePath;
+		m_entries.clear();
+		return false;
+	}
+
+	qDebug() << "Loaded metadata cache:" << m_entries.size() << "files";
+	return true;
+}
+
+bool MetadataCache::save()
+{
+	if (m_cachePath.isEmpty()) {
+		return false;
+	}
+
+	QSaveFile file(m_cachePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot save metadata cache:" << m_cachePath << file.errorString();
+		return false;
+	}
+
+	QDataStream out(&file);
+	out << CACHE_MAGIC << CACHE_VERSION;
+	out << m_entries;
+
+	if (!file.commit()) {
+		qDebug() << "Cannot commit metadata cache:" << m_cachePath << file.errorString();
+		return false;
+	}
+
+	m_dirty = false;
+	return true;
+}
+
+bool MetadataCache::lookup(const QString& path, qint64 size, qint64 modified, MediaMetadata& meta) const
+{
+	auto it = m_entries.constFind(path);
+	if (it == m_entries.constEnd() || !it.value().matches(size, modified)) {
+		return false;
+	}
+	meta = it.value();
+	return true;
+}
+
+void MetadataCache::insert(const QString& path, const MediaMetadata& meta)
+{
+	m_entries.insert(path, meta);
+	m_dirty = true;
+}
+
+void MetadataCache::remove(const QString& path)
+{
+	if (m_entries.remove(path) > 0) {
+		m_dirty = true;
+	}
+}
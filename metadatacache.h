@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include "mediametadata.h"
+
+//      :  -> .  ,
+//          ( )
+class MetadataCache
+{
+public:
+	MetadataCache();
+
+	bool load(const QString& cachePath);
+	bool save();
+	bool isDirty() const { return m_dirty; }
+
+	//          
+	bool lookup(const QString& path, qint64 size, qint64 modified, MediaMetadata& meta) const;
+	void insert(const QString& path, const MediaMetadata& meta);
+	void remove(const QString& path);
+
+	int size() const { return m_entries.size(); }
+
+private:
+	QString m_cachePath;
+	QHash<QString, MediaMetadata> m_entries;
+	bool m_dirty;
+};
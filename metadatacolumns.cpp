@@ -0,0 +1,327 @@
+#include "metadatacolumns.h"
+#include "utils.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <limits>
+#include <algorithm>
+
+static const qint64 UNKNOWN_DATE = std::numeric_limits<qint64>::min();
+static const quint64 UNKNOWN_KEY = std::numeric_limits<quint64>::max();
+
+namespace
+{
+	//    (LSD,  )  -.
+	//  ,        - 
+	//       
+	void radixSort(QVector<quint64>& keys, QVector<int>& values)
+	{
+		const int count = keys.size();
+		if (count < 2) return;
+
+		QVector<int> histogram(8 * 256, 0);
+		for (quint64 key : keys) {
+			for (int b = 0; b < 8; ++b) {
+				++histogram[b * 256 + int((key >> (8 * b)) & 0xFF)];
+			}
+		}
+
+		QVector<quint64> keyBuffer(count);
+		QVector<int> valueBuffer(count);
+		for (int b = 0; b < 8; ++b) {
+			int *bucket = histogram.data() + b * 256;
+			if (bucket[int((keys[0] >> (8 * b)) & 0xFF)] == count) {
+				continue;
+			}
+
+			int offset = 0;
+			for (int i = 0; i < 256; ++i) {
+				const int n = bucket[i];
+				bucket[i] = offset;
+				offset += n;
+			}
+			for (int i = 0; i < count; ++i) {
+				const int slot = bucket[int((keys[i] >> (8 * b)) & 0xFF)]++;
+				keyBuffer[slot] = keys[i];
+				valueBuffer[slot] = values[i];
+			}
+			keys.swap(keyBuffer);
+			values.swap(valueBuffer);
+		}
+	}
+
+	QString sizeBucket(qint64 size)
+	{
+		const qint64 mb = 1024 * 1024;
+		if (size < mb) return "Under 1 MB";
+		if (size < 10 * mb) return "1-10 MB";
+		if (size < 100 * mb) return "10-100 MB";
+		if (size < 1024 * mb) return "100 MB - 1 GB";
+		return "Over 1 GB";
+	}
+
+	QString durationBucket(qint64 ms)
+	{
+		const qint64 minute = 60 * 1000;
+		if (ms < minute) return "Under 1 min";
+		if (ms < 5 * minute) return "1-5 min";
+		if (ms < 30 * minute) return "5-30 min";
+		return "Over 30 min";
+	}
+
+	QString resolutionBucket(qint64 pixels)
+	{
+		const qint64 mp = 1000 * 1000;
+		if (pixels < 2 * mp) return "Under 2 MP";
+		if (pixels < 8 * mp) return "2-8 MP";
+		if (pixels < 24 * mp) return "8-24 MP";
+		if (pixels < 50 * mp) return "24-50 MP";
+		return "50 MP and more";
+	}
+}
+
+MetadataColumns::MetadataColumns()
+	: m_loaded(0)
+{
+}
+
+void MetadataColumns::clear()
+{
+	reset(QVector<QString>());
+}
+
+void MetadataColumns::reset(const QVector<QString>& files)
+{
+	const int count = files.size();
+	m_fileSize.fill(-1, count);
+	m_modified.fill(0, count);
+	m_captured.fill(UNKNOWN_DATE, count);
+	m_width.fill(0, count);
+	m_height.fill(0, count);
+	m_duration.fill(0, count);
+	m_bitrate.fill(0, count);
+	m_codec.fill(0, count);
+	m_type.resize(count);
+	m_names = files;
+	m_loaded = 0;
+
+	m_codecNames.clear();
+	m_codecIds.clear();
+	intern(QString(), m_codecNames, m_codecIds);	// 0 - 
+	m_typeNames.clear();
+	m_typeIds.clear();
+
+	for (int i = 0; i < count; ++i) {
+		m_type[i] = intern(QFileInfo(files[i]).suffix().toUpper(), m_typeNames, m_typeIds);
+	}
+}
+
+quint16 MetadataColumns::intern(const QString& value, QStringList& names, QHash<QString, quint16>& ids)
+{
+	auto it = ids.constFind(value);
+	if (it != ids.constEnd()) {
+		return it.value();
+	}
+
+	const quint16 id = quint16(names.size());
+	ids.insert(value, id);
+	names.append(value);
+	return id;
+}
+
+void MetadataColumns::set(int index, const MediaMetadata& meta)
+{
+	if (index < 0 || index >= size() || !meta.isValid()) return;
+
+	if (m_fileSize[index] < 0) {
+		++m_loaded;
+	}
+	m_fileSize[index] = meta.fileSize;
+	m_modified[index] = meta.modified;
+	m_captured[index] = meta.captured.isValid() ? meta.captured.toMSecsSinceEpoch() : UNKNOWN_DATE;
+	m_width[index] = meta.width;
+	m_height[index] = meta.height;
+	m_duration[index] = meta.durationMs;
+	m_bitrate[index] = meta.bitrate;
+	m_codec[index] = intern(meta.codec, m_codecNames, m_codecIds);
+}
+
+MediaMetadata MetadataColumns::at(int index) const
+{
+	MediaMetadata meta;
+	if (index < 0 || index >= size() || m_fileSize[index] < 0) {
+		return meta;
+	}
+
+	meta.fileSize = m_fileSize[index];
+	meta.modified = m_modified[index];
+	if (m_captured[index] != UNKNOWN_DATE) {
+		meta.captured = QDateTime::fromMSecsSinceEpoch(m_captured[index]);
+	}
+	meta.width = m_width[index];
+	meta.height = m_height[index];
+	meta.durationMs = m_duration[index];
+	meta.codec = m_codecNames[m_codec[index]];
+	meta.bitrate = m_bitrate[index];
+	return meta;
+}
+
+void MetadataColumns::removeIndices(const QVector<int>& sortedIndices)
+{
+	if (sortedIndices.isEmpty()) return;
+
+	for (int index : sortedIndices) {
+		if (index < size() && m_fileSize[index] >= 0) {
+			--m_loaded;
+		}
+	}
+
+	removeSortedIndices(m_fileSize, sortedIndices);
+	removeSortedIndices(m_modified, sortedIndices);
+	removeSortedIndices(m_captured, sortedIndices);
+	removeSortedIndices(m_width, sortedIndices);
+	removeSortedIndices(m_height, sortedIndices);
+	removeSortedIndices(m_duration, sortedIndices);
+	removeSortedIndices(m_bitrate, sortedIndices);
+	removeSortedIndices(m_codec, sortedIndices);
+	removeSortedIndices(m_type, sortedIndices);
+	removeSortedIndices(m_names, sortedIndices);
+}
+
+//    ;  - UNKNOWN_KEY
+QVector<quint64> MetadataColumns::sortKeys(Field field) const
+{
+	const int count = size();
+	QVector<quint64> keys(count);
+	quint64 *key = keys.data();
+
+	switch (field) {
+	case DateTaken:
+		for (int i = 0; i < count; ++i) {
+			//  ->    
+			key[i] = m_captured[i] == UNKNOWN_DATE ? UNKNOWN_KEY
+				: quint64(m_captured[i]) ^ (quint64(1) << 63);
+		}
+		break;
+	case FileSize:
+		for (int i = 0; i < count; ++i) {
+			key[i] = m_fileSize[i] < 0 ? UNKNOWN_KEY : quint64(m_fileSize[i]);
+		}
+		break;
+	case Duration:
+		for (int i = 0; i < count; ++i) {
+			key[i] = m_duration[i] <= 0 ? UNKNOWN_KEY : quint64(m_duration[i]);
+		}
+		break;
+	case Resolution:
+		for (int i = 0; i < count; ++i) {
+			const quint64 pixels = quint64(quint32(m_width[i])) * quint32(m_height[i]);
+			key[i] = pixels == 0 ? UNKNOWN_KEY : pixels;
+		}
+		break;
+	case Type: {
+		//   ->     
+		QStringList sorted = m_typeNames;
+		std::sort(sorted.begin(), sorted.end());
+		QVector<quint64> rank(m_typeNames.size());
+		for (int t = 0; t < m_typeNames.size(); ++t) {
+			rank[t] = quint64(sorted.indexOf(m_typeNames[t]));
+		}
+		for (int i = 0; i < count; ++i) {
+			key[i] = rank[m_type[i]];
+		}
+		break;
+	}
+	case Name:
+		for (int i = 0; i < count; ++i) {
+			key[i] = quint64(i);
+		}
+		break;
+	}
+	return keys;
+}
+
+QVector<int> MetadataColumns::sortedOrder(Field field, bool descending) const
+{
+	const int count = size();
+	QVector<int> order(count);
+	for (int i = 0; i < count; ++i) {
+		order[i] = i;
+	}
+	if (field == Name) {
+		//   :     (  )
+		//       ,   
+		// ,    ,    
+		QVector<QString> names(count);
+		for (int i = 0; i < count; ++i) {
+			names[i] = QFileInfo(m_names[i]).fileName();
+		}
+		std::stable_sort(order.begin(), order.end(), [&names](int a, int b) {
+			return QString::compare(names[a], names[b], Qt::CaseInsensitive) < 0;
+		});
+		if (descending) {
+			std::reverse(order.begin(), order.end());
+		}
+		return order;
+	}
+
+	QVector<quint64> keys = sortKeys(field);
+	if (descending) {
+		for (quint64 &key : keys) {
+			if (key != UNKNOWN_KEY) {
+				key = UNKNOWN_KEY - 1 - key;
+			}
+		}
+	}
+
+	radixSort(keys, order);
+	return order;
+}
+
+void MetadataColumns::groups(Field field, QVector<int>& groupOf, QStringList& names) const
+{
+	const int count = size();
+	groupOf.resize(count);
+	names.clear();
+
+	QHash<QString, int> ids;
+	auto group = [&ids, &names](const QString& name) {
+		auto it = ids.constFind(name);
+		if (it != ids.constEnd()) {
+			return it.value();
+		}
+		const int id = names.size();
+		ids.insert(name, id);
+		names.append(name);
+		return id;
+	};
+
+	for (int i = 0; i < count; ++i) {
+		QString name;
+		switch (field) {
+		case Name: {
+			const QString fileName = QFileInfo(m_names[i]).fileName();
+			name = fileName.isEmpty() ? QString("#") : fileName.left(1).toUpper();
+			break;
+		}
+		case DateTaken:
+			name = m_captured[i] == UNKNOWN_DATE ? QString("Unknown date")
+				: QDateTime::fromMSecsSinceEpoch(m_captured[i]).toString("yyyy-MM");
+			break;
+		case FileSize:
+			name = m_fileSize[i] < 0 ? QString("Unknown size") : sizeBucket(m_fileSize[i]);
+			break;
+		case Duration:
+			name = m_duration[i] <= 0 ? QString("No duration") : durationBucket(m_duration[i]);
+			break;
+		case Resolution: {
+			const qint64 pixels = qint64(m_width[i]) * m_height[i];
+			name = pixels <= 0 ? QString("Unknown resolution") : resolutionBucket(pixels);
+			break;
+		}
+		case Type:
+			name = m_typeNames[m_type[i]];
+			break;
+		}
+		groupOf[i] = group(name);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QVector>
+#include <QStringList>
+#include <QHash>
+#include "mediametadata.h"
+
+//      :    
+//  (    ).    
+//        .
+class MetadataColumns
+{
+public:
+	enum Field
+	{
+		Name,			//   
+		DateTaken,
+		FileSize,
+		Duration,
+		Resolution,
+		Type			// 
+	};
+
+	MetadataColumns();
+
+	//  :    ( )
+	void reset(const QVector<QString>& files);
+	void clear();
+
+	int size() const { return m_fileSize.size(); }
+	bool isLoaded(int index) const { return m_fileSize[index] >= 0; }
+	int loadedCount() const { return m_loaded; }
+
+	void set(int index, const MediaMetadata& meta);
+	MediaMetadata at(int index) const;
+
+	//    ,     
+	void removeIndices(const QVector<int>& sortedIndices);
+
+	//    ;   -    
+	// ,  -    . Name -  
+	//    
+	QVector<int> sortedOrder(Field field, bool descending) const;
+
+	//  :        .
+	//     ,   
+	//      
+	void groups(Field field, QVector<int>& groupOf, QStringList& names) const;
+
+private:
+	QVector<qint64> m_fileSize;		// -1 -    
+	QVector<qint64> m_modified;
+	QVector<qint64> m_captured;		//   , UNKNOWN_DATE - 
+	QVector<qint32> m_width;
+	QVector<qint32> m_height;
+	QVector<qint64> m_duration;		// , 0 - 
+	QVector<qint32> m_bitrate;
+	QVector<quint16> m_codec;		//   m_codecNames
+	QVector<quint16> m_type;		//   m_typeNames
+	QVector<QString> m_names;		//   (   )
+
+	QStringList m_codecNames;
+	QHash<QString, quint16> m_codecIds;
+	QStringList m_typeNames;
+	QHash<QString, quint16> m_typeIds;
+	int m_loaded;
+
+	static quint16 intern(const QString& value, QStringList& names, QHash<QString, quint16>& ids);
+	QVector<quint64> sortKeys(Field field) const;
+};
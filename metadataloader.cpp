@@ -0,0 +1,105 @@
+#include "metadataloader.h"
+#include "perfstats.h"
+#include <QFileInfo>
+#include <QDebug>
+
+//   
+static const int EMIT_BATCH_SIZE = 256;
+
+MetadataLoader::MetadataLoader(const QString& ffmpegPath, const QString& cachePath, QObject *parent)
+	: QObject(parent)
+	, m_ffmpegPath(ffmpegPath)
+	, m_latestRequest(0)
+{
+	qRegisterMetaType<MediaMetadata>("MediaMetadata");
+	qRegisterMetaType<QVector<MediaMetadata>>("QVector<MediaMetadata>");
+
+	if (!cachePath.isEmpty()) {
+		m_cache.load(cachePath);
+	}
+}
+
+MetadataLoader::~MetadataLoader()
+{
+	if (m_cache.isDirty()) {
+		m_cache.save();
+	}
+}
+
+void MetadataLoader::loadMetadata(int requestId, const QStringList& paths)
+{
+	QVector<MediaMetadata> result(paths.size());
+	QStringList probePaths;			//     MP4 -  ffmpeg
+	QVector<int> probeIndices;
+	int emitted = 0;
+
+	for (int i = 0; i < paths.size(); ++i) {
+		if (!isCurrent(requestId)) {
+			break;
+		}
+
+		const QFileInfo info(paths[i]);
+		const qint64 size = info.size();
+		const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+		MediaMetadata &meta = result[i];
+		if (!m_cache.lookup(paths[i], size, modified, meta)) {
+			meta = MediaMetadata();
+			meta.fileSize = size;
+			meta.modified = modified;
+
+			const QString suffix = info.suffix();
+			PerfTimer timer(PerfStats::MetadataRead, paths[i]);
+			if (!MetadataExtractor::isVideo(suffix)) {
+				MetadataExtractor::readImage(paths[i], meta);
+				m_cache.insert(paths[i], meta);
+			}
+			else if (MetadataExtractor::isMp4Family(suffix) && MetadataExtractor::readMp4(paths[i], meta)) {
+				m_cache.insert(paths[i], meta);
+			}
+			else {
+				timer.discard();	// ffmpeg   ,    
+				probePaths.append(paths[i]);
+				probeIndices.append(i);
+			}
+		}
+
+		if (i + 1 - emitted >= EMIT_BATCH_SIZE) {
+			emit metadataLoaded(requestId, emitted, result.mid(emitted, i + 1 - emitted));
+			emitted = i + 1;
+		}
+	}
+
+	if (!isCurrent(requestId)) {
+		return;
+	}
+	if (emitted < paths.size()) {
+		emit metadataLoaded(requestId, emitted, result.mid(emitted));
+	}
+
+	//   ffmpeg      .  ffmpeg
+	//    - ,   
+	if (!probePaths.isEmpty() && QFileInfo(m_ffmpegPath).isFile()) {
+		//   -    
+		QVector<bool> described;
+		const QVector<MediaMetadata> probed = MetadataExtractor::readWithFFmpeg(m_ffmpegPath, probePaths,
+			[this, requestId]() { return !isCurrent(requestId); }, &described);
+		for (int k = 0; k < probed.size(); ++k) {
+			MediaMetadata meta = probed[k];
+			meta.fileSize = result[probeIndices[k]].fileSize;
+			meta.modified = result[probeIndices[k]].modified;
+			// ,  ffmpeg  ,    
+			if (described[k]) {
+				m_cache.insert(probePaths[k], meta);
+			}
+
+			if (isCurrent(requestId)) {
+				emit metadataLoaded(requestId, probeIndices[k], QVector<MediaMetadata>{ meta });
+			}
+		}
+	}
+
+	if (m_cache.isDirty()) {
+		m_cache.save();
+	}
+}
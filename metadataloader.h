@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <QAtomicInt>
+#include "mediametadata.h"
+#include "metadatacache.h"
+
+//      (  ,  ThumbnailLoader).
+//   MP4/MOV   ,   - 
+//  ffmpeg  .      .
+//     .
+class MetadataLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	MetadataLoader(const QString& ffmpegPath, const QString& cachePath, QObject *parent = nullptr);
+	~MetadataLoader();
+
+	//   GUI-     
+	void setLatestRequest(int requestId) { m_latestRequest.storeRelease(requestId); }
+
+public slots:
+	void loadMetadata(int requestId, const QStringList& paths);
+
+signals:
+	//    paths[first], paths[first + 1], ...
+	void metadataLoaded(int requestId, int first, const QVector<MediaMetadata>& metadata);
+
+private:
+	QString m_ffmpegPath;
+	MetadataCache m_cache;		//    
+	QAtomicInt m_latestRequest;
+
+	bool isCurrent(int requestId) const { return m_latestRequest.loadAcquire() == requestId; }
+};
@@ -0,0 +1,178 @@
+#include "perfpanel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QLabel>
+#include <QTimer>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+
+static const int REFRESH_INTERVAL = 1000;
+
+namespace
+{
+	QString formatMs(qint64 usec)
+	{
+		if (usec < 10000) return QString::number(usec / 1000.0, 'f', 2);
+		return QString::number(usec / 1000.0, 'f', 0);
+	}
+}
+
+PerfPanel::PerfPanel(QWidget *parent)
+	: QDockWidget("Performance", parent)
+	, m_stageTable(nullptr)
+	, m_slowTable(nullptr)
+	, m_countersLabel(nullptr)
+	, m_traceButton(nullptr)
+	, m_refreshTimer(nullptr)
+	, m_lastRefresh(0)
+{
+	setObjectName("PerfPanel");
+	setAllowedAreas(Qt::AllDockWidgetAreas);
+
+	QWidget *mainWidget = new QWidget();
+	QVBoxLayout *mainLayout = new QVBoxLayout(mainWidget);
+
+	m_stageTable = new QTreeWidget();
+	m_stageTable->setRootIsDecorated(false);
+	m_stageTable->setHeaderLabels(QStringList() << "Stage" << "Count" << "Per sec"
+		<< "p50 ms" << "p95 ms" << "p99 ms" << "Max ms" << "Total ms");
+	m_stageTable->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	mainLayout->addWidget(m_stageTable, 2);
+
+	m_countersLabel = new QLabel();
+	m_countersLabel->setWordWrap(true);
+	mainLayout->addWidget(m_countersLabel);
+
+	mainLayout->addWidget(new QLabel("Slowest files:"));
+	m_slowTable = new QTreeWidget();
+	m_slowTable->setRootIsDecorated(false);
+	m_slowTable->setHeaderLabels(QStringList() << "ms" << "Stage" << "File");
+	m_slowTable->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	mainLayout->addWidget(m_slowTable, 1);
+
+	QHBoxLayout *buttonLayout = new QHBoxLayout();
+	QPushButton *resetButton = new QPushButton("Reset");
+	QPushButton *exportButton = new QPushButton("Export JSON...");
+	m_traceButton = new QPushButton("Start trace");
+	m_traceButton->setToolTip("Record a timeline for chrome://tracing or Perfetto");
+	buttonLayout->addWidget(m_traceButton);
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(resetButton);
+	buttonLayout->addWidget(exportButton);
+	mainLayout->addLayout(buttonLayout);
+
+	setWidget(mainWidget);
+
+	connect(resetButton, &QPushButton::clicked, this, &PerfPanel::onResetClicked);
+	connect(exportButton, &QPushButton::clicked, this, &PerfPanel::onExportClicked);
+	connect(m_traceButton, &QPushButton::clicked, this, &PerfPanel::onTraceClicked);
+
+	//     
+	m_refreshTimer = new QTimer(this);
+	m_refreshTimer->setInterval(REFRESH_INTERVAL);
+	connect(m_refreshTimer, &QTimer::timeout, this, &PerfPanel::refresh);
+	connect(this, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+		if (visible) {
+			refresh();
+			m_refreshTimer->start();
+		}
+		else {
+			m_refreshTimer->stop();
+		}
+	});
+}
+
+PerfPanel::~PerfPanel()
+{
+}
+
+void PerfPanel::refresh()
+{
+	const QVector<PerfStats::StageStats> stages = PerfStats::stageStats();
+	const qint64 now = PerfStats::now();
+	const double seconds = (now - m_lastRefresh) / 1e6;
+	const bool haveRate = m_lastCounts.size() == stages.size() && seconds > 0;
+
+	//    ,    
+	if (m_stageTable->topLevelItemCount() != stages.size()) {
+		m_stageTable->clear();
+		for (const PerfStats::StageStats &stats : stages) {
+			new QTreeWidgetItem(m_stageTable, QStringList() << stats.name);
+		}
+	}
+
+	m_lastCounts.resize(stages.size());
+	for (int s = 0; s < stages.size(); ++s) {
+		const PerfStats::StageStats &stats = stages[s];
+		QTreeWidgetItem *item = m_stageTable->topLevelItem(s);
+
+		const double rate = haveRate && stats.count >= m_lastCounts[s]
+			? (stats.count - m_lastCounts[s]) / seconds : 0.0;
+		m_lastCounts[s] = stats.count;
+
+		item->setText(1, QString::number(stats.count));
+		item->setText(2, stats.count ? QString::number(rate, 'f', 1) : QString());
+		item->setText(3, stats.count ? formatMs(stats.p50Us) : QString());
+		item->setText(4, stats.count ? formatMs(stats.p95Us) : QString());
+		item->setText(5, stats.count ? formatMs(stats.p99Us) : QString());
+		item->setText(6, stats.count ? formatMs(stats.maxUs) : QString());
+		item->setText(7, stats.count ? formatMs(stats.totalUs) : QString());
+	}
+	m_lastRefresh = now;
+
+	QStringList counters;
+	for (const auto &counter : PerfStats::counters()) {
+		counters.append(QString("%1: %2").arg(counter.first).arg(counter.second));
+	}
+	m_countersLabel->setText(counters.join("  "));
+
+	m_slowTable->clear();
+	for (const PerfStats::SlowFile &file : PerfStats::slowestFiles()) {
+		QTreeWidgetItem *item = new QTreeWidgetItem(m_slowTable, QStringList()
+			<< formatMs(file.usec)
+			<< PerfStats::stageName(file.stage)
+			<< QFileInfo(file.path).fileName());
+		item->setToolTip(2, file.path);
+	}
+}
+
+void PerfPanel::onResetClicked()
+{
+	PerfStats::reset();
+	m_lastCounts.clear();
+	refresh();
+}
+
+void PerfPanel::onExportClicked()
+{
+	const QString filePath = QFileDialog::getSaveFileName(this, "Export performance stats",
+		"perfstats.json", "JSON (*.json)");
+	if (filePath.isEmpty()) return;
+
+	if (!PerfStats::saveJson(filePath)) {
+		QMessageBox::warning(this, "Error",
+			QString("Failed to save:\n%1").arg(filePath));
+	}
+}
+
+void PerfPanel::onTraceClicked()
+{
+	if (!Tracer::isEnabled()) {
+		Tracer::start();
+		m_traceButton->setText("Stop trace...");
+		return;
+	}
+
+	//     -   
+	const QString filePath = QFileDialog::getSaveFileName(this, "Save trace",
+		"trace.json", "Trace Event JSON (*.json)");
+	if (!Tracer::stop(filePath) && !filePath.isEmpty()) {
+		QMessageBox::warning(this, "Error",
+			QString("Failed to save:\n%1").arg(filePath));
+	}
+	m_traceButton->setText("Start trace");
+}
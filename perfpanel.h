@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QDockWidget>
+#include <QVector>
+#include "perfstats.h"
+
+class QTreeWidget;
+class QLabel;
+class QTimer;
+class QPushButton;
+
+//   :   - , ,
+// p50/p95/p99/max;   .    ,
+//  
+class PerfPanel : public QDockWidget
+{
+	Q_OBJECT
+
+public:
+	explicit PerfPanel(QWidget *parent);
+	~PerfPanel();
+
+public slots:
+	void refresh();
+	void onResetClicked();
+	void onExportClicked();
+	void onTraceClicked();
+
+private:
+	QTreeWidget *m_stageTable;
+	QTreeWidget *m_slowTable;
+	QLabel *m_countersLabel;
+	QPushButton *m_traceButton;
+	QTimer *m_refreshTimer;
+
+	//  :    
+	QVector<quint64> m_lastCounts;
+	qint64 m_lastRefresh;
+};
@@ -0,0 +1,292 @@
+#include "perfstats.h"
+#include <QAtomicInteger>
+#include <QtAlgorithms>
+#include <QMutex>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+
+namespace
+{
+	//  :   32 -    ,
+	//       16  ( 5  )
+	const int SUB_BUCKETS = 16;
+	const int MAX_SHIFT = 36;
+	const int BUCKET_COUNT = SUB_BUCKETS * (MAX_SHIFT + 2);
+	const qint64 MAX_VALUE = (qint64(1) << (MAX_SHIFT + 5)) - 1;
+
+	int bucketOf(qint64 value)
+	{
+		const quint64 v = quint64(qBound(qint64(0), value, MAX_VALUE));
+		const int msb = v ? 63 - qCountLeadingZeroBits(v) : 0;
+		const int shift = qMax(0, msb - 4);
+		return SUB_BUCKETS * shift + int(v >> shift);
+	}
+
+	//     
+	qint64 bucketLow(int bucket)
+	{
+		if (bucket < 2 * SUB_BUCKETS) return bucket;
+		const int shift = bucket / SUB_BUCKETS - 1;
+		return qint64(bucket - SUB_BUCKETS * shift) << shift;
+	}
+
+	qint64 bucketWidth(int bucket)
+	{
+		if (bucket < 2 * SUB_BUCKETS) return 1;
+		return qint64(1) << (bucket / SUB_BUCKETS - 1);
+	}
+
+	struct StageData
+	{
+		QAtomicInteger<quint32> buckets[BUCKET_COUNT];
+		QAtomicInteger<qint64> total;
+		QAtomicInteger<qint64> max;
+	};
+
+	StageData g_stages[PerfStats::StageCount];
+	QAtomicInteger<qint64> g_counters[PerfStats::CounterCount];
+
+	//   ;      
+	//  ,    
+	QMutex g_slowMutex;
+	QVector<PerfStats::SlowFile> g_slowFiles;		//   
+	QAtomicInteger<qint64> g_slowThreshold;
+
+	const char* const COUNTER_NAMES[PerfStats::CounterCount] = {
+		"decode_failed",
+		"ffmpeg_failed",
+		"file_op_failed",
+		"thumbnails_delivered"
+	};
+
+	QElapsedTimer& clock()
+	{
+		static QElapsedTimer timer = []() {
+			QElapsedTimer t;
+			t.start();
+			return t;
+		}();
+		return timer;
+	}
+
+	qint64 g_resetAt = 0;
+
+	qint64 percentile(const quint32 *counts, quint64 total, qint64 maxValue, double q)
+	{
+		if (total == 0) return 0;
+		const quint64 target = qMax<quint64>(1, quint64(q * total + 0.5));
+		quint64 seen = 0;
+		for (int b = 0; b < BUCKET_COUNT; ++b) {
+			seen += counts[b];
+			if (seen >= target) {
+				return qMin(maxValue, bucketLow(b) + bucketWidth(b) / 2);
+			}
+		}
+		return maxValue;
+	}
+
+	void addSlowFile(const QString& filePath, PerfStats::Stage stage, qint64 usec)
+	{
+		QMutexLocker locker(&g_slowMutex);
+
+		//        -   
+		for (int i = 0; i < g_slowFiles.size(); ++i) {
+			if (g_slowFiles[i].stage == stage && g_slowFiles[i].path == filePath) {
+				if (g_slowFiles[i].usec >= usec) return;
+				g_slowFiles.removeAt(i);
+				break;
+			}
+		}
+
+		PerfStats::SlowFile entry{ filePath, stage, usec };
+		auto pos = std::upper_bound(g_slowFiles.begin(), g_slowFiles.end(), entry,
+			[](const PerfStats::SlowFile& a, const PerfStats::SlowFile& b) { return a.usec > b.usec; });
+		g_slowFiles.insert(pos, entry);
+		if (g_slowFiles.size() > PerfStats::SLOWEST_FILES) {
+			g_slowFiles.resize(PerfStats::SLOWEST_FILES);
+		}
+		if (g_slowFiles.size() == PerfStats::SLOWEST_FILES) {
+			g_slowThreshold.storeRelaxed(g_slowFiles.last().usec);
+		}
+	}
+}
+
+qint64 PerfStats::now()
+{
+	return clock().nsecsElapsed() / 1000;
+}
+
+void PerfStats::record(Stage stage, qint64 usec, const QString& filePath)
+{
+	if (stage < 0 || stage >= StageCount) return;
+	usec = qMax(qint64(0), usec);
+
+	StageData &data = g_stages[stage];
+	data.buckets[bucketOf(usec)].fetchAndAddRelaxed(1);
+	data.total.fetchAndAddRelaxed(usec);
+
+	qint64 max = data.max.loadRelaxed();
+	while (usec > max && !data.max.testAndSetRelaxed(max, usec, max)) {
+	}
+
+	if (!filePath.isEmpty() && usec > g_slowThreshold.loadRelaxed()) {
+		addSlowFile(filePath, stage, usec);
+	}
+}
+
+void PerfStats::add(Counter counter, qint64 value)
+{
+	if (counter < 0 || counter >= CounterCount) return;
+	g_counters[counter].fetchAndAddRelaxed(value);
+}
+
+QVector<PerfStats::StageStats> PerfStats::stageStats()
+{
+	QVector<StageStats> result;
+	result.reserve(StageCount);
+
+	QVector<quint32> counts(BUCKET_COUNT);
+	for (int s = 0; s < StageCount; ++s) {
+		const StageData &data = g_stages[s];
+
+		//  :   ,    
+		quint64 total = 0;
+		for (int b = 0; b < BUCKET_COUNT; ++b) {
+			counts[b] = data.buckets[b].loadRelaxed();
+			total += counts[b];
+		}
+
+		StageStats stats;
+		stats.name = stageName(Stage(s));
+		stats.count = total;
+		stats.totalUs = data.total.loadRelaxed();
+		stats.maxUs = data.max.loadRelaxed();
+		stats.p50Us = percentile(counts.constData(), total, stats.maxUs, 0.50);
+		stats.p95Us = percentile(counts.constData(), total, stats.maxUs, 0.95);
+		stats.p99Us = percentile(counts.constData(), total, stats.maxUs, 0.99);
+		result.append(stats);
+	}
+	return result;
+}
+
+QVector<QPair<QString, qint64>> PerfStats::counters()
+{
+	QVector<QPair<QString, qint64>> result;
+	for (int c = 0; c < CounterCount; ++c) {
+		result.append(qMakePair(QString(COUNTER_NAMES[c]), g_counters[c].loadRelaxed()));
+	}
+	return result;
+}
+
+QVector<PerfStats::SlowFile> PerfStats::slowestFiles()
+{
+	QMutexLocker locker(&g_slowMutex);
+	return g_slowFiles;
+}
+
+qint64 PerfStats::uptimeUs()
+{
+	return now() - g_resetAt;
+}
+
+void PerfStats::reset()
+{
+	for (StageData &data : g_stages) {
+		for (auto &bucket : data.buckets) {
+			bucket.storeRelaxed(0);
+		}
+		data.total.storeRelaxed(0);
+		data.max.storeRelaxed(0);
+	}
+	for (auto &counter : g_counters) {
+		counter.storeRelaxed(0);
+	}
+
+	QMutexLocker locker(&g_slowMutex);
+	g_slowFiles.clear();
+	g_slowThreshold.storeRelaxed(0);
+	g_resetAt = now();
+}
+
+const char* PerfStats::stageName(Stage stage)
+{
+	switch (stage) {
+	case Enumerate:			return "enumerate";
+	case HeaderRead:		return "header_read";
+	case ImageDecode:		return "image_decode";
+	case Scale:				return "scale";
+	case FFmpegSpawn:		return "ffmpeg_spawn";
+	case FFmpegFrame:		return "ffmpeg_frame";
+	case Delivery:			return "delivery";
+	case Paint:				return "paint";
+	case TagLoad:			return "tag_load";
+	case TagSave:			return "tag_save";
+	case TagQuery:			return "tag_query";
+	case SnapshotPublish:	return "snapshot_publish";
+	case MetadataRead:		return "metadata_read";
+	case FileMove:			return "file_move";
+	case FileDelete:		return "file_delete";
+	case GuiStall:			return "gui_stall";
+	case StageCount:		break;
+	}
+	return "unknown";
+}
+
+QByteArray PerfStats::toJson()
+{
+	const double uptime = uptimeUs() / 1e6;
+	auto ms = [](qint64 usec) { return usec / 1000.0; };
+
+	QJsonArray stages;
+	for (const StageStats &stats : stageStats()) {
+		QJsonObject stage;
+		stage["name"] = stats.name;
+		stage["count"] = double(stats.count);
+		stage["total_ms"] = ms(stats.totalUs);
+		stage["mean_ms"] = stats.count ? ms(stats.totalUs) / stats.count : 0.0;
+		stage["p50_ms"] = ms(stats.p50Us);
+		stage["p95_ms"] = ms(stats.p95Us);
+		stage["p99_ms"] = ms(stats.p99Us);
+		stage["max_ms"] = ms(stats.maxUs);
+		stage["per_second"] = uptime > 0 ? stats.count / uptime : 0.0;
+		stages.append(stage);
+	}
+
+	QJsonObject counterValues;
+	for (const auto &counter : counters()) {
+		counterValues[counter.first] = double(counter.second);
+	}
+
+	QJsonArray slowest;
+	for (const SlowFile &file : slowestFiles()) {
+		QJsonObject entry;
+		entry["path"] = file.path;
+		entry["stage"] = stageName(file.stage);
+		entry["ms"] = ms(file.usec);
+		slowest.append(entry);
+	}
+
+	QJsonObject root;
+	root["created"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	root["uptime_s"] = uptime;
+	root["stages"] = stages;
+	root["counters"] = counterValues;
+	root["slowest_files"] = slowest;
+	return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool PerfStats::saveJson(const QString& filePath)
+{
+	QSaveFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot save performance stats:" << filePath << file.errorString();
+		return false;
+	}
+	file.write(toJson());
+	return file.commit();
+}
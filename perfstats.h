@@ -0,0 +1,141 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include "tracer.h"
+#include "stallwatchdog.h"
+
+//      .  -  
+//    (   ), 
+//   : ~3%   1   
+class PerfStats
+{
+public:
+	enum Stage
+	{
+		Enumerate,			//   
+		HeaderRead,			//   (, )
+		ImageDecode,		//    
+		Scale,				//   
+		FFmpegSpawn,		//   ffmpeg
+		FFmpegFrame,		//    (, , PNG)
+		Delivery,			//  emit       GUI
+		Paint,				// paintEvent  
+		TagLoad,			//     
+		TagSave,			//   
+		TagQuery,			//     
+		SnapshotPublish,	//   
+		MetadataRead,		//     
+		FileMove,
+		FileDelete,
+		GuiStall,			//  GUI- (StallWatchdog)
+		StageCount
+	};
+
+	enum Counter
+	{
+		DecodeFailed,
+		FFmpegFailed,
+		FileOpFailed,
+		ThumbnailsDelivered,
+		CounterCount
+	};
+
+	struct StageStats
+	{
+		QString name;
+		quint64 count = 0;
+		qint64 totalUs = 0;
+		qint64 maxUs = 0;
+		qint64 p50Us = 0;
+		qint64 p95Us = 0;
+		qint64 p99Us = 0;
+	};
+
+	struct SlowFile
+	{
+		QString path;
+		Stage stage;
+		qint64 usec;
+	};
+
+	static const int SLOWEST_FILES = 20;
+
+	//     (    )
+	static qint64 now();
+
+	static void record(Stage stage, qint64 usec, const QString& filePath = QString());
+	static void add(Counter counter, qint64 value = 1);
+
+	static QVector<StageStats> stageStats();
+	static QVector<QPair<QString, qint64>> counters();
+	static QVector<SlowFile> slowestFiles();
+	static qint64 uptimeUs();
+
+	static void reset();
+
+	static const char* stageName(Stage stage);
+	static QByteArray toJson();
+	static bool saveJson(const QString& filePath);
+};
+
+//   :      ( stop()).
+//         , 
+// GUI- -         
+class PerfTimer
+{
+public:
+	explicit PerfTimer(PerfStats::Stage stage, const QString& filePath = QString())
+		: m_stage(stage)
+		, m_filePath(filePath)
+		, m_running(true)
+		, m_traceStart(Tracer::isEnabled() ? PerfStats::now() : -1)
+		, m_watched(StallWatchdog::isGuiThread())
+	{
+		if (m_watched) {
+			StallWatchdog::enterOperation(PerfStats::stageName(stage), filePath);
+		}
+		m_timer.start();
+	}
+	~PerfTimer() { stop(); }
+
+	qint64 stop()
+	{
+		if (!m_running) return 0;
+		m_running = false;
+		leaveOperation();
+		const qint64 usec = m_timer.nsecsElapsed() / 1000;
+		PerfStats::record(m_stage, usec, m_filePath);
+		if (m_traceStart >= 0) {
+			Tracer::complete(PerfStats::stageName(m_stage), m_traceStart, usec, m_filePath);
+		}
+		return usec;
+	}
+
+	//    (,    )
+	void discard()
+	{
+		m_running = false;
+		leaveOperation();
+	}
+
+private:
+	void leaveOperation()
+	{
+		if (m_watched) {
+			m_watched = false;
+			StallWatchdog::leaveOperation();
+		}
+	}
+
+	QElapsedTimer m_timer;
+	PerfStats::Stage m_stage;
+	QString m_filePath;
+	bool m_running;
+	qint64 m_traceStart;	// -1 -   
+	bool m_watched;			//     GUI-
+
+	Q_DISABLE_COPY(PerfTimer)
+};
@@ -1,76 +1,106 @@
 #include "previewarea.h"
+#include "utils.h"
+#include "perfstats.h"
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QDebug>
-#include <QGridLayout>
-#include <QTimer>
 #include <QScrollBar>
+#include <algorithm>
+
+//   -  FAST_SCROLL_SCREENS   
+static const double FAST_SCROLL_SCREENS = 2.0;
+//   :    v 
+//   v * FLING_DECAY_SECONDS 
+static const double FLING_DECAY_SECONDS = 0.35;
+//       -  
+static const int SCROLL_SETTLE_MS = 120;
+//     :     
+//      
+static const float MIN_ASPECT_RATIO = 0.25f;
+static const float MAX_ASPECT_RATIO = 8.0f;
+//     
+static const int LAYOUT_DELAY_MS = 50;
+//   
+static const int GROUP_HEADER_HEIGHT = 28;
 
 PreviewArea::PreviewArea(QWidget *parent)
-	: QScrollArea(parent)
+	: QAbstractScrollArea(parent)
 	, totalCount(0)
 	, firstVisibleIndex(-1)
 	, lastVisibleIndex(-1)
 	, thumbnailSize(200)
 	, spacing(10)
 	, lastSelectedIndex(-1)
-	, container(nullptr)
-	, scrollTimer(nullptr)
+	, hoveredIndex(-1)
 	, currentColumns(4)
+	, lastScrollValue(0)
+	, scrollVelocity(0.0)
+	, focusFirst(-1)
+	, focusLast(-1)
+	, focusFast(false)
+	, layoutMode(GridLayout)
+	, dirtyFirst(-1)
+	, dirtyLast(-1)
 {
 	//   
-	setWidgetResizable(true);
-	setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 	setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
 
-	//  
-	container = new QWidget();
-	container->setAttribute(Qt::WA_TransparentForMouseEvents);
-	setWidget(container);
-
-	//  
-	container->setStyleSheet(
-		"QWidget {"
-		"    background-color: #fafafa;"
-		"    border: 1px dashed #e0e0e0;"
-		"}"
-	);
+	//     
+	viewport()->setMouseTracking(true);
+	viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
 
 	//     
-	QScrollBar* vScrollBar = verticalScrollBar();
-	int rowHeight = thumbnailSize + spacing;
-	vScrollBar->setSingleStep(rowHeight);
-	
-	vScrollBar->update();
+	verticalScrollBar()->setSingleStep(thumbnailSize + spacing);
 
-	//       
-//	setFocusPolicy(Qt::StrongFocus);
-	updateBackgroundStyle();	
+	settleTimer = new QTimer(this);
+	settleTimer->setSingleShot(true);
+	settleTimer->setInterval(SCROLL_SETTLE_MS);
+	connect(settleTimer, &QTimer::timeout, this, &PreviewArea::onScrollSettled);
+	scrollClock.start();
 
-	connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &PreviewArea::updateVisibleRange);
+	layoutTimer = new QTimer(this);
+	layoutTimer->setSingleShot(true);
+	layoutTimer->setInterval(LAYOUT_DELAY_MS);
+	connect(layoutTimer, &QTimer::timeout, this, &PreviewArea::onLayoutTimer);
 
-	//    
-	scrollTimer = new QTimer(this);
-	scrollTimer->setSingleShot(true);
-	scrollTimer->setInterval(50);
-	connect(scrollTimer, &QTimer::timeout, this, &PreviewArea::updateVisibleRange);
-	connect(verticalScrollBar(), &QScrollBar::valueChanged,
-		[this](int) { scrollTimer->start(); });
+	connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &PreviewArea::onScrollValueChanged);
 }
 
 PreviewArea::~PreviewArea()
 {
-	clearThumbnails();
+}
+
+void PreviewArea::setLayoutMode(LayoutMode mode)
+{
+	if (mode == layoutMode) return;
+
+	//      
+	const int anchor = rowCount() > 0 ? rowFirst(rowAtY(verticalScrollBar()->value())) : 0;
+
+	layoutMode = mode;
+	updateLayout();
+	updateScrollBarRange();
+	if (rowCount() > 0) {
+		verticalScrollBar()->setValue(rowTop(rowOf(anchor)) - spacing / 2);
+	}
+
+	firstVisibleIndex = -1;
+	lastVisibleIndex = -1;
+	focusFirst = -1;
+	focusLast = -1;
+	updateVisibleRange();
+	viewport()->update();
 }
 
 void PreviewArea::setThumbnailSize(int size)
 {
 	thumbnailSize = size;
-	updateScrollStep();
-	updateColumns();
-	updateContainerSize();
-	//@ updateVisibleRange();
-	recreateVisibleWidgets();
+	updateLayout();
+	updateScrollBarRange();
+	updateVisibleRange();
+	viewport()->update();
 }
 
 void PreviewArea::updateColumns()
@@ -82,13 +112,7 @@ void PreviewArea::updateColumns()
 
 	//    
 	int newColumns = availableWidth / (thumbnailSize + spacing);
-	newColumns = qMax(1, newColumns);  //  1 
-
-	if (newColumns != currentColumns) {		
-		currentColumns = newColumns;
-		updateContainerSize();
-		recreateVisibleWidgets();
-	}
+	currentColumns = qMax(1, newColumns);  //  1 
 }
 
 void PreviewArea::setTotalCount(int count)
@@ -96,270 +120,637 @@ void PreviewArea::setTotalCount(int count)
 	totalCount = count;
 	filenames.resize(count);
 	thumbnails.resize(count);
-	updateContainerSize();
+	aspectRatios.resize(count);
+	rebuildProjection();
+	updateLayout();
+	updateScrollBarRange();
 	updateVisibleRange();
+	viewport()->update();
 }
 
 void PreviewArea::clearThumbnails()
 {
-	//   
-	for (auto widget : visibleWidgets) {
-		widget->deleteLater();
-	}
-	visibleWidgets.clear();
 	thumbnails.clear();
 	filenames.clear();
+	aspectRatios.clear();
 	selectedIndices.clear();
+	filterMask.clear();
+	sortOrder.clear();
+	groupOf.clear();
+	groupNames.clear();
+	projection.clear();
+	positions.clear();
 	totalCount = 0;
 	firstVisibleIndex = -1;
 	lastVisibleIndex = -1;
+	focusFirst = -1;
+	focusLast = -1;
+	lastSelectedIndex = -1;
+	hoveredIndex = -1;
+	updateLayout();
+	updateScrollBarRange();
+	viewport()->update();
+}
+
+void PreviewArea::setFilter(const QVector<quint64>& mask)
+{
+	filterMask = mask;
+	rebuildProjection();
+	updateLayout();
+
+	firstVisibleIndex = -1;
+	lastVisibleIndex = -1;
+	focusFirst = -1;
+	focusLast = -1;
+	hoveredIndex = -1;
+
+	updateScrollBarRange();
+	verticalScrollBar()->setValue(0);
+	updateVisibleRange();
+	viewport()->update();
+}
+
+void PreviewArea::setOrder(const QVector<int>& order, const QVector<int>& groups, const QStringList& names)
+{
+	//        -  
+	//    ,        
+	const int scroll = verticalScrollBar()->value();
+	const int anchor = scroll > 0 && rowCount() > 0 ? rowFirst(rowAtY(scroll)) : -1;
+	const int anchorItem = anchor >= 0 && anchor < itemCount() ? itemAt(anchor) : -1;
+
+	sortOrder = order;
+	groupOf = groups;
+	groupNames = names;
+	rebuildProjection();
+	updateLayout();
+
+	firstVisibleIndex = -1;
+	lastVisibleIndex = -1;
+	focusFirst = -1;
+	focusLast = -1;
+	hoveredIndex = -1;
+
+	updateScrollBarRange();
+	const int position = anchorItem >= 0 ? positionOf(anchorItem) : -1;
+	verticalScrollBar()->setValue(position >= 0 && rowCount() > 0 ? rowTop(rowOf(position)) - spacing / 2 : 0);
+	updateVisibleRange();
+	viewport()->update();
 }
 
-//    delete/new  
-//   updateVisibleRange     
+// O(n):     ,  
+//  ;   -      
+void PreviewArea::rebuildProjection()
+{
+	projection.clear();
+	positions.clear();
+	groupStarts.clear();
+	if (!isProjected()) {
+		return;
+	}
+
+	positions.fill(-1, totalCount);
+	projection.reserve(totalCount);
+
+	if (!sortOrder.isEmpty()) {
+		const bool filtered = !filterMask.isEmpty();
+		for (int index : sortOrder) {
+			if (index < 0 || index >= totalCount)
+				continue;
+			if (filtered && !((filterMask.value(index >> 6) >> (index & 63)) & 1))
+				continue;
+			positions[index] = projection.size();
+			projection.append(index);
+		}
+	}
+	else {
+		const int words = qMin(filterMask.size(), (totalCount + 63) / 64);
+		for (int w = 0; w < words; ++w) {
+			quint64 word = filterMask[w];
+			while (word) {
+				const int index = w * 64 + qCountTrailingZeroBits(word);
+				if (index >= totalCount)
+					break;
+				positions[index] = projection.size();
+				projection.append(index);
+				word &= word - 1;
+			}
+		}
+	}
+
+	//   ,    
+	if (!groupOf.isEmpty()) {
+		int previous = -1;
+		for (int p = 0; p < projection.size(); ++p) {
+			const int group = groupOf.value(projection[p], -1);
+			if (p == 0 || group != previous) {
+				groupStarts.append(p);
+			}
+			previous = group;
+		}
+	}
+}
+
+//     [first, last]:   -  ,
+//   -       
+IndexSelection PreviewArea::itemsInRange(int first, int last) const
+{
+	IndexSelection result;
+	first = qMax(0, first);
+	last = qMin(itemCount() - 1, last);
+	if (first > last) {
+		return result;
+	}
+
+	if (!isProjected()) {
+		result.insertRange(first, last);
+		return result;
+	}
+
+	int runStart = projection[first];
+	int runEnd = runStart;
+	for (int p = first + 1; p <= last; ++p) {
+		const int index = projection[p];
+		if (index != runEnd + 1) {
+			result.insertRange(runStart, runEnd);
+			runStart = index;
+		}
+		runEnd = index;
+	}
+	result.insertRange(runStart, runEnd);
+	return result;
+}
 
+//    ( ) -    
 void PreviewArea::updateVisibleRange()
 {
-	if (totalCount == 0 || currentColumns == 0)
+	TraceScope trace("update_visible_range");
+	const int count = itemCount();
+	if (count == 0 || currentColumns == 0)
 		return;
 
+	updateDecodeFocus();
+
 	const int scrollTop = verticalScrollBar()->value();
 	const int viewportHeight = viewport()->height();
-	const int rowHeight = thumbnailSize + spacing;
-
-	// --- 1.    ---
-	int firstRow = scrollTop / rowHeight;
-	int lastRow = (scrollTop + viewportHeight) / rowHeight;
 
 	const int bufferRows = 2;
-	firstRow = qMax(0, firstRow - bufferRows);
+	const int firstRow = qMax(0, rowAtY(scrollTop) - bufferRows);
+	const int lastRow = qMin(rowCount() - 1, rowAtY(scrollTop + viewportHeight) + bufferRows);
 
-	const int maxRow = (totalCount - 1) / currentColumns;
-	lastRow = qMin(maxRow, lastRow + bufferRows);
-
-	const int newFirst = firstRow * currentColumns;
-	const int newLast = qMin(totalCount - 1, (lastRow + 1) * currentColumns - 1);
+	const int newFirst = rowFirst(firstRow);
+	const int newLast = rowEnd(lastRow) - 1;
 
 	if (newFirst == firstVisibleIndex && newLast == lastVisibleIndex)
 		return;
 
-	// --- 2.        ---
-	if (visibleWidgets.isEmpty())
-	{
-		firstVisibleIndex = newFirst;
-		lastVisibleIndex = newLast;
+	firstVisibleIndex = newFirst;
+	lastVisibleIndex = newLast;
+	emit visibleRangeChanged(firstVisibleIndex, lastVisibleIndex);
+}
 
-		for (int i = newFirst; i <= newLast; ++i)
-		{
-			ThumbnailWidget* w = createThumbnailWidget(i);
-			visibleWidgets.append(w);
-		}
+void PreviewArea::onScrollValueChanged(int value)
+{
+	//    , ;   -  
+	const qint64 elapsed = scrollClock.restart();
+	if (elapsed > 0 && elapsed < SCROLL_SETTLE_MS) {
+		const double instant = (value - lastScrollValue) * 1000.0 / elapsed;
+		scrollVelocity = 0.6 * scrollVelocity + 0.4 * instant;
 	}
-	else
-	{
-		// --- 3.   ---
-		if (newFirst > firstVisibleIndex)
-		{
-			int shift = newFirst - firstVisibleIndex;
-			shift = qMin(shift, visibleWidgets.size());
-
-			for (int i = 0; i < shift; ++i)
-			{
-				ThumbnailWidget* w = visibleWidgets.takeFirst();
-				visibleWidgets.append(w);
-			}
-		}
-		// --- 4.   ---
-		else if (newFirst < firstVisibleIndex)
-		{
-			int shift = firstVisibleIndex - newFirst;
-			shift = qMin(shift, visibleWidgets.size());
-
-			for (int i = 0; i < shift; ++i)
-			{
-				ThumbnailWidget* w = visibleWidgets.takeLast();
-				visibleWidgets.prepend(w);
-			}
-		}
+	else {
+		scrollVelocity = 0.0;
+	}
+	lastScrollValue = value;
 
-		firstVisibleIndex = newFirst;
-		lastVisibleIndex = newLast;
+	settleTimer->start();
+	updateVisibleRange();
+}
 
-		// --- 5.     ---
-		for (int i = 0; i < visibleWidgets.size(); ++i)
-		{
-			int fileIndex = firstVisibleIndex + i;
-			if (fileIndex > lastVisibleIndex)
-				break;
+void PreviewArea::onScrollSettled()
+{
+	scrollVelocity = 0.0;
+	updateDecodeFocus();
+}
 
-			ThumbnailWidget* w = visibleWidgets[i];
-			w->setIndex(fileIndex);
+//      ,    :
+//   ,     
+void PreviewArea::updateDecodeFocus()
+{
+	const int count = itemCount();
+	if (count == 0 || currentColumns == 0)
+		return;
 
-			if (!thumbnails[fileIndex].isNull())
-			{
-				w->setPixmap(thumbnails[fileIndex]);
-				w->setText("");
-			}
-			else
-			{
-				w->setPixmap(QPixmap());
-				w->setText(filenames[fileIndex]);
-			}
+	const int viewportHeight = viewport()->height();
+	const bool fast = qAbs(scrollVelocity) > viewportHeight * FAST_SCROLL_SCREENS;
 
-			w->setSelected(selectedIndices.contains(fileIndex));
-		}
+	int scrollTop = verticalScrollBar()->value();
+	if (fast) {
+		const double predicted = scrollTop + scrollVelocity * FLING_DECAY_SECONDS;
+		scrollTop = qBound(0, int(predicted), verticalScrollBar()->maximum());
 	}
 
-	// --- 6.  () ---
-	for (int i = 0; i < visibleWidgets.size(); ++i)
-	{
-		int fileIndex = firstVisibleIndex + i;
-		if (fileIndex > lastVisibleIndex)
-			break;
+	const int first = rowFirst(rowAtY(scrollTop));
+	const int last = rowEnd(rowAtY(scrollTop + viewportHeight)) - 1;
 
-		int row = fileIndex / currentColumns;
-		int col = fileIndex % currentColumns;
+	if (first == focusFirst && last == focusLast && fast == focusFast)
+		return;
 
-		int x = col * (thumbnailSize + spacing) + spacing / 2;
-		int y = row * (thumbnailSize + spacing) + spacing / 2;
+	focusFirst = first;
+	focusLast = last;
+	focusFast = fast;
 
-		visibleWidgets[i]->setGeometry(x, y, thumbnailSize, thumbnailSize);
+	QVector<int> indices;
+	indices.reserve(last - first + 1);
+	for (int position = first; position <= last; ++position) {
+		indices.append(itemAt(position));
 	}
+	emit decodeFocusChanged(indices, fast);
+}
 
-	emit visibleRangeChanged(firstVisibleIndex, lastVisibleIndex);
+int PreviewArea::rowCount() const
+{
+	if (tableLayout())
+		return rows.size();
+	return (itemCount() + currentColumns - 1) / currentColumns;
+}
+
+int PreviewArea::rowFirst(int row) const
+{
+	if (tableLayout())
+		return rows[row].first;
+	return row * currentColumns;
+}
+
+int PreviewArea::rowTop(int row) const
+{
+	if (tableLayout())
+		return rows[row].top;
+	return row * (thumbnailSize + spacing) + spacing / 2;
+}
+
+int PreviewArea::rowHeight(int row) const
+{
+	if (tableLayout())
+		return rows[row].height;
+	return thumbnailSize;
 }
 
+// O(log n):  ,    position
+int PreviewArea::rowOf(int position) const
+{
+	if (!tableLayout())
+		return position / currentColumns;
+
+	const auto it = std::upper_bound(rows.constBegin(), rows.constEnd(), position,
+		[](int p, const Row& row) { return p < row.first; });
+	return qMax(0, int(it - rows.constBegin()) - 1);
+}
 
-//    
-ThumbnailWidget* PreviewArea::createThumbnailWidget(int index)
+// O(log n):  ,     y
+int PreviewArea::rowAtY(int y) const
 {
-	ThumbnailWidget* widget = new ThumbnailWidget(index, container);
-	widget->setFixedSize(thumbnailSize, thumbnailSize);
+	const int last = rowCount() - 1;
+	if (!tableLayout())
+		return qBound(0, y / (thumbnailSize + spacing), qMax(0, last));
+
+	const auto it = std::upper_bound(rows.constBegin(), rows.constEnd(), y,
+		[](int value, const Row& row) { return value < row.top; });
+	return qBound(0, int(it - rows.constBegin()) - 1, qMax(0, last));
+}
+
+int PreviewArea::contentHeight() const
+{
+	const int count = rowCount();
+	if (count == 0)
+		return 0;
+	return rowTop(count - 1) + rowHeight(count - 1) + spacing;
+}
+
+void PreviewArea::updateLayout()
+{
+	updateColumns();
+
+	layoutTimer->stop();
+	dirtyFirst = -1;
+	dirtyLast = -1;
 
-	if (!thumbnails[index].isNull()) {
-		widget->setPixmap(thumbnails[index]);
-		widget->setText("");
+	rows.clear();
+	headers.clear();
+	if (tableLayout()) {
+		layoutRows(0);
 	}
 	else {
-		widget->setText(filenames[index]);
+		cellLeft.clear();
+		cellWidth.clear();
 	}
+}
+
+//  :  ,    thumbnailSize
+//    ,     ; 
+//    .   :  currentColumns
+// .    -  .
+//   fromRow  .       ,
+//       ,  
+//    -      .
+void PreviewArea::layoutRows(int fromRow)
+{
+	const int count = itemCount();
+	const bool justified = layoutMode == JustifiedLayout;
+	const int available = qMax(thumbnailSize, viewport()->width() - spacing);
+	const int right = spacing / 2 + available;
+
+	cellLeft.resize(count);
+	cellWidth.resize(count);
+
+	fromRow = rows.isEmpty() ? 0 : qBound(0, fromRow, rows.size() - 1);
+	QVector<Row> oldRows = rows.mid(fromRow);
+	rows.resize(fromRow);
+
+	int position = oldRows.isEmpty() ? 0 : oldRows.first().first;
+	int top = rows.isEmpty() ? spacing / 2 : rows.last().top + rows.last().height + spacing;
+	int old = 0;
+
+	//    position 
+	const auto firstHeader = std::lower_bound(headers.begin(), headers.end(), position,
+		[](const Header& header, int p) { return header.position < p; });
+	const QVector<Header> oldHeaders = headers.mid(int(firstHeader - headers.begin()));
+	headers.erase(firstHeader, headers.end());
+
+	int group = int(std::lower_bound(groupStarts.constBegin(), groupStarts.constEnd(), position)
+		- groupStarts.constBegin());
+
+	auto aspectAt = [this](int p) {
+		const float ratio = aspectRatios[itemAt(p)];
+		return ratio > 0 ? qBound(MIN_ASPECT_RATIO, ratio, MAX_ASPECT_RATIO) : 1.0f;
+	};
+
+	while (position < count) {
+		if (group < groupStarts.size() && groupStarts[group] == position) {
+			headers.append({ position, top });
+			top += GROUP_HEADER_HEIGHT;
+			++group;
+		}
+		const int groupEnd = group < groupStarts.size() ? groupStarts[group] : count;
+
+		//    
+		while (old < oldRows.size() && oldRows[old].first < position) ++old;
+		if (old < oldRows.size() && oldRows[old].first == position && position > dirtyLast) {
+			const int shift = top - oldRows[old].top;
+			for (int i = old; i < oldRows.size(); ++i) {
+				Row row = oldRows[i];
+				row.top += shift;
+				rows.append(row);
+			}
+			for (Header header : oldHeaders) {
+				if (header.position > position) {
+					header.top += shift;
+					headers.append(header);
+				}
+			}
+			return;
+		}
 
-	widget->setSelected(selectedIndices.contains(index));
+		const int first = position;
+		int height = thumbnailSize;
 
-	connect(widget, &ThumbnailWidget::clicked,
-		this, &PreviewArea::onThumbnailWidgetClicked);
-	connect(widget, &ThumbnailWidget::doubleClicked,
-		this, &PreviewArea::onThumbnailWidgetDoubleClicked);
+		if (justified) {
+			double sum = 0.0;
+			bool full = false;
+			while (position < groupEnd && !full) {
+				sum += aspectAt(position);
+				++position;
+				full = sum * thumbnailSize + (position - first - 1) * spacing >= available;
+			}
 
-	widget->show();
-	return widget;
+			const int gaps = (position - first - 1) * spacing;
+			if (full) {
+				height = qMax(1, int((available - gaps) / sum));
+			}
+
+			int x = spacing / 2;
+			for (int p = first; p < position; ++p) {
+				int width = qMax(1, qRound(aspectAt(p) * height));
+				if (full && p == position - 1) {
+					width = qMax(1, right - x);		//    
+				}
+				cellLeft[p] = x;
+				cellWidth[p] = width;
+				x += width + spacing;
+			}
+		}
+		else {
+			position = qMin(groupEnd, first + currentColumns);
+			for (int p = first; p < position; ++p) {
+				cellLeft[p] = (p - first) * (thumbnailSize + spacing) + spacing / 2;
+				cellWidth[p] = thumbnailSize;
+			}
+		}
+
+		rows.append({ first, top, height });
+		top += height + spacing;
+	}
 }
 
-QRect PreviewArea::getWidgetGeometry(int index) const
+QRect PreviewArea::cellRect(int position) const
 {
-	int row = index / currentColumns;
-	int col = index % currentColumns;
+	const int offset = verticalScrollBar()->value();
+	if (tableLayout()) {
+		if (position < 0 || position >= cellLeft.size() || rows.isEmpty())
+			return QRect();
+		const Row &row = rows[rowOf(position)];
+		return QRect(cellLeft[position], row.top - offset, cellWidth[position], row.height);
+	}
+
+	int row = position / currentColumns;
+	int col = position % currentColumns;
 	int x = col * (thumbnailSize + spacing) + spacing / 2;
-	int y = row * (thumbnailSize + spacing) + spacing / 2;
+	int y = row * (thumbnailSize + spacing) + spacing / 2 - offset;
 	return QRect(x, y, thumbnailSize, thumbnailSize);
 }
 
-void PreviewArea::setThumbnail(int index, const QPixmap& pixmap)
+//  - O(1):    ,    - .
+//   - O(log n): ,    
+int PreviewArea::positionAt(const QPoint& pos) const
 {
-	if (index < 0 || index >= totalCount) return;
+	if (tableLayout()) {
+		if (rows.isEmpty())
+			return -1;
+		const int y = pos.y() + verticalScrollBar()->value();
+		const int row = rowAtY(y);
+		if (y < rows[row].top || y >= rows[row].top + rows[row].height)
+			return -1;
+
+		const auto begin = cellLeft.constBegin() + rowFirst(row);
+		const auto end = cellLeft.constBegin() + rowEnd(row);
+		const auto it = std::upper_bound(begin, end, pos.x());
+		if (it == begin)
+			return -1;
+		const int position = int(it - cellLeft.constBegin()) - 1;
+		return pos.x() < cellLeft[position] + cellWidth[position] ? position : -1;
+	}
 
-	//   
-	thumbnails[index] = pixmap;
+	const int step = thumbnailSize + spacing;
+	const int x = pos.x() - spacing / 2;
+	const int y = pos.y() + verticalScrollBar()->value() - spacing / 2;
+	if (x < 0 || y < 0)
+		return -1;
 
-	//  ,   
-	int offset = index - firstVisibleIndex;
-	if (offset >= 0 && offset < visibleWidgets.size()) {
-		ThumbnailWidget* widget = visibleWidgets[offset];
-		if (widget) {
-			widget->setPixmap(pixmap);
-			widget->setText("");
-		}
-	}
+	const int col = x / step;
+	const int row = y / step;
+	if (col >= currentColumns || x % step >= thumbnailSize || y % step >= thumbnailSize)
+		return -1;
+
+	const int position = row * currentColumns + col;
+	return position < itemCount() ? position : -1;
 }
 
-void PreviewArea::setFilename(int index, const QString& filename)
+int PreviewArea::indexAt(const QPoint& pos) const
 {
-	if (index < 0 || index >= totalCount) return;
-	filenames[index] = filename;
-	
-	//    ,   
-	int offset = index - firstVisibleIndex;
-	if (offset >= 0 && offset < visibleWidgets.size()) {
-		ThumbnailWidget* widget = visibleWidgets[offset];
-		if (widget && thumbnails[index].isNull()) {
-			widget->setText(filename);
-		}
-	}
+	const int position = positionAt(pos);
+	return position >= 0 ? itemAt(position) : -1;
 }
 
-int PreviewArea::indexAt(const QPoint& pos) const
+void PreviewArea::updateCell(int index)
 {
-	QPoint containerPos = container->mapFrom(this, pos);
+	const int position = positionOf(index);
+	if (position < 0)
+		return;
 
-	for (int i = 0; i < visibleWidgets.size(); ++i) {
-		if (visibleWidgets[i] && visibleWidgets[i]->geometry().contains(containerPos)) {
-			return firstVisibleIndex + i;
-		}
+	const QRect rect = cellRect(position);
+	if (rect.intersects(viewport()->rect())) {
+		viewport()->update(rect);
 	}
-	return -1;
 }
 
-void PreviewArea::updateContainerSize()
+void PreviewArea::paintEvent(QPaintEvent *event)
 {
-	if (totalCount == 0 || currentColumns == 0) {
-		widget()->setFixedHeight(0);
+	PerfTimer paintTimer(PerfStats::Paint);
+	QPainter painter(viewport());
+	const QRect area = event->rect();
+
+	//     
+	painter.fillRect(area, hasSelection() ? QColor("#f5f5f5") : QColor("#fafafa"));
+
+	const int count = itemCount();
+	if (count == 0 || currentColumns == 0)
 		return;
+
+	const int offset = verticalScrollBar()->value();
+
+	//  ,   
+	auto header = std::lower_bound(headers.constBegin(), headers.constEnd(), area.top() + offset - GROUP_HEADER_HEIGHT,
+		[](const Header& h, int y) { return h.top < y; });
+	for (; header != headers.constEnd() && header->top - offset <= area.bottom(); ++header) {
+		const QRect band(spacing / 2, header->top - offset, viewport()->width() - spacing, GROUP_HEADER_HEIGHT - spacing / 2);
+		const auto next = std::upper_bound(groupStarts.constBegin(), groupStarts.constEnd(), header->position);
+		const int end = next != groupStarts.constEnd() ? *next : count;
+		const int group = groupOf.value(itemAt(header->position), -1);
+
+		painter.setPen(QColor("#cccccc"));
+		painter.drawLine(band.bottomLeft(), band.bottomRight());
+		QFont font = painter.font();
+		font.setBold(true);
+		painter.setFont(font);
+		painter.setPen(palette().color(QPalette::Text));
+		painter.drawText(band.adjusted(4, 0, -4, 0), Qt::AlignLeft | Qt::AlignVCenter,
+			QString("%1 (%2)").arg(groupNames.value(group)).arg(end - header->position));
+		font.setBold(false);
+		painter.setFont(font);
 	}
 
-	int rows = (totalCount + currentColumns - 1) / currentColumns;
-	int totalHeight = rows * (thumbnailSize + spacing) + spacing;
-	widget()->setFixedHeight(totalHeight);
-	widget()->setFixedWidth(viewport()->width());
+	//  ,   
+	const int firstRow = rowAtY(area.top() + offset);
+	const int lastRow = rowAtY(area.bottom() + offset);
+
+	const QColor selectedBorder("#2196F3");
+	const QColor selectedBackground("#e3f2fd");
+	const QColor normalBorder("#cccccc");
+	const QColor normalBackground("#f0f0f0");
+	const QColor hoverBorder("#90caf9");
+
+	for (int row = firstRow; row <= lastRow; ++row) {
+		for (int position = rowFirst(row); position < rowEnd(row); ++position) {
+			const int index = itemAt(position);
+			const QRect rect = cellRect(position);
+			if (!rect.intersects(area))
+				continue;
+
+			const bool selected = selectedIndices.contains(index);
+			const int border = selected ? 3 : 1;
+
+			painter.fillRect(rect, selected ? selectedBackground : normalBackground);
+			painter.setPen(QPen(selected ? selectedBorder
+				: (index == hoveredIndex ? hoverBorder : normalBorder), border));
+			painter.setBrush(Qt::NoBrush);
+			painter.drawRect(rect.adjusted(border / 2, border / 2, -(border + 1) / 2, -(border + 1) / 2));
+
+			const QRect inner = rect.adjusted(border + 2, border + 2, -border - 2, -border - 2);
+			const QPixmap &pixmap = thumbnails[index];
+			if (!pixmap.isNull()) {
+				//    ;   - ,
+				//    -   
+				QSize size = pixmap.size();
+				if (layoutMode == JustifiedLayout
+					|| size.width() > inner.width() || size.height() > inner.height()) {
+					size.scale(inner.size(), Qt::KeepAspectRatio);
+				}
+				QRect target(QPoint(0, 0), size);
+				target.moveCenter(inner.center());
+				painter.drawPixmap(target, pixmap);
+			}
+			else {
+				painter.setPen(palette().color(QPalette::Text));
+				painter.drawText(inner, Qt::AlignCenter | Qt::TextWrapAnywhere, filenames[index]);
+			}
+		}
+	}
 }
 
-void PreviewArea::recreateVisibleWidgets()
+void PreviewArea::setThumbnail(int index, const QPixmap& pixmap)
 {
-	//   
-	for (auto widget : visibleWidgets) {
-		if (widget) delete widget;
+	if (index < 0 || index >= totalCount) return;
+
+	//      ,   
+	thumbnails[index] = pixmap;
+	updateCell(index);
+}
+
+void PreviewArea::setFilename(int index, const QString& filename)
+{
+	if (index < 0 || index >= totalCount) return;
+	filenames[index] = filename;
+
+	if (thumbnails[index].isNull()) {
+		updateCell(index);
 	}
-	visibleWidgets.clear();
+}
 
-	if (totalCount == 0 || firstVisibleIndex < 0) return;
+void PreviewArea::updateScrollBarRange()
+{
+	QScrollBar* bar = verticalScrollBar();
+	const int rowHeight = thumbnailSize + spacing;
 
-	// ,    
+	int totalHeight = contentHeight();
 	int viewportHeight = viewport()->height();
-	int rowsVisible = (viewportHeight + thumbnailSize + spacing - 1) / (thumbnailSize + spacing) + 2; // +2  
-	int widgetsNeeded = rowsVisible * currentColumns;
 
-	//   
-	for (int i = 0; i < widgetsNeeded; ++i) {
-		int fileIndex = firstVisibleIndex + i;
-		if (fileIndex >= totalCount) break;
+	bar->setMinimum(0);
+	bar->setMaximum(qMax(0, totalHeight - viewportHeight));
 
-		ThumbnailWidget* widget = createThumbnailWidget(fileIndex);
-			
-		// 
-		int row = i / currentColumns;
-		int col = i % currentColumns;
-		int x = col * (thumbnailSize + spacing) + spacing / 2;
-		int y = row * (thumbnailSize + spacing) + spacing / 2;
-		widget->setGeometry(x, y, thumbnailSize, thumbnailSize);
-				
-		visibleWidgets.append(widget);
-	}
+	// PageStep =    
+	bar->setPageStep(viewportHeight);
+
+	// SingleStep =   
+	bar->setSingleStep(rowHeight);
 }
 
 void PreviewArea::mousePressEvent(QMouseEvent *event)
 {
+	if (event->button() != Qt::LeftButton) {
+		return;
+	}
+
 	int index = indexAt(event->pos());
 	if (index >= 0) {
-		onThumbnailWidgetClicked(index, event->modifiers());
+		onCellClicked(index, event->modifiers());
 	}
 	else {
 		clearSelection();
@@ -368,36 +759,46 @@ void PreviewArea::mousePressEvent(QMouseEvent *event)
 
 void PreviewArea::mouseDoubleClickEvent(QMouseEvent *event)
 {
+	if (event->button() != Qt::LeftButton) {
+		return;
+	}
+
 	int index = indexAt(event->pos());
 	if (index >= 0) {
-		onThumbnailWidgetDoubleClicked(index);
+		onCellDoubleClicked(index);
 	}
 }
 
-void PreviewArea::setSelection(const QSet<int>& indices)
+void PreviewArea::mouseMoveEvent(QMouseEvent *event)
 {
-	//    
-	for (int index : selectedIndices) {
-		int offset = index - firstVisibleIndex;
-		if (offset >= 0 && offset < visibleWidgets.size()) {
-			if (visibleWidgets[offset]) {
-				visibleWidgets[offset]->setSelected(false);
-			}
-		}
+	const int index = indexAt(event->pos());
+	if (index == hoveredIndex) {
+		return;
 	}
 
-	//   
+	const int previous = hoveredIndex;
+	hoveredIndex = index;
+	updateCell(previous);
+	updateCell(hoveredIndex);
+	viewport()->setCursor(index >= 0 ? Qt::PointingHandCursor : Qt::ArrowCursor);
+}
+
+void PreviewArea::leaveEvent(QEvent *event)
+{
+	QAbstractScrollArea::leaveEvent(event);
+
+	const int previous = hoveredIndex;
+	hoveredIndex = -1;
+	updateCell(previous);
+}
+
+void PreviewArea::setSelection(const IndexSelection& indices)
+{
 	selectedIndices = indices;
-	lastSelectedIndex = selectedIndices.isEmpty() ? -1 : *selectedIndices.begin();
+	lastSelectedIndex = selectedIndices.first();
 
-	for (int index : selectedIndices) {
-		int offset = index - firstVisibleIndex;
-		if (offset >= 0 && offset < visibleWidgets.size()) {
-			if (visibleWidgets[offset]) {
-				visibleWidgets[offset]->setSelected(true);
-			}
-		}
-	}
+	//     -    
+	viewport()->update();
 
 	emit selectionChanged(selectedIndices);
 }
@@ -406,20 +807,32 @@ void PreviewArea::clearSelection()
 {
 	if (selectedIndices.isEmpty()) return;
 
-	for (int index : selectedIndices) {
-		int offset = index - firstVisibleIndex;
-		if (offset >= 0 && offset < visibleWidgets.size()) {
-			if (visibleWidgets[offset]) {
-				visibleWidgets[offset]->setSelected(false);
-			}
-		}
-	}
-
 	selectedIndices.clear();
 	lastSelectedIndex = -1;
+	viewport()->update();
+
 	emit selectionChanged(selectedIndices);
 }
 
+void PreviewArea::selectAll()
+{
+	setSelection(itemsInRange(0, itemCount() - 1));
+}
+
+void PreviewArea::invertSelection()
+{
+	const IndexSelection shown = itemsInRange(0, itemCount() - 1);
+	setSelection((selectedIndices - shown) | (shown - selectedIndices));
+}
+
+IndexSelection PreviewArea::getShownSelection() const
+{
+	if (!isFiltered() || selectedIndices.isEmpty()) {
+		return selectedIndices;
+	}
+	return selectedIndices & itemsInRange(0, itemCount() - 1);
+}
+
 QStringList PreviewArea::getSelectedFilenames() const
 {
 	QStringList result;
@@ -433,34 +846,104 @@ QStringList PreviewArea::getSelectedFilenames() const
 
 void PreviewArea::resizeEvent(QResizeEvent *event)
 {
-	QScrollArea::resizeEvent(event);
+	QAbstractScrollArea::resizeEvent(event);
+	updateLayout();
 	updateScrollBarRange();
-	updateScrollStep();
-	updateColumns();
-	updateContainerSize();
 	updateVisibleRange();
+	viewport()->update();
 }
 
 void PreviewArea::scrollContentsBy(int dx, int dy)
 {
-	QScrollArea::scrollContentsBy(dx, dy);
-	
-	//       
-	scrollTimer->start();
+	Q_UNUSED(dx);
+
+	//   ,    
+	viewport()->scroll(0, dy);
 }
 
-void PreviewArea::onThumbnailLoaded(int index, const QPixmap& pixmap)
+void PreviewArea::onThumbnailLoaded(int index, const QPixmap& pixmap, qint64 emittedUs)
 {
+	PerfStats::record(PerfStats::Delivery, PerfStats::now() - emittedUs);
+	PerfStats::add(PerfStats::ThumbnailsDelivered);
+	TraceScope trace("thumbnail_delivered");
+
 	if (index >= 0 && index < totalCount) {
+		//   (     ) -  
+		if (aspectRatios[index] <= 0 && !pixmap.isNull()) {
+			aspectRatios[index] = float(pixmap.width()) / pixmap.height();
+			invalidateAspect(positionOf(index));
+		}
 		setThumbnail(index, pixmap);
 	}
 }
 
-void PreviewArea::onThumbnailWidgetClicked(int index, Qt::KeyboardModifiers modifiers)
+void PreviewArea::onAspectRatiosLoaded(int first, const QVector<float>& ratios)
+{
+	TraceScope trace("aspect_batch", QString::number(ratios.size()));
+	for (int i = 0; i < ratios.size(); ++i) {
+		const int index = first + i;
+		if (index < 0 || index >= totalCount || ratios[i] <= 0 || aspectRatios[index] == ratios[i])
+			continue;
+		aspectRatios[index] = ratios[i];
+		invalidateAspect(positionOf(index));
+	}
+}
+
+//    :   
+void PreviewArea::invalidateAspect(int position)
+{
+	if (layoutMode != JustifiedLayout || position < 0)
+		return;
+
+	dirtyFirst = dirtyFirst < 0 ? position : qMin(dirtyFirst, position);
+	dirtyLast = qMax(dirtyLast, position);
+	if (!layoutTimer->isActive()) {
+		layoutTimer->start();
+	}
+}
+
+void PreviewArea::onLayoutTimer()
+{
+	if (layoutMode != JustifiedLayout || dirtyFirst < 0 || rows.isEmpty()) {
+		dirtyFirst = -1;
+		dirtyLast = -1;
+		return;
+	}
+
+	//      ,    
+	//  
+	const int scrollTop = verticalScrollBar()->value();
+	const int anchorRow = rowAtY(scrollTop);
+	const int anchor = rowFirst(anchorRow);
+	const int anchorOffset = scrollTop - rowTop(anchorRow);
+
+	const int fromRow = rowOf(dirtyFirst);
+	layoutRows(fromRow);
+	dirtyFirst = -1;
+	dirtyLast = -1;
+
+	updateScrollBarRange();
+	if (fromRow <= anchorRow) {
+		verticalScrollBar()->setValue(rowTop(rowOf(anchor)) + anchorOffset);
+	}
+
+	firstVisibleIndex = -1;
+	lastVisibleIndex = -1;
+	focusFirst = -1;
+	focusLast = -1;
+	updateVisibleRange();
+
+	const int top = rowTop(fromRow) - spacing / 2 - verticalScrollBar()->value();
+	if (top < viewport()->height()) {
+		viewport()->update(QRect(0, qMax(0, top), viewport()->width(), viewport()->height()));
+	}
+}
+
+void PreviewArea::onCellClicked(int index, Qt::KeyboardModifiers modifiers)
 {
 	//  
 	if (modifiers == Qt::NoModifier) {
-		clearSelection();
+		selectedIndices.clear();
 		selectedIndices.insert(index);
 		lastSelectedIndex = index;
 	}
@@ -474,87 +957,118 @@ void PreviewArea::onThumbnailWidgetClicked(int index, Qt::KeyboardModifiers modi
 		}
 	}
 	else if (modifiers & Qt::ShiftModifier && lastSelectedIndex != -1) {
-		int start = qMin(lastSelectedIndex, index);
-		int end = qMax(lastSelectedIndex, index);
-		for (int i = start; i <= end; ++i) {
-			selectedIndices.insert(i);
-		}
+		//  -     (   )
+		int from = positionOf(lastSelectedIndex);
+		int to = positionOf(index);
+		if (from < 0) from = to;
+		selectedIndices = selectedIndices | itemsInRange(qMin(from, to), qMax(from, to));
 	}
 
 	//   
+	const int anchor = lastSelectedIndex;
 	setSelection(selectedIndices);
+	lastSelectedIndex = anchor;
 	emit thumbnailClicked(index, modifiers);
 }
 
-void PreviewArea::onThumbnailWidgetDoubleClicked(int index)
+void PreviewArea::onCellDoubleClicked(int index)
 {
 	emit thumbnailDoubleClicked(index);
 }
 
-void PreviewArea::updateBackgroundStyle()
-{
-	//       
-	QString style = QString(
-		"QWidget {"
-		"    background-color: %1;"
-		"    border: %2;"
-		"}"
-	).arg(hasSelection() ? "#f5f5f5" : "#fafafa")
-		.arg(hasSelection() ? "1px solid #e0e0e0" : "1px dashed #e0e0e0");
-
-	container->setStyleSheet(style);
-}
-
 void PreviewArea::removeFiles(const QList<int>& removedIndices)
 {
-	if (removedIndices.isEmpty()) return;
-
-	qDebug() << "PreviewArea::removeFiles" << removedIndices;
-
-	//    
-	QList<int> sortedIndices = removedIndices;
-	std::sort(sortedIndices.begin(), sortedIndices.end());
-
-	// 1.    (  )
-	for (int i = sortedIndices.size() - 1; i >= 0; --i) {
-		int index = sortedIndices[i];
-		filenames.removeAt(index);
-		thumbnails.removeAt(index);
+	const QVector<int> removed = sortedRemovalIndices(removedIndices, totalCount);
+	if (removed.isEmpty()) return;
+
+	qDebug() << "PreviewArea::removeFiles" << removed.size() << "of" << totalCount;
+
+	//    (  );    
+	// .     
+	int firstChanged = itemCount();
+	for (int index : removed) {
+		const int position = positionOf(index);
+		if (position >= 0) {
+			firstChanged = qMin(firstChanged, position);
+		}
 	}
 
-	// 2.   
-	int oldTotal = totalCount;
-	totalCount = filenames.size();
-	int removedCount = oldTotal - totalCount;
+	//  :  ,   
+	//     
+	if (!sortOrder.isEmpty()) {
+		int kept = 0;
+		for (int i = 0; i < sortOrder.size(); ++i) {
+			const int index = sortOrder[i];
+			const auto it = std::lower_bound(removed.constBegin(), removed.constEnd(), index);
+			if (it != removed.constEnd() && *it == index)
+				continue;
+			sortOrder[kept++] = index - int(it - removed.constBegin());
+		}
+		sortOrder.resize(kept);
+	}
 
-	// 3.  
-	QSet<int> newSelected;
-	for (int selIndex : selectedIndices) {
-		int newIndex = selIndex;
-		for (int removedIndex : sortedIndices) {
-			if (selIndex > removedIndex) {
-				newIndex--;
-			}
+	// 1.       (  ):
+	//      
+	const int oldTotal = totalCount;
+	const bool filtered = !filterMask.isEmpty();
+	const bool grouped = groupOf.size() == oldTotal;
+	int write = removed.first();
+	int next = 0;
+	for (int read = write; read < oldTotal; ++read) {
+		if (next < removed.size() && removed[next] == read) {
+			++next;
+			continue;
 		}
-		if (newIndex >= 0 && newIndex < totalCount) {
-			newSelected.insert(newIndex);
+		filenames[write] = std::move(filenames[read]);
+		thumbnails[write] = std::move(thumbnails[read]);
+		aspectRatios[write] = aspectRatios[read];
+		if (grouped) {
+			groupOf[write] = groupOf[read];
+		}
+		if (filtered) {
+			const quint64 bit = quint64(1) << (write & 63);
+			if ((filterMask[read >> 6] >> (read & 63)) & 1)
+				filterMask[write >> 6] |= bit;
+			else
+				filterMask[write >> 6] &= ~bit;
 		}
+		++write;
 	}
-	selectedIndices = newSelected;
-	lastSelectedIndex = selectedIndices.isEmpty() ? -1 : *selectedIndices.begin();
-
-	// 4.     
-//	shiftIndicesAfterRemoval(removedCount);
-
-	// 5.   
-	updateContainerSize();
+	filenames.resize(write);
+	thumbnails.resize(write);
+	aspectRatios.resize(write);
+	if (grouped) {
+		groupOf.resize(write);
+	}
+	totalCount = write;
+	if (filtered) {
+		filterMask.resize(qMax(1, (totalCount + 63) / 64));
+	}
+	rebuildProjection();
+	updateLayout();
 
-	// 6.   
-	recreateVisibleWidgets();
+	// 2.    -     
+	selectedIndices.removeIndices(removed);
+	lastSelectedIndex = selectedIndices.first();
+	hoveredIndex = -1;
 
-	//     
+	// 3.   ;     
+	//     
+	updateScrollBarRange();
+	firstVisibleIndex = -1;
+	lastVisibleIndex = -1;
+	focusFirst = -1;
+	focusLast = -1;
 	updateVisibleRange();
 
+	//         -  
+	const int changedRow = rowCount() > 0 ? rowOf(qMin(firstChanged, itemCount() - 1)) : 0;
+	const int top = rowCount() > 0 && groupStarts.isEmpty()
+		? qMax(0, rowTop(changedRow) - spacing / 2 - verticalScrollBar()->value()) : 0;
+	if (top < viewport()->height()) {
+		viewport()->update(QRect(0, top, viewport()->width(), viewport()->height() - top));
+	}
+
 	emit selectionChanged(selectedIndices);
 }
 
@@ -563,33 +1077,6 @@ void PreviewArea::removeFile(int index)
 	removeFiles({ index });
 }
 
-void PreviewArea::shiftIndicesAfterRemoval(int removedCount)
-{
-	//   firstVisibleIndex
-	firstVisibleIndex -= removedCount;
-	if (firstVisibleIndex < 0) firstVisibleIndex = 0;
-
-	//     
-	for (int i = 0; i < visibleWidgets.size(); ++i) {
-		if (visibleWidgets[i]) {
-			int newIndex = firstVisibleIndex + i;
-			visibleWidgets[i]->setIndex(newIndex);
-
-			//   
-			if (newIndex < totalCount) {
-				if (!thumbnails[newIndex].isNull()) {
-					visibleWidgets[i]->setPixmap(thumbnails[newIndex]);
-					visibleWidgets[i]->setText("");
-				}
-				else {
-					visibleWidgets[i]->setText(filenames[newIndex]);
-				}
-				visibleWidgets[i]->setSelected(selectedIndices.contains(newIndex));
-			}
-		}
-	}
-}
-
 void PreviewArea::wheelEvent(QWheelEvent *event)
 {
 	int step = thumbnailSize + spacing;
@@ -603,30 +1090,3 @@ void PreviewArea::wheelEvent(QWheelEvent *event)
 	verticalScrollBar()->setValue(newValue);
 	event->accept();
 }
-
-void PreviewArea::updateScrollStep()
-{
-	QScrollBar* vScrollBar = verticalScrollBar();
-	if (!vScrollBar) return;
-
-	int rowHeight = thumbnailSize + spacing;
-	
-	vScrollBar->setSingleStep(rowHeight);
-}
-
-void PreviewArea::updateScrollBarRange()
-{
-	QScrollBar* bar = verticalScrollBar();
-
-	int totalHeight = widget()->height();
-	int viewportHeight = viewport()->height();
-
-	bar->setMinimum(0);
-	bar->setMaximum(qMax(0, totalHeight - viewportHeight));
-
-	// PageStep =    
-	bar->setPageStep(viewportHeight);
-
-	// SingleStep =   
-	bar->setSingleStep(thumbnailSize + spacing);
-}
\ No newline at end of file
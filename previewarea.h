@@ -1,21 +1,36 @@
 #pragma once
 
-#include <QScrollArea>
-#include <QWidget>
-#include <QGridLayout>
+#include <QAbstractScrollArea>
 #include <QVector>
 #include <QString>
 #include <QPixmap>
-#include "ThumbnailWidget.h"
-
-class PreviewArea  : public QScrollArea
+#include <QElapsedTimer>
+#include <QTimer>
+#include "indexselection.h"
+
+//   :     paintEvent,
+//    .      
+//    /,    .
+//         ,
+//     ;    
+//     .
+class PreviewArea  : public QAbstractScrollArea
 {
 	Q_OBJECT
 
 public:
+	enum LayoutMode
+	{
+		GridLayout,			//   thumbnailSize
+		JustifiedLayout		//     thumbnailSize
+	};
+
 	explicit PreviewArea(QWidget *parent);
 	~PreviewArea();
 
+	void setLayoutMode(LayoutMode mode);
+	LayoutMode getLayoutMode() const { return layoutMode; }
+
 	void clearThumbnails();
 
 	//  
@@ -24,82 +39,167 @@ public:
 
 	void removeFiles(const QList<int>& indices);
 	void removeFile(int index);
-			
+
 	//      
 	void setThumbnail(int index, const QPixmap& pixmap);
 	void setFilename(int index, const QString& filename);
-	
+
 	//  
-	void setSelection(const QSet<int>& indices);
+	void setSelection(const IndexSelection& indices);
 	void clearSelection();
-	QSet<int> getSelectedIndices() const { return selectedIndices; }
+	void selectAll();			//  (  -  )
+	void invertSelection();		//   
+	const IndexSelection& getSelectedIndices() const { return selectedIndices; }
+	IndexSelection getShownSelection() const;	//   
 	QStringList getSelectedFilenames() const;
 
+	//  ():  i  -  i ;   -
+	//  . ,       
+	//    
+	void setFilter(const QVector<quint64>& mask);
+	void clearFilter() { setFilter(QVector<quint64>()); }
+	bool isFiltered() const { return !filterMask.isEmpty(); }
+
+	//  : order -     ( -  ).
+	// groupOf -      ( -  ): 
+	//         groupNames[]
+	void setOrder(const QVector<int>& order, const QVector<int>& groupOf = QVector<int>(),
+		const QStringList& groupNames = QStringList());
+
+	//    ->  
+	int itemAt(int position) const { return isProjected() ? projection[position] : position; }
+
+	//     ( viewport)  -1
+	int indexAt(const QPoint& pos) const;
+
 	// 
 	int getTotalCount() const { return totalCount; }
+	int getVisibleCount() const { return itemCount(); }
 	int getThumbnailSize() const { return thumbnailSize; }
-	
+
 signals:
 	//    
 	void thumbnailClicked(int index, Qt::KeyboardModifiers modifiers);
 	void thumbnailDoubleClicked(int index);
 	void selectionCleared();
-	void selectionChanged(const QSet<int>& selectedIndices);
-	void visibleRangeChanged(int first, int last);
+	void selectionChanged(const IndexSelection& selectedIndices);
+	void visibleRangeChanged(int first, int last);	// , . itemAt()
+	//      ( ):  ,
+	//     -     
+	void decodeFocusChanged(const QVector<int>& indices, bool scrollingFast);
 
 public slots:
-	void onThumbnailLoaded(int index, const QPixmap& pixmap);
+	void onThumbnailLoaded(int index, const QPixmap& pixmap, qint64 emittedUs);
+	void onAspectRatiosLoaded(int first, const QVector<float>& ratios);
 
 protected:
+	void paintEvent(QPaintEvent *event) override;
 	void resizeEvent(QResizeEvent *event) override;
 	void scrollContentsBy(int dx, int dy) override;
 	void mousePressEvent(QMouseEvent *event) override;
 	void mouseDoubleClickEvent(QMouseEvent *event) override;
+	void mouseMoveEvent(QMouseEvent *event) override;
+	void leaveEvent(QEvent *event) override;
 	void wheelEvent(QWheelEvent *event) override;
 private:
 	//  
 	int totalCount;
-	int firstVisibleIndex;
+	int firstVisibleIndex;	//    (     )
 	int lastVisibleIndex;
 
-	//   ( )
-	QVector<ThumbnailWidget*> visibleWidgets;  //    
+	//  
+	QElapsedTimer scrollClock;
+	QTimer *settleTimer;		//  
+	int lastScrollValue;
+	double scrollVelocity;		//   , 
+	int focusFirst;				//    
+	int focusLast;
+	bool focusFast;
+
+	//     
+	QVector<quint64> filterMask;	//  ->  ""
+	QVector<int> sortOrder;			//     ( -  )
+	QVector<int> projection;		//  -> 
+	QVector<int> positions;			//  ->  (-1 - )
+
+	// 
+	QVector<int> groupOf;			//  ->  
+	QStringList groupNames;
+	QVector<int> groupStarts;		// ,    
+	struct Header
+	{
+		int position;	//   
+		int top;		//   
+	};
+	QVector<Header> headers;		//    
 
 	//    
 	QVector<QString> filenames;		//    ( -> )
 	QVector<QPixmap> thumbnails;    //    ( -> )
+	QVector<float> aspectRatios;	// / ( -> , 0 - )
+
+	//  
+	struct Row
+	{
+		int first;		//   
+		int top;		//     
+		int height;
+	};
+	LayoutMode layoutMode;
+	QVector<Row> rows;
+	QVector<int> cellLeft;			//  -> x 
+	QVector<int> cellWidth;			//  ->  
+	QTimer *layoutTimer;			//     
+	int dirtyFirst;					//    
+	int dirtyLast;
 
-	// UI 
-	QWidget *container;
-	QTimer *scrollTimer;
-	
 	// 
 	int currentColumns;
 	int thumbnailSize;
 	int spacing;
 
-	// 
-	QSet<int> selectedIndices;
+	//   
+	IndexSelection selectedIndices;
 	int lastSelectedIndex;
+	int hoveredIndex;
 
 	//  
 private:
-	ThumbnailWidget* createThumbnailWidget(int index);
-
-	QRect getWidgetGeometry(int index) const;
-	int indexAt(const QPoint& pos) const;	
-	void updateContainerSize();
+	bool isProjected() const { return !filterMask.isEmpty() || !sortOrder.isEmpty(); }
+	int itemCount() const { return isProjected() ? projection.size() : totalCount; }
+	int positionOf(int index) const { return isProjected() ? positions.value(index, -1) : index; }
+	void rebuildProjection();
+	IndexSelection itemsInRange(int first, int last) const;	//  -> 
+
+	//  :   - ,    
+	//   -  rows   
+	bool tableLayout() const { return layoutMode == JustifiedLayout || !groupStarts.isEmpty(); }
+	int rowCount() const;
+	int rowFirst(int row) const;
+	int rowEnd(int row) const { return row + 1 < rowCount() ? rowFirst(row + 1) : itemCount(); }
+	int rowTop(int row) const;				//   
+	int rowHeight(int row) const;
+	int rowOf(int position) const;
+	int rowAtY(int y) const;				// y  ->  ( )
+	int contentHeight() const;
+
+	void updateLayout();					//  
+	void layoutRows(int fromRow);			//     fromRow
+	void invalidateAspect(int position);
+
+	QRect cellRect(int position) const;		//   viewport
+	int positionAt(const QPoint& pos) const;
+	void updateCell(int index);
 	void updateColumns();
-	void recreateVisibleWidgets();        //    
-	void shiftIndicesAfterRemoval(int removedCount);  //    
-	void updateScrollStep();
 	void updateScrollBarRange();
-	//  
-	void updateBackgroundStyle();
 	bool hasSelection() const { return !selectedIndices.isEmpty(); }
 
 private slots:
-	void onThumbnailWidgetClicked(int index, Qt::KeyboardModifiers modifiers);
-	void onThumbnailWidgetDoubleClicked(int index);
+	void onCellClicked(int index, Qt::KeyboardModifiers modifiers);
+	void onCellDoubleClicked(int index);
 	void updateVisibleRange();
+	void onScrollValueChanged(int value);
+	void onScrollSettled();
+	void onLayoutTimer();
+	void updateDecodeFocus();
 };
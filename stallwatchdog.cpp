@@ -0,0 +1,181 @@
+#include "stallwatchdog.h"
+#include "perfstats.h"
+#include <QTimer>
+#include <QMutex>
+#include <QVector>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QDateTime>
+#include <QDebug>
+#include <atomic>
+
+//       .old
+static const qint64 MAX_LOG_SIZE = 1024 * 1024;
+//         
+static const int MAX_SAMPLES = 8;
+
+namespace
+{
+	struct Operation
+	{
+		const char *name;
+		QString arg;
+	};
+
+	std::atomic<qint64> g_lastBeat(0);		// PerfStats::now(), 0 -  
+	thread_local bool t_guiThread = false;
+
+	//    GUI-,   -   
+	QMutex g_operationMutex;
+	QVector<Operation> g_operations;
+}
+
+StallWatchdog::StallWatchdog(const QString& logPath, int thresholdMs, QObject *parent)
+	: QObject(parent)
+	, m_logPath(logPath)
+	, m_thresholdUs(qint64(thresholdMs) * 1000)
+	, m_timer(nullptr)
+	, m_inStall(false)
+	, m_hangReported(false)
+	, m_stallStart(0)
+{
+}
+
+StallWatchdog::~StallWatchdog()
+{
+}
+
+void StallWatchdog::attachGuiThread()
+{
+	t_guiThread = true;
+	heartbeat();
+}
+
+void StallWatchdog::heartbeat()
+{
+	g_lastBeat.store(PerfStats::now(), std::memory_order_relaxed);
+}
+
+bool StallWatchdog::isGuiThread()
+{
+	return t_guiThread;
+}
+
+void StallWatchdog::enterOperation(const char *name, const QString& arg)
+{
+	if (!t_guiThread) return;
+	QMutexLocker locker(&g_operationMutex);
+	g_operations.append(Operation{ name, arg });
+}
+
+void StallWatchdog::leaveOperation()
+{
+	if (!t_guiThread) return;
+	QMutexLocker locker(&g_operationMutex);
+	if (!g_operations.isEmpty()) {
+		g_operations.removeLast();
+	}
+}
+
+void StallWatchdog::start()
+{
+	if (!m_timer) {
+		m_timer = new QTimer(this);
+		m_timer->setTimerType(Qt::PreciseTimer);
+		m_timer->setInterval(HEARTBEAT_INTERVAL / 2);
+		connect(m_timer, &QTimer::timeout, this, &StallWatchdog::check);
+	}
+	m_inStall = false;
+	m_timer->start();
+}
+
+void StallWatchdog::stop()
+{
+	if (m_timer) {
+		m_timer->stop();
+	}
+}
+
+//      (  ) - .
+//   -    
+void StallWatchdog::check()
+{
+	const qint64 lastBeat = g_lastBeat.load(std::memory_order_relaxed);
+	if (lastBeat == 0) return;
+
+	const qint64 now = PerfStats::now();
+	const bool stalled = now - lastBeat > m_thresholdUs + HEARTBEAT_INTERVAL * 1000;
+
+	if (stalled) {
+		if (!m_inStall) {
+			m_inStall = true;
+			m_hangReported = false;
+			m_stallStart = lastBeat;
+			m_operations.clear();
+		}
+		sampleOperations();
+
+		//       - ,   
+		if (!m_hangReported && now - m_stallStart > HANG_REPORT_MS * 1000) {
+			m_hangReported = true;
+			writeReport((now - m_stallStart) / 1000, false);
+		}
+		return;
+	}
+
+	if (m_inStall && lastBeat != m_stallStart) {
+		m_inStall = false;
+		const qint64 ms = (lastBeat - m_stallStart) / 1000 - HEARTBEAT_INTERVAL;
+		PerfStats::record(PerfStats::GuiStall, ms * 1000);
+		writeReport(ms, true);
+		emit stallDetected(ms, m_operations.join(" ; "));
+	}
+}
+
+void StallWatchdog::sampleOperations()
+{
+	QStringList stack;
+	{
+		QMutexLocker locker(&g_operationMutex);
+		for (const Operation &operation : g_operations) {
+			stack.append(operation.arg.isEmpty() ? QString(operation.name)
+				: QString("%1: %2").arg(operation.name, operation.arg));
+		}
+	}
+
+	const QString sample = stack.isEmpty() ? QString("(not instrumented)") : stack.join(" > ");
+	if (m_operations.size() < MAX_SAMPLES && !m_operations.contains(sample)) {
+		m_operations.append(sample);
+	}
+}
+
+void StallWatchdog::writeReport(qint64 ms, bool finished)
+{
+	qDebug() << "GUI stall:" << ms << "ms" << m_operations;
+	if (m_logPath.isEmpty()) return;
+
+	QFileInfo info(m_logPath);
+	if (info.exists() && info.size() > MAX_LOG_SIZE) {
+		const QString oldPath = m_logPath + ".old";
+		QFile::remove(oldPath);
+		QFile::rename(m_logPath, oldPath);
+	}
+
+	QFile file(m_logPath);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+		qDebug() << "Cannot write stall log:" << m_logPath << file.errorString();
+		return;
+	}
+
+	//      
+	const QDateTime started = QDateTime::currentDateTime()
+		.addMSecs(-(PerfStats::now() - m_stallStart) / 1000);
+
+	QTextStream out(&file);
+	out.setCodec("UTF-8");
+	out << started.toString("yyyy-MM-dd hh:mm:ss.zzz")
+		<< (finished ? "  stall " : "  hang, still running after ")
+		<< ms << " ms  | " << m_operations.join(" ; ") << "\n";
+}
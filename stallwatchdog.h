@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QTimer;
+
+//  GUI-: GUI-  -,   
+//  ,    .     
+//    ,   GUI-   
+// (PerfTimer  StallScope  GUI-).
+class StallWatchdog : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const int HEARTBEAT_INTERVAL = 20;		// 
+	static const int HANG_REPORT_MS = 5000;		// ,   
+
+	StallWatchdog(const QString& logPath, int thresholdMs, QObject *parent = nullptr);
+	~StallWatchdog();
+
+	//   GUI-:     
+	static void attachGuiThread();
+	static void heartbeat();
+	static bool isGuiThread();
+
+	//    GUI- (     )
+	static void enterOperation(const char *name, const QString& arg = QString());
+	static void leaveOperation();
+
+public slots:
+	void start();		//   
+	void stop();
+
+signals:
+	//  :     " > "
+	void stallDetected(qint64 ms, const QString& operations);
+
+private slots:
+	void check();
+
+private:
+	void sampleOperations();
+	void writeReport(qint64 ms, bool finished);
+
+	QString m_logPath;
+	qint64 m_thresholdUs;
+	QTimer *m_timer;
+
+	bool m_inStall;
+	bool m_hangReported;
+	qint64 m_stallStart;		//    
+	QStringList m_operations;	//      
+};
+
+//  GUI-       
+class StallScope
+{
+public:
+	explicit StallScope(const char *name, const QString& arg = QString())
+		: m_active(StallWatchdog::isGuiThread())
+	{
+		if (m_active) {
+			StallWatchdog::enterOperation(name, arg);
+		}
+	}
+	~StallScope()
+	{
+		if (m_active) {
+			StallWatchdog::leaveOperation();
+		}
+	}
+
+private:
+	bool m_active;
+
+	Q_DISABLE_COPY(StallScope)
+};
@@ -0,0 +1,394 @@
+#include "tagbitmap.h"
+#include <algorithm>
+#include <iterator>
+
+// ---------------------------------------------------------------------------
+// Container
+
+bool TagBitmap::Container::contains(quint16 low) const
+{
+	if (isBitmap()) {
+		return (bits[low >> 6] >> (low & 63)) & 1;
+	}
+	return std::binary_search(array.constBegin(), array.constEnd(), low);
+}
+
+bool TagBitmap::Container::add(quint16 low)
+{
+	if (isBitmap()) {
+		quint64 &word = bits[low >> 6];
+		const quint64 mask = quint64(1) << (low & 63);
+		if (word & mask)
+			return false;
+		word |= mask;
+		++cardinality;
+		return true;
+	}
+
+	auto it = std::lower_bound(array.begin(), array.end(), low);
+	if (it != array.end() && *it == low)
+		return false;
+	array.insert(it, low);
+	++cardinality;
+
+	if (cardinality > ARRAY_LIMIT) {
+		toBitmap();
+	}
+	return true;
+}
+
+bool TagBitmap::Container::remove(quint16 low)
+{
+	if (isBitmap()) {
+		quint64 &word = bits[low >> 6];
+		const quint64 mask = quint64(1) << (low & 63);
+		if (!(word & mask))
+			return false;
+		word &= ~mask;
+		--cardinality;
+
+		if (cardinality <= ARRAY_LIMIT / 2) {
+			toArray();
+		}
+		return true;
+	}
+
+	auto it = std::lower_bound(array.begin(), array.end(), low);
+	if (it == array.end() || *it != low)
+		return false;
+	array.erase(it);
+	--cardinality;
+	return true;
+}
+
+QVector<quint64> TagBitmap::Container::words() const
+{
+	if (isBitmap())
+		return bits;
+
+	QVector<quint64> result(BITMAP_WORDS, 0);
+	for (quint16 low : array) {
+		result[low >> 6] |= quint64(1) << (low & 63);
+	}
+	return result;
+}
+
+void TagBitmap::Container::toBitmap()
+{
+	if (isBitmap())
+		return;
+	bits = words();
+	array.clear();
+	array.squeeze();
+}
+
+void TagBitmap::Container::toArray()
+{
+	if (!isBitmap())
+		return;
+
+	array.clear();
+	array.reserve(cardinality);
+	for (int w = 0; w < BITMAP_WORDS; ++w) {
+		quint64 word = bits[w];
+		while (word) {
+			array.append(quint16(w * 64 + qCountTrailingZeroBits(word)));
+			word &= word - 1;
+		}
+	}
+	bits.clear();
+	bits.squeeze();
+}
+
+//     
+void TagBitmap::Container::normalize()
+{
+	if (isBitmap()) {
+		int total = 0;
+		for (quint64 word : bits) {
+			total += qPopulationCount(word);
+		}
+		cardinality = total;
+		if (cardinality <= ARRAY_LIMIT) {
+			toArray();
+		}
+	}
+	else {
+		cardinality = array.size();
+		if (cardinality > ARRAY_LIMIT) {
+			toBitmap();
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+// TagBitmap
+
+int TagBitmap::lowerBound(quint16 key) const
+{
+	int lo = 0;
+	int hi = m_containers.size();
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (m_containers[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+void TagBitmap::add(quint32 value)
+{
+	const quint16 key = quint16(value >> 16);
+	int pos = lowerBound(key);
+	if (pos == m_containers.size() || m_containers[pos].key != key) {
+		Container c;
+		c.key = key;
+		m_containers.insert(pos, c);
+	}
+	m_containers[pos].add(quint16(value & 0xFFFF));
+}
+
+bool TagBitmap::remove(quint32 value)
+{
+	const quint16 key = quint16(value >> 16);
+	int pos = lowerBound(key);
+	if (pos == m_containers.size() || m_containers[pos].key != key)
+		return false;
+
+	Container &c = m_containers[pos];
+	if (!c.remove(quint16(value & 0xFFFF)))
+		return false;
+
+	if (c.cardinality == 0) {
+		m_containers.removeAt(pos);
+	}
+	return true;
+}
+
+bool TagBitmap::contains(quint32 value) const
+{
+	const quint16 key = quint16(value >> 16);
+	int pos = lowerBound(key);
+	if (pos == m_containers.size() || m_containers[pos].key != key)
+		return false;
+	return m_containers[pos].contains(quint16(value & 0xFFFF));
+}
+
+int TagBitmap::count() const
+{
+	int total = 0;
+	for (const Container &c : m_containers) {
+		total += c.cardinality;
+	}
+	return total;
+}
+
+QVector<quint32> TagBitmap::values() const
+{
+	QVector<quint32> result;
+	result.reserve(count());
+	forEach([&result](quint32 value) { result.append(value); });
+	return result;
+}
+
+TagBitmap TagBitmap::operator&(const TagBitmap& other) const
+{
+	return combine(*this, other, OpAnd);
+}
+
+TagBitmap TagBitmap::operator|(const TagBitmap& other) const
+{
+	return combine(*this, other, OpOr);
+}
+
+TagBitmap TagBitmap::operator-(const TagBitmap& other) const
+{
+	return combine(*this, other, OpAndNot);
+}
+
+TagBitmap::Container TagBitmap::combine(const Container& a, const Container& b, Operation op)
+{
+	Container result;
+	result.key = a.key;
+
+	//   -   
+	if (!a.isBitmap() && !b.isBitmap()) {
+		auto out = std::back_inserter(result.array);
+		switch (op) {
+		case OpAnd:
+			std::set_intersection(a.array.constBegin(), a.array.constEnd(),
+				b.array.constBegin(), b.array.constEnd(), out);
+			break;
+		case OpOr:
+			std::set_union(a.array.constBegin(), a.array.constEnd(),
+				b.array.constBegin(), b.array.constEnd(), out);
+			break;
+		case OpAndNot:
+			std::set_difference(a.array.constBegin(), a.array.constEnd(),
+				b.array.constBegin(), b.array.constEnd(), out);
+			break;
+		}
+		result.normalize();
+		return result;
+	}
+
+	//  AND  -  ,   
+	if (op == OpAnd && !a.isBitmap()) {
+		for (quint16 low : a.array) {
+			if (b.contains(low)) result.array.append(low);
+		}
+		result.normalize();
+		return result;
+	}
+	if (op == OpAnd && !b.isBitmap()) {
+		for (quint16 low : b.array) {
+			if (a.contains(low)) result.array.append(low);
+		}
+		result.normalize();
+		return result;
+	}
+
+	//   -   ( )
+	const QVector<quint64> wa = a.words();
+	const QVector<quint64> wb = b.words();
+	result.bits.resize(BITMAP_WORDS);
+	const quint64 *pa = wa.constData();
+	const quint64 *pb = wb.constData();
+	quint64 *pr = result.bits.data();
+
+	switch (op) {
+	case OpAnd:
+		for (int i = 0; i < BITMAP_WORDS; ++i) pr[i] = pa[i] & pb[i];
+		break;
+	case OpOr:
+		for (int i = 0; i < BITMAP_WORDS; ++i) pr[i] = pa[i] | pb[i];
+		break;
+	case OpAndNot:
+		for (int i = 0; i < BITMAP_WORDS; ++i) pr[i] = pa[i] & ~pb[i];
+		break;
+	}
+	result.normalize();
+	return result;
+}
+
+TagBitmap TagBitmap::combine(const TagBitmap& a, const TagBitmap& b, Operation op)
+{
+	TagBitmap result;
+	int i = 0;
+	int j = 0;
+
+	while (i < a.m_containers.size() && j < b.m_containers.size()) {
+		const Container &ca = a.m_containers[i];
+		const Container &cb = b.m_containers[j];
+
+		if (ca.key < cb.key) {
+			if (op != OpAnd) result.m_containers.append(ca);
+			++i;
+		}
+		else if (cb.key < ca.key) {
+			if (op == OpOr) result.m_containers.append(cb);
+			++j;
+		}
+		else {
+			Container c = combine(ca, cb, op);
+			if (c.cardinality > 0) result.m_containers.append(c);
+			++i;
+			++j;
+		}
+	}
+
+	// 
+	if (op != OpAnd) {
+		for (; i < a.m_containers.size(); ++i) result.m_containers.append(a.m_containers[i]);
+	}
+	if (op == OpOr) {
+		for (; j < b.m_containers.size(); ++j) result.m_containers.append(b.m_containers[j]);
+	}
+
+	return result;
+}
+
+QDataStream& operator<<(QDataStream& out, const TagBitmap& bitmap)
+{
+	out << quint32(bitmap.m_containers.size());
+	for (const TagBitmap::Container &c : bitmap.m_containers) {
+		out << c.key << qint32(c.cardinality) << c.isBitmap();
+		if (c.isBitmap())
+			out << c.bits;
+		else
+			out << c.array;
+	}
+	return out;
+}
+
+//     :      
+//  ,  - ReadCorruptData ( )
+QDataStream& operator>>(QDataStream& in, TagBitmap& bitmap)
+{
+	bitmap.m_containers.clear();
+
+	auto corrupt = [&in, &bitmap]() -> QDataStream& {
+		bitmap.m_containers.clear();
+		in.setStatus(QDataStream::ReadCorruptData);
+		return in;
+	};
+
+	//   16- -  65536   
+	quint32 size = 0;
+	in >> size;
+	if (size > 0x10000) {
+		return corrupt();
+	}
+	bitmap.m_containers.reserve(int(size));
+
+	for (quint32 i = 0; i < size && in.status() == QDataStream::Ok; ++i) {
+		TagBitmap::Container c;
+		qint32 cardinality = 0;
+		bool isBitmap = false;
+		quint32 length = 0;
+		in >> c.key >> cardinality >> isBitmap >> length;
+		if (in.status() != QDataStream::Ok) {
+			break;
+		}
+		if (!bitmap.m_containers.isEmpty() && c.key <= bitmap.m_containers.last().key) {
+			return corrupt();
+		}
+
+		if (isBitmap) {
+			if (length != quint32(TagBitmap::BITMAP_WORDS)) {
+				return corrupt();
+			}
+			c.bits.resize(TagBitmap::BITMAP_WORDS);
+			for (quint64 &word : c.bits) {
+				in >> word;
+			}
+		}
+		else {
+			if (length > 0x10000) {
+				return corrupt();
+			}
+			c.array.resize(int(length));
+			for (int k = 0; k < c.array.size(); ++k) {
+				in >> c.array[k];
+				//  -    ( )
+				if (k > 0 && c.array[k] <= c.array[k - 1]) {
+					return corrupt();
+				}
+			}
+		}
+		if (in.status() != QDataStream::Ok) {
+			break;
+		}
+
+		c.normalize();
+		if (c.cardinality > 0)
+			bitmap.m_containers.append(c);
+	}
+
+	if (in.status() != QDataStream::Ok) {
+		bitmap.m_containers.clear();
+	}
+	return in;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QVector>
+#include <QDataStream>
+#include <QtAlgorithms>
+
+//     (  roaring bitmap).
+//  16    ,  16  
+//    ( ),   .
+class TagBitmap
+{
+public:
+	TagBitmap() {}
+
+	//    
+	void add(quint32 value);
+	bool remove(quint32 value);
+	bool contains(quint32 value) const;
+
+	int count() const;
+	bool isEmpty() const { return m_containers.isEmpty(); }
+	void clear() { m_containers.clear(); }
+
+	//  
+	TagBitmap operator&(const TagBitmap& other) const;
+	TagBitmap operator|(const TagBitmap& other) const;
+	TagBitmap operator-(const TagBitmap& other) const;	// AND NOT
+	TagBitmap& operator&=(const TagBitmap& other) { *this = *this & other; return *this; }
+	TagBitmap& operator|=(const TagBitmap& other) { *this = *this | other; return *this; }
+	TagBitmap& operator-=(const TagBitmap& other) { *this = *this - other; return *this; }
+
+	QVector<quint32> values() const;
+
+	//       
+	template<typename Func>
+	void forEach(Func func) const;
+
+	friend QDataStream& operator<<(QDataStream& out, const TagBitmap& bitmap);
+	friend QDataStream& operator>>(QDataStream& in, TagBitmap& bitmap);
+
+private:
+	static const int ARRAY_LIMIT = 4096;	//  -    
+	static const int BITMAP_WORDS = 1024;	// 65536 
+
+	struct Container
+	{
+		quint16 key = 0;
+		int cardinality = 0;
+		QVector<quint16> array;		//   
+		QVector<quint64> bits;		//   (  )
+
+		bool isBitmap() const { return !bits.isEmpty(); }
+		bool contains(quint16 low) const;
+		bool add(quint16 low);
+		bool remove(quint16 low);
+		void toBitmap();
+		void toArray();
+		void normalize();
+		QVector<quint64> words() const;
+	};
+
+	QVector<Container> m_containers;	//   key
+
+	int lowerBound(quint16 key) const;
+
+	enum Operation { OpAnd, OpOr, OpAndNot };
+	static Container combine(const Container& a, const Container& b, Operation op);
+	static TagBitmap combine(const TagBitmap& a, const TagBitmap& b, Operation op);
+};
+
+template<typename Func>
+void TagBitmap::forEach(Func func) const
+{
+	for (const Container& c : m_containers) {
+		const quint32 high = quint32(c.key) << 16;
+		if (c.isBitmap()) {
+			for (int w = 0; w < BITMAP_WORDS; ++w) {
+				quint64 word = c.bits[w];
+				while (word) {
+					func(high | quint32(w * 64 + qCountTrailingZeroBits(word)));
+					word &= word - 1;
+				}
+			}
+		}
+		else {
+			for (quint16 low : c.array) {
+				func(high | low);
+			}
+		}
+	}
+}
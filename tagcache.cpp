@@ -0,0 +1,91 @@
+#include "tagcache.h"
+
+void TagCache::split(const QString& path, QString& dir, QString& name)
+{
+	const int slash = path.lastIndexOf('/');
+	dir = path.left(slash);
+	name = path.mid(slash + 1);
+}
+
+void TagCache::clear()
+{
+	m_dirs.clear();
+	m_size = 0;
+}
+
+bool TagCache::contains(const QString& path) const
+{
+	QString dir, name;
+	split(path, dir, name);
+	auto it = m_dirs.constFind(dir);
+	return it != m_dirs.constEnd() && it.value().contains(name);
+}
+
+bool TagCache::value(const QString& path, TagSet& tags) const
+{
+	QString dir, name;
+	split(path, dir, name);
+	auto it = m_dirs.constFind(dir);
+	if (it == m_dirs.constEnd()) {
+		return false;
+	}
+	auto entry = it.value().constFind(name);
+	if (entry == it.value().constEnd()) {
+		return false;
+	}
+	tags = entry.value();
+	return true;
+}
+
+void TagCache::insert(const QString& path, const TagSet& tags)
+{
+	QString dir, name;
+	split(path, dir, name);
+
+	//         
+	Dir &objects = m_dirs[dir];
+	const int before = objects.size();
+	objects.insert(name, tags);
+	m_size += objects.size() - before;
+}
+
+QVector<QPair<QString, TagSet>> TagCache::take(const QString& path)
+{
+	QVector<QPair<QString, TagSet>> taken;
+
+	//   -  -
+	QString parent, name;
+	split(path, parent, name);
+	auto it = m_dirs.find(parent);
+	if (it != m_dirs.end()) {
+		auto entry = it.value().find(name);
+		if (entry != it.value().end()) {
+			taken.append(qMakePair(path, entry.value()));
+			it.value().erase(entry);
+			if (it.value().isEmpty()) {
+				m_dirs.erase(it);
+			}
+		}
+	}
+
+	// :   path    "path/..."
+	auto takeDir = [this, &taken](QMap<QString, Dir>::iterator dir) {
+		for (auto entry = dir.value().constBegin(); entry != dir.value().constEnd(); ++entry) {
+			taken.append(qMakePair(dir.key() + '/' + entry.key(), entry.value()));
+		}
+		return m_dirs.erase(dir);
+	};
+
+	auto dir = m_dirs.find(path);
+	if (dir != m_dirs.end()) {
+		takeDir(dir);
+	}
+	const QString prefix = path + '/';
+	dir = m_dirs.lowerBound(prefix);
+	while (dir != m_dirs.end() && dir.key().startsWith(prefix)) {
+		dir = takeDir(dir);
+	}
+
+	m_size -= taken.size();
+	return taken;
+}
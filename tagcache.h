@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include "tagdictionary.h"
+
+//   ,   :  -> ( -> ).
+//  ()      ,   
+// (copy-on-write Qt).      
+//      ,     .
+//  -  (TagIndex::normalizePath).
+class TagCache
+{
+public:
+	TagCache() : m_size(0) {}
+
+	int size() const { return m_size; }
+	bool isEmpty() const { return m_size == 0; }
+	void clear();
+
+	bool contains(const QString& path) const;
+	bool value(const QString& path, TagSet& tags) const;	// false -  
+	void insert(const QString& path, const TagSet& tags);
+
+	//        ( ):  
+	//    ,   
+	QVector<QPair<QString, TagSet>> take(const QString& path);
+
+	//   : f(, )
+	template<typename F>
+	void forEach(F f) const
+	{
+		for (auto dir = m_dirs.constBegin(); dir != m_dirs.constEnd(); ++dir) {
+			for (auto it = dir.value().constBegin(); it != dir.value().constEnd(); ++it) {
+				f(dir.key() + '/' + it.key(), it.value());
+			}
+		}
+	}
+
+private:
+	typedef QHash<QString, TagSet> Dir;	//   -> 
+
+	QMap<QString, Dir> m_dirs;			//   ->  
+	int m_size;
+
+	static void split(const QString& path, QString& dir, QString& name);
+};
@@ -0,0 +1,204 @@
+#include "tagcooccurrence.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+static const quint32 COOC_MAGIC = 0x4D425443;	// "MBTC"
+static const quint32 COOC_VERSION = 1;
+
+static const int MIN_SUPPORT = 2;		//      
+static const int TOP_NEIGHBORS = 20;	//     
+
+TagCooccurrence::TagCooccurrence()
+	: m_dirty(false)
+	, m_objects(0)
+{
+}
+
+void TagCooccurrence::clear()
+{
+	m_objects = 0;
+	m_tagCounts.clear();
+	m_pairs.clear();
+	m_topNeighbors.clear();
+}
+
+bool TagCooccurrence::load(const QString& filePath)
+{
+	m_filePath = filePath;
+	m_dirty = false;
+	clear();
+
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		qDebug() << "Cannot open tag co-occurrence file:" << filePath << file.errorString();
+		return false;
+	}
+
+	QDataStream in(&file);
+	quint32 magic = 0;
+	quint32 version = 0;
+	in >> magic >> version;
+	if (magic != COOC_MAGIC || version != COOC_VERSION) {
+		qDebug() << "Tag co-occurrence file has unknown format:" << filePath;
+		return false;
+	}
+
+	qint32 objects = 0;
+	in >> objects >> m_tagCounts >> m_pairs;
+	if (in.status() != QDataStream::Ok) {
+		qDebug() << "Tag co-occurrence file is corrupted:" << filePath;
+		clear();
+		return false;
+	}
+	m_objects = objects;
+
+	qDebug() << "Loaded tag co-occurrence:" << m_tagCounts.size() << "tags," << m_objects << "objects";
+	return true;
+}
+
+bool TagCooccurrence::save()
+{
+	if (m_filePath.isEmpty()) {
+		return false;
+	}
+
+	QSaveFile file(m_filePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot save tag co-occurrence:" << m_filePath << file.errorString();
+		return false;
+	}
+
+	QDataStream out(&file);
+	out << COOC_MAGIC << COOC_VERSION;
+	out << qint32(m_objects) << m_tagCounts << m_pairs;
+
+	if (!file.commit()) {
+		qDebug() << "Cannot commit tag co-occurrence:" << m_filePath << file.errorString();
+		return false;
+	}
+
+	m_dirty = false;
+	return true;
+}
+
+void TagCooccurrence::add(const QSet<QString>& tags, int delta)
+{
+	if (tags.isEmpty()) {
+		return;
+	}
+
+	m_objects = qMax(0, m_objects + delta);
+
+	for (const QString &a : tags) {
+		int &count = m_tagCounts[a];
+		count += delta;
+		if (count <= 0) {
+			m_tagCounts.remove(a);
+		}
+
+		QHash<QString, int> &row = m_pairs[a];
+		for (const QString &b : tags) {
+			if (a == b) continue;
+			int &pair = row[b];
+			pair += delta;
+			if (pair <= 0) {
+				row.remove(b);
+			}
+		}
+		if (row.isEmpty()) {
+			m_pairs.remove(a);
+		}
+	}
+
+	// PMI        -    
+	m_topNeighbors.clear();
+}
+
+void TagCooccurrence::update(const QSet<QString>& oldTags, const QSet<QString>& newTags)
+{
+	if (oldTags == newTags) {
+		return;
+	}
+
+	add(oldTags, -1);
+	add(newTags, +1);
+	m_dirty = true;
+}
+
+void TagCooccurrence::rebuild(const QVector<QPair<QString, QSet<QString>>>& objects)
+{
+	clear();
+	for (const auto &entry : objects) {
+		add(entry.second, +1);
+	}
+	m_dirty = true;
+}
+
+const TagCooccurrence::Neighbors& TagCooccurrence::topNeighbors(const QString& tag) const
+{
+	auto cached = m_topNeighbors.constFind(tag);
+	if (cached != m_topNeighbors.constEnd()) {
+		return cached.value();
+	}
+
+	Neighbors neighbors;
+	const int countA = m_tagCounts.value(tag);
+	const QHash<QString, int> row = m_pairs.value(tag);
+
+	if (countA > 0 && m_objects > 0) {
+		for (auto it = row.constBegin(); it != row.constEnd(); ++it) {
+			const int countB = m_tagCounts.value(it.key());
+			if (it.value() < MIN_SUPPORT || countB <= 0) continue;
+
+			// PMI = log( P(a,b) / (P(a) P(b)) );    
+			const double pmi = std::log(double(it.value()) * m_objects / (double(countA) * countB));
+			if (pmi > 0) {
+				neighbors.append(qMakePair(it.key(), pmi));
+			}
+		}
+
+		const int keep = qMin(TOP_NEIGHBORS, neighbors.size());
+		std::partial_sort(neighbors.begin(), neighbors.begin() + keep, neighbors.end(),
+			[](const QPair<QString, double> &a, const QPair<QString, double> &b) {
+			return a.second > b.second;
+		});
+		neighbors.resize(keep);
+	}
+
+	return m_topNeighbors.insert(tag, neighbors).value();
+}
+
+QStringList TagCooccurrence::suggest(const QSet<QString>& tags, int count) const
+{
+	//  PMI     : O(|tags| * TOP_NEIGHBORS)
+	QHash<QString, double> scores;
+	for (const QString &tag : tags) {
+		for (const auto &neighbor : topNeighbors(tag)) {
+			if (!tags.contains(neighbor.first)) {
+				scores[neighbor.first] += neighbor.second;
+			}
+		}
+	}
+
+	QVector<QPair<QString, double>> ranked;
+	ranked.reserve(scores.size());
+	for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+		ranked.append(qMakePair(it.key(), it.value()));
+	}
+
+	const int keep = qMin(count, ranked.size());
+	std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(),
+		[](const QPair<QString, double> &a, const QPair<QString, double> &b) {
+		return a.second > b.second || (a.second == b.second && a.first < b.first);
+	});
+
+	QStringList result;
+	for (int i = 0; i < keep; ++i) {
+		result.append(ranked[i].first);
+	}
+	return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+
+//     (, ).
+//         
+//  "      "  PMI.
+class TagCooccurrence
+{
+public:
+	TagCooccurrence();
+
+	// /    
+	bool load(const QString& filePath);
+	bool save();
+	bool isDirty() const { return m_dirty; }
+
+	//     
+	void update(const QSet<QString>& oldTags, const QSet<QString>& newTags);
+	void rebuild(const QVector<QPair<QString, QSet<QString>>>& objects);
+
+	// :  count ,    tags,   
+	QStringList suggest(const QSet<QString>& tags, int count) const;
+
+	int objectCount() const { return m_objects; }
+
+private:
+	typedef QVector<QPair<QString, double>> Neighbors;	// (, PMI)
+
+	QString m_filePath;
+	bool m_dirty;
+
+	int m_objects;							//      
+	QHash<QString, int> m_tagCounts;		//  -> 
+	QHash<QString, QHash<QString, int>> m_pairs;	// a -> (b ->   a  b)
+
+	//   ,    
+	mutable QHash<QString, Neighbors> m_topNeighbors;
+
+	void add(const QSet<QString>& tags, int delta);
+	const Neighbors& topNeighbors(const QString& tag) const;
+	void clear();
+};
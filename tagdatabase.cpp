@@ -0,0 +1,508 @@
+#include "tagdatabase.h"
+#include "tagindex.h"
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_WINDOWS
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const quint32 DB_MAGIC = 0x4D425444;	// "MBTD"
+static const quint32 DB_VERSION = 2;		// 2 -    
+
+//  ,        ,  
+static const int COMPACT_MIN_RECORDS = 1000;
+static const int COMPACT_RATIO = 4;
+
+static QStringList sortedTags(const QSet<QString>& tags)
+{
+	QStringList list = tags.values();
+	std::sort(list.begin(), list.end());
+	return list;
+}
+
+TagDatabase::TagDatabase()
+	: m_recordCount(0)
+{
+}
+
+TagDatabase::~TagDatabase()
+{
+	close();
+}
+
+QString TagDatabase::fileIdentity(const QString& path, QString *stamp)
+{
+#ifdef Q_OS_WINDOWS
+	// FILE_FLAG_BACKUP_SEMANTICS ,    
+	HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(path).utf16()),
+		0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return QString();
+	}
+
+	BY_HANDLE_FILE_INFORMATION info;
+	BOOL ok = GetFileInformationByHandle(handle, &info);
+	CloseHandle(handle);
+	if (!ok) {
+		return QString();
+	}
+
+	//     ,   
+	if (stamp) {
+		const quint64 created = (quint64(info.ftCreationTime.dwHighDateTime) << 32)
+			| info.ftCreationTime.dwLowDateTime;
+		*stamp = QString("c:%1").arg(created);
+	}
+
+	quint64 fileIndex = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+	return QString("id:%1:%2").arg(quint64(info.dwVolumeSerialNumber)).arg(fileIndex);
+#else
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0) {
+		return QString();
+	}
+	if (stamp) {
+		*stamp = QString("m:%1:%2").arg(qint64(st.st_size)).arg(qint64(st.st_mtime));
+	}
+	return QString("id:%1:%2").arg(quint64(st.st_dev)).arg(quint64(st.st_ino));
+#endif
+}
+
+bool TagDatabase::open(const QString& dbPath)
+{
+	close();
+
+	m_dbPath = dbPath;
+	m_entries.clear();
+	m_keyByPath.clear();
+	m_recordCount = 0;
+
+	quint32 version = DB_VERSION;
+	if (!readLog(version)) {
+		return false;
+	}
+
+	m_file.setFileName(m_dbPath);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		qDebug() << "Cannot open tag database:" << m_dbPath << m_file.errorString();
+		return false;
+	}
+	m_out.setDevice(&m_file);
+
+	//   -  
+	if (m_file.size() == 0) {
+		m_out << DB_MAGIC << DB_VERSION;
+		m_file.flush();
+	}
+
+	qDebug() << "Opened tag database:" << m_dbPath << m_entries.size() << "objects,"
+		<< m_recordCount << "records";
+
+	//     :     
+	if (version != DB_VERSION
+		|| (m_recordCount > COMPACT_MIN_RECORDS && m_recordCount > COMPACT_RATIO * m_entries.size())) {
+		compact();
+	}
+	return true;
+}
+
+void TagDatabase::close()
+{
+	if (m_file.isOpen()) {
+		m_out.setDevice(nullptr);
+		m_file.close();
+	}
+}
+
+bool TagDatabase::readLog(quint32& version)
+{
+	QFile file(m_dbPath);
+	if (!file.exists()) {
+		return true;
+	}
+	if (!file.open(QIODevice::ReadOnly)) {
+		qDebug() << "Cannot read tag database:" << m_dbPath << file.errorString();
+		return false;
+	}
+	if (file.size() == 0) {
+		return true;
+	}
+
+	QDataStream in(&file);
+	quint32 magic = 0;
+	in >> magic >> version;
+	if (magic != DB_MAGIC || version < 1 || version > DB_VERSION) {
+		qDebug() << "Tag database has unknown format:" << m_dbPath;
+		return false;
+	}
+
+	qint64 goodPos = file.pos();
+	while (!in.atEnd()) {
+		quint8 type = 0;
+		QString key;
+		QString path;
+		QString stamp;
+		QStringList tags;
+		QString newKey;
+
+		in >> type >> key;
+		switch (type) {
+		case RecordSet:
+			in >> path;
+			if (version >= 2) in >> stamp;
+			in >> tags;
+			break;
+		case RecordRemove:
+			break;
+		case RecordRekey:
+			in >> newKey >> path;
+			if (version >= 2) in >> stamp;
+			break;
+		default:
+			in.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+
+		//   (   ) -   
+		if (in.status() != QDataStream::Ok) {
+			break;
+		}
+
+		if (type == RecordSet) {
+			Entry entry;
+			entry.path = path;
+			entry.stamp = stamp;
+			entry.tags = QSet<QString>(tags.begin(), tags.end());
+			applySet(key, entry);
+		}
+		else if (type == RecordRemove)
+			applyRemove(key);
+		else
+			applyRekey(key, newKey, path, stamp);
+
+		goodPos = file.pos();
+		++m_recordCount;
+	}
+
+	const qint64 fileSize = file.size();
+	file.close();
+
+	if (goodPos < fileSize) {
+		qDebug() << "Tag database: dropping damaged tail at" << goodPos;
+		QFile damaged(m_dbPath);
+		if (damaged.open(QIODevice::ReadWrite)) {
+			damaged.resize(goodPos);
+		}
+	}
+	return true;
+}
+
+bool TagDatabase::compact()
+{
+	if (m_dbPath.isEmpty()) {
+		return false;
+	}
+
+	QSaveFile file(m_dbPath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot compact tag database:" << m_dbPath << file.errorString();
+		return false;
+	}
+
+	QDataStream out(&file);
+	out << DB_MAGIC << DB_VERSION;
+	for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+		out << quint8(RecordSet) << it.key() << it.value().path << it.value().stamp
+			<< sortedTags(it.value().tags);
+	}
+
+	//     
+	close();
+	if (!file.commit()) {
+		qDebug() << "Cannot commit tag database:" << m_dbPath << file.errorString();
+	}
+
+	m_file.setFileName(m_dbPath);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		qDebug() << "Cannot reopen tag database:" << m_dbPath << m_file.errorString();
+		return false;
+	}
+	m_out.setDevice(&m_file);
+	m_recordCount = m_entries.size();
+
+	qDebug() << "Compacted tag database:" << m_recordCount << "records";
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// 
+
+QString TagDatabase::makeKey(const QString& path, QString *stamp) const
+{
+	QString id = fileIdentity(path, stamp);
+	return id.isEmpty() ? "path:" + path : id;
+}
+
+QString TagDatabase::findKey(const QString& objectPath, QString *stamp)
+{
+	const QString path = TagIndex::normalizePath(objectPath);
+	QString currentStamp;
+	const QString id = fileIdentity(path, &currentStamp);
+	if (stamp) {
+		*stamp = currentStamp;
+	}
+
+	if (!id.isEmpty()) {
+		auto it = m_entries.constFind(id);
+		if (it != m_entries.constEnd()) {
+			if (it.value().path == path) {
+				//     -   
+				if (it.value().stamp != currentStamp) {
+					rekey(id, id, path, currentStamp);
+				}
+				return id;
+			}
+			//      -   ,  .
+			//     ,   ; 
+			//   ( ) - inode   
+			if (!QFileInfo::exists(it.value().path)) {
+				if (!currentStamp.isEmpty() && it.value().stamp == currentStamp) {
+					rekey(id, id, path, currentStamp);
+					return id;
+				}
+				//    -      
+				applyRemove(id);
+				appendRemove(id);
+			}
+		}
+	}
+
+	auto pit = m_keyByPath.constFind(path);
+	if (pit == m_keyByPath.constEnd()) {
+		return QString();
+	}
+
+	//   ,        - 
+	const QString key = pit.value();
+	if (!id.isEmpty() && key != id && !m_entries.contains(id)) {
+		rekey(key, id, path, currentStamp);
+		return id;
+	}
+	return key;
+}
+
+void TagDatabase::rekey(const QString& oldKey, const QString& newKey, const QString& newPath,
+	const QString& stamp)
+{
+	applyRekey(oldKey, newKey, newPath, stamp);
+	appendRekey(oldKey, newKey, newPath, stamp);
+}
+
+// ---------------------------------------------------------------------------
+// TagStorage
+
+bool TagDatabase::load(const QString& objectPath, QSet<QString>& tags)
+{
+	const QString key = findKey(objectPath);
+	if (key.isEmpty()) {
+		return false;
+	}
+	tags = m_entries.value(key).tags;
+	return true;
+}
+
+bool TagDatabase::save(const QString& objectPath, const QSet<QString>& tags)
+{
+	if (!isOpen()) {
+		return false;
+	}
+
+	const QString path = TagIndex::normalizePath(objectPath);
+	QString stamp;
+	QString key = findKey(path, &stamp);
+
+	if (tags.isEmpty()) {
+		if (!key.isEmpty()) {
+			applyRemove(key);
+			appendRemove(key);
+		}
+		return true;
+	}
+
+	if (key.isEmpty()) {
+		key = makeKey(path);
+	}
+
+	Entry entry;
+	entry.path = path;
+	entry.stamp = stamp;
+	entry.tags = tags;
+	applySet(key, entry);
+	appendSet(key, entry);
+	return true;
+}
+
+bool TagDatabase::move(const QString& oldPath, const QString& newPath)
+{
+	const QString from = TagIndex::normalizePath(oldPath);
+	const QString to = TagIndex::normalizePath(newPath);
+	if (from == to) return true;
+
+	const QString prefix = from + '/';
+
+	//     ( )
+	QStringList affected;
+	for (auto it = m_keyByPath.constBegin(); it != m_keyByPath.constEnd(); ++it) {
+		if (it.key() == from || it.key().startsWith(prefix)) {
+			affected.append(it.key());
+		}
+	}
+
+	for (const QString &path : affected) {
+		const QString key = m_keyByPath.value(path);
+		if (key.isEmpty()) continue;
+
+		const QString renamed = to + path.mid(from.size());
+
+		//     
+		const QString existing = m_keyByPath.value(renamed);
+		if (!existing.isEmpty() && existing != key) {
+			applyRemove(existing);
+			appendRemove(existing);
+		}
+
+		//      inode  -  
+		QString stamp;
+		const QString newKey = makeKey(renamed, &stamp);
+		rekey(key, newKey, renamed, stamp);
+	}
+	return true;
+}
+
+bool TagDatabase::remove(const QString& objectPath)
+{
+	const QString path = TagIndex::normalizePath(objectPath);
+	const QString prefix = path + '/';
+
+	QStringList keys;
+	for (auto it = m_keyByPath.constBegin(); it != m_keyByPath.constEnd(); ++it) {
+		if (it.key() == path || it.key().startsWith(prefix)) {
+			keys.append(it.value());
+		}
+	}
+
+	for (const QString &key : keys) {
+		applyRemove(key);
+		appendRemove(key);
+	}
+	return true;
+}
+
+bool TagDatabase::entries(QVector<QPair<QString, QSet<QString>>>& result) const
+{
+	result.clear();
+	result.reserve(m_entries.size());
+	for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+		result.append(qMakePair(it.value().path, it.value().tags));
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+//      
+
+void TagDatabase::applySet(const QString& key, const Entry& value)
+{
+	const QString &path = value.path;
+	auto it = m_entries.find(key);
+	if (it != m_entries.end() && it.value().path != path) {
+		m_keyByPath.remove(it.value().path);
+	}
+
+	//      ( )
+	const QString previous = m_keyByPath.value(path);
+	if (!previous.isEmpty() && previous != key) {
+		m_entries.remove(previous);
+	}
+
+	m_entries.insert(key, value);
+	m_keyByPath.insert(path, key);
+}
+
+void TagDatabase::applyRemove(const QString& key)
+{
+	auto it = m_entries.find(key);
+	if (it == m_entries.end()) {
+		return;
+	}
+	if (m_keyByPath.value(it.value().path) == key) {
+		m_keyByPath.remove(it.value().path);
+	}
+	m_entries.erase(it);
+}
+
+void TagDatabase::applyRekey(const QString& oldKey, const QString& newKey, const QString& newPath,
+	const QString& stamp)
+{
+	auto it = m_entries.find(oldKey);
+	if (it == m_entries.end()) {
+		return;
+	}
+
+	Entry entry = it.value();
+	if (m_keyByPath.value(entry.path) == oldKey) {
+		m_keyByPath.remove(entry.path);
+	}
+	m_entries.erase(it);
+
+	if (newKey != oldKey) {
+		applyRemove(newKey);
+	}
+
+	entry.path = newPath;
+	entry.stamp = stamp;
+	applySet(newKey, entry);
+}
+
+// ---------------------------------------------------------------------------
+//   
+
+void TagDatabase::appendSet(const QString& key, const Entry& entry)
+{
+	if (!isOpen()) return;
+	m_out << quint8(RecordSet) << key << entry.path << entry.stamp << sortedTags(entry.tags);
+	recordAppended();
+}
+
+void TagDatabase::appendRemove(const QString& key)
+{
+	if (!isOpen()) return;
+	m_out << quint8(RecordRemove) << key;
+	recordAppended();
+}
+
+void TagDatabase::appendRekey(const QString& oldKey, const QString& newKey, const QString& newPath,
+	const QString& stamp)
+{
+	if (!isOpen()) return;
+	m_out << quint8(RecordRekey) << oldKey << newKey << newPath << stamp;
+	recordAppended();
+}
+
+void TagDatabase::recordAppended()
+{
+	//       -   
+	m_file.flush();
+	++m_recordCount;
+
+	if (m_recordCount > COMPACT_MIN_RECORDS && m_recordCount > COMPACT_RATIO * m_entries.size()) {
+		compact();
+	}
+}
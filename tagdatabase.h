@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QFile>
+#include <QDataStream>
+#include <QHash>
+#include <QStringList>
+#include "tagstorage.h"
+
+//     :   (append-only)  
+// .    +inode ( Windows -
+//   + ),     .
+// Inode   ,    
+//        (  
+// Windows, +    ).
+class TagDatabase : public TagStorage
+{
+public:
+	TagDatabase();
+	~TagDatabase();
+
+	bool open(const QString& dbPath);
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+	QString path() const { return m_dbPath; }
+
+	QString name() const override { return "database"; }
+
+	bool load(const QString& objectPath, QSet<QString>& tags) override;
+	bool save(const QString& objectPath, const QSet<QString>& tags) override;
+	bool move(const QString& oldPath, const QString& newPath) override;
+	bool remove(const QString& objectPath) override;
+	bool entries(QVector<QPair<QString, QSet<QString>>>& result) const override;
+
+	int size() const { return m_entries.size(); }
+
+	//       
+	bool compact();
+
+	//   : "id:<dev>:<inode>"  ; stamp -
+	// ,       
+	static QString fileIdentity(const QString& path, QString *stamp = nullptr);
+
+private:
+	struct Entry
+	{
+		QString path;
+		QString stamp;		//  -  (  1)
+		QSet<QString> tags;
+	};
+
+	enum RecordType : quint8 { RecordSet = 1, RecordRemove = 2, RecordRekey = 3 };
+
+	QString m_dbPath;
+	QFile m_file;
+	QDataStream m_out;
+
+	QHash<QString, Entry> m_entries;	//  -> 
+	QHash<QString, QString> m_keyByPath;	//  -> 
+	int m_recordCount;				//   
+
+	QString findKey(const QString& path, QString *stamp = nullptr);
+	QString makeKey(const QString& path, QString *stamp = nullptr) const;
+	void rekey(const QString& oldKey, const QString& newKey, const QString& newPath, const QString& stamp);
+
+	bool readLog(quint32& version);
+	void applySet(const QString& key, const Entry& entry);
+	void applyRemove(const QString& key);
+	void applyRekey(const QString& oldKey, const QString& newKey, const QString& newPath, const QString& stamp);
+
+	void appendSet(const QString& key, const Entry& entry);
+	void appendRemove(const QString& key);
+	void appendRekey(const QString& oldKey, const QString& newKey, const QString& newPath, const QString& stamp);
+	void recordAppended();
+};
@@ -0,0 +1,187 @@
+#include "tagdictionary.h"
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// TagSet
+
+bool TagSet::contains(quint32 id) const
+{
+	return std::binary_search(m_ids.constBegin(), m_ids.constEnd(), id);
+}
+
+bool TagSet::insert(quint32 id)
+{
+	auto it = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+	if (it != m_ids.end() && *it == id)
+		return false;
+	m_ids.insert(it, id);
+	return true;
+}
+
+bool TagSet::remove(quint32 id)
+{
+	auto it = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+	if (it == m_ids.end() || *it != id)
+		return false;
+	m_ids.erase(it);
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// TagBits
+
+void TagBits::set(quint32 id)
+{
+	const int word = int(id >> 6);
+	if (word >= m_words.size()) {
+		m_words.resize(word + 1);
+	}
+	m_words[word] |= quint64(1) << (id & 63);
+}
+
+void TagBits::set(const TagSet& tags)
+{
+	if (tags.isEmpty())
+		return;
+
+	//   -     id
+	const int needed = int(tags.ids().last() >> 6) + 1;
+	if (needed > m_words.size()) {
+		m_words.resize(needed);
+	}
+
+	quint64 *words = m_words.data();
+	for (quint32 id : tags.ids()) {
+		words[id >> 6] |= quint64(1) << (id & 63);
+	}
+}
+
+bool TagBits::test(quint32 id) const
+{
+	const int word = int(id >> 6);
+	return word < m_words.size() && ((m_words[word] >> (id & 63)) & 1);
+}
+
+void TagBits::intersect(const TagSet& tags)
+{
+	TagBits other(m_words.size() * 64);
+	other.set(tags);
+	*this &= other;
+}
+
+TagBits& TagBits::operator|=(const TagBits& other)
+{
+	if (other.m_words.size() > m_words.size()) {
+		m_words.resize(other.m_words.size());
+	}
+
+	quint64 *dst = m_words.data();
+	const quint64 *src = other.m_words.constData();
+	const int n = other.m_words.size();
+	for (int i = 0; i < n; ++i) dst[i] |= src[i];
+	return *this;
+}
+
+TagBits& TagBits::operator&=(const TagBits& other)
+{
+	const int n = qMin(m_words.size(), other.m_words.size());
+	quint64 *dst = m_words.data();
+	const quint64 *src = other.m_words.constData();
+	for (int i = 0; i < n; ++i) dst[i] &= src[i];
+	for (int i = n; i < m_words.size(); ++i) dst[i] = 0;
+	return *this;
+}
+
+int TagBits::count() const
+{
+	int total = 0;
+	for (quint64 word : m_words) {
+		total += qPopulationCount(word);
+	}
+	return total;
+}
+
+// ---------------------------------------------------------------------------
+// TagCounts
+
+void TagCounts::add(const TagSet& tags)
+{
+	++m_objects;
+	if (tags.isEmpty())
+		return;
+
+	const int needed = int(tags.ids().last()) + 1;
+	if (needed > m_counts.size()) {
+		m_counts.resize(needed);
+	}
+
+	int *counts = m_counts.data();
+	for (quint32 id : tags.ids()) {
+		++counts[id];
+	}
+}
+
+TagBits TagCounts::common() const
+{
+	TagBits result(m_counts.size());
+	for (int id = 0; id < m_counts.size(); ++id) {
+		if (m_counts[id] == m_objects && m_objects > 0)
+			result.set(quint32(id));
+	}
+	return result;
+}
+
+TagBits TagCounts::partial() const
+{
+	TagBits result(m_counts.size());
+	for (int id = 0; id < m_counts.size(); ++id) {
+		if (m_counts[id] > 0 && m_counts[id] < m_objects)
+			result.set(quint32(id));
+	}
+	return result;
+}
+
+// ---------------------------------------------------------------------------
+// TagDictionary
+
+quint32 TagDictionary::intern(const QString& tag)
+{
+	auto it = m_ids.constFind(tag);
+	if (it != m_ids.constEnd()) {
+		return it.value();
+	}
+
+	const quint32 id = quint32(m_names.size());
+	m_names.append(tag);
+	m_ids.insert(tag, id);
+	return id;
+}
+
+TagSet TagDictionary::toSet(const QSet<QString>& tags)
+{
+	TagSet result;
+	for (const QString &tag : tags) {
+		result.insert(intern(tag));
+	}
+	return result;
+}
+
+QSet<QString> TagDictionary::toStrings(const TagSet& tags) const
+{
+	QSet<QString> result;
+	result.reserve(tags.size());
+	for (quint32 id : tags.ids()) {
+		result.insert(m_names[int(id)]);
+	}
+	return result;
+}
+
+QSet<QString> TagDictionary::toStrings(const TagBits& tags) const
+{
+	QSet<QString> result;
+	tags.forEach([this, &result](quint32 id) {
+		if (int(id) < m_names.size())
+			result.insert(m_names[int(id)]);
+	});
+	return result;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QtAlgorithms>
+
+//  :     TagDictionary.
+//  QSet<QString>    -    .
+class TagSet
+{
+public:
+	TagSet() {}
+
+	bool contains(quint32 id) const;
+	bool insert(quint32 id);
+	bool remove(quint32 id);
+
+	int size() const { return m_ids.size(); }
+	bool isEmpty() const { return m_ids.isEmpty(); }
+	const QVector<quint32>& ids() const { return m_ids; }
+
+	bool operator==(const TagSet& other) const { return m_ids == other.m_ids; }
+	bool operator!=(const TagSet& other) const { return m_ids != other.m_ids; }
+
+private:
+	QVector<quint32> m_ids;		//  ,  
+};
+
+//      /  .
+//    ( ).
+class TagBits
+{
+public:
+	explicit TagBits(int size = 0) : m_words((size + 63) / 64, 0) {}
+
+	void set(quint32 id);
+	void set(const TagSet& tags);
+	bool test(quint32 id) const;
+
+	//     
+	void intersect(const TagSet& tags);
+
+	TagBits& operator|=(const TagBits& other);
+	TagBits& operator&=(const TagBits& other);
+
+	int count() const;
+	bool isEmpty() const { return count() == 0; }
+
+	template<typename Func>
+	void forEach(Func func) const;
+
+private:
+	QVector<quint64> m_words;
+};
+
+//      ():  
+//   .     id,    .
+class TagCounts
+{
+public:
+	explicit TagCounts(int size = 0) : m_counts(size, 0), m_objects(0) {}
+
+	void add(const TagSet& tags);
+
+	int objects() const { return m_objects; }
+	int count(quint32 id) const { return int(id) < m_counts.size() ? m_counts[int(id)] : 0; }
+
+	//     /   
+	TagBits common() const;
+	TagBits partial() const;
+
+private:
+	QVector<int> m_counts;
+	int m_objects;
+};
+
+//   :    ,    id.
+//   ,   .
+class TagDictionary
+{
+public:
+	TagDictionary() {}
+
+	quint32 intern(const QString& tag);
+	int id(const QString& tag) const { return m_ids.value(tag, -1); }
+	QString name(quint32 id) const { return int(id) < m_names.size() ? m_names[id] : QString(); }
+	int size() const { return m_names.size(); }
+
+	//     ( UI  )
+	TagSet toSet(const QSet<QString>& tags);
+	QSet<QString> toStrings(const TagSet& tags) const;
+	QSet<QString> toStrings(const TagBits& tags) const;
+
+private:
+	QHash<QString, quint32> m_ids;
+	QVector<QString> m_names;
+};
+
+template<typename Func>
+void TagBits::forEach(Func func) const
+{
+	for (int w = 0; w < m_words.size(); ++w) {
+		quint64 word = m_words[w];
+		while (word) {
+			func(quint32(w * 64 + qCountTrailingZeroBits(word)));
+			word &= word - 1;
+		}
+	}
+}
@@ -0,0 +1,373 @@
+#include "tagflowview.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QStyleOptionButton>
+#include <algorithm>
+
+//   (   )
+static const int MARGIN = 10;			//    
+static const int H_SPACING = 4;			//    
+static const int V_SPACING = 4;			//  
+static const int PADDING_X = 8;
+static const int PADDING_Y = 4;
+static const int INDICATOR_SIZE = 16;
+static const int INDICATOR_SPACING = 4;
+static const int ARROW_SIZE = 12;			//   
+static const int INDENT = 16;				//   
+
+TagFlowView::TagFlowView(QWidget *parent)
+	: QAbstractScrollArea(parent)
+	, m_count(0)
+	, m_nextX(0)
+	, m_nextY(0)
+	, m_lastDepth(0)
+	, m_lastHasChildren(false)
+	, m_itemHeight(0)
+	, m_layoutWidth(-1)
+	, m_hovered(-1)
+	, m_pressed(-1)
+{
+	setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+	setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	viewport()->setMouseTracking(true);
+	viewport()->setBackgroundRole(QPalette::Base);
+
+	m_itemHeight = qMax(INDICATOR_SIZE, fontMetrics().height()) + PADDING_Y * 2 + 2;
+}
+
+TagFlowView::~TagFlowView()
+{
+}
+
+void TagFlowView::setItems(const QVector<Item>& items)
+{
+	m_items = items;
+	m_source = [this](int index) { return m_items[index]; };
+	m_count = m_items.size();
+	reset();
+}
+
+void TagFlowView::setItems(int count, const ItemSource& source)
+{
+	m_items.clear();
+	m_source = source;
+	m_count = count;
+	reset();
+}
+
+void TagFlowView::reset()
+{
+	m_hovered = -1;
+	m_pressed = -1;
+	relayout();
+	viewport()->update();
+}
+
+int TagFlowView::itemWidth(const Item& item)
+{
+	const QString &text = item.label.isEmpty() ? item.tag : item.label;
+
+	int textWidth = 0;
+	auto it = m_widthCache.constFind(text);
+	if (it != m_widthCache.constEnd()) {
+		textWidth = it.value();
+	}
+	else {
+		textWidth = fontMetrics().horizontalAdvance(text);
+		m_widthCache.insert(text, textWidth);
+	}
+
+	return PADDING_X * 2 + (item.hasChildren ? ARROW_SIZE : 0)
+		+ (item.checkable ? INDICATOR_SIZE + INDICATOR_SPACING : 0) + textWidth + 2;
+}
+
+void TagFlowView::relayout()
+{
+	m_layoutWidth = viewport()->width();
+	m_rects.clear();
+	m_rowStarts.clear();
+	m_rowTops.clear();
+	m_nextX = MARGIN;
+	m_nextY = MARGIN;
+	m_lastDepth = 0;
+	m_lastHasChildren = false;
+
+	layoutTo(verticalScrollBar()->value() + viewport()->height());
+	updateScrollBar();
+}
+
+void TagFlowView::layoutTo(int bottom)
+{
+	const int availableWidth = m_layoutWidth - MARGIN * 2;
+
+	for (int i = m_rects.size(); i < m_count; ++i) {
+		const Item item = m_source(i);
+		const int indent = item.depth * INDENT;
+		const int width = qMin(itemWidth(item), qMax(availableWidth - indent, INDICATOR_SIZE));
+
+		//    ;     
+		const bool groupBreak = i > 0 && item.groupStart;
+		const bool treeBreak = i > 0 && (item.depth != m_lastDepth
+			|| item.hasChildren || m_lastHasChildren);
+
+		int x = m_nextX;
+		int y = m_nextY;
+		if (i == 0 || groupBreak || treeBreak || x + width > MARGIN + availableWidth) {
+			x = MARGIN + indent;
+			if (i > 0) {
+				y += m_itemHeight + (groupBreak ? V_SPACING * 2 : V_SPACING);
+			}
+			//   bottom   
+			if (y > bottom) {
+				break;
+			}
+			m_rowStarts.append(i);
+			m_rowTops.append(y);
+		}
+
+		m_rects.append(QRect(x, y, width, m_itemHeight));
+		m_nextX = x + width + H_SPACING;
+		m_nextY = y;
+		m_lastDepth = item.depth;
+		m_lastHasChildren = item.hasChildren;
+	}
+}
+
+void TagFlowView::ensureLaidOut()
+{
+	if (m_rects.size() == m_count) {
+		return;
+	}
+	const int laidOut = m_rects.size();
+	layoutTo(verticalScrollBar()->value() + viewport()->height());
+	if (m_rects.size() != laidOut) {
+		updateScrollBar();
+	}
+}
+
+int TagFlowView::contentHeight() const
+{
+	if (m_rects.isEmpty()) {
+		return 0;
+	}
+	const int laidOut = m_nextY + m_itemHeight + MARGIN;
+	if (m_rects.size() == m_count) {
+		return laidOut;
+	}
+
+	//       ;   
+	return laidOut + int(qint64(laidOut - MARGIN) * (m_count - m_rects.size()) / m_rects.size());
+}
+
+int TagFlowView::rowEnd(int row) const
+{
+	return row + 1 < m_rowStarts.size() ? m_rowStarts[row + 1] : m_rects.size();
+}
+
+void TagFlowView::updateScrollBar()
+{
+	QScrollBar *bar = verticalScrollBar();
+	bar->setPageStep(viewport()->height());
+	bar->setSingleStep(m_itemHeight + V_SPACING);
+	bar->setRange(0, qMax(0, contentHeight() - viewport()->height()));
+}
+
+int TagFlowView::rowAt(int y) const
+{
+	//       y
+	auto it = std::upper_bound(m_rowTops.constBegin(), m_rowTops.constEnd(), y);
+	return int(it - m_rowTops.constBegin()) - 1;
+}
+
+int TagFlowView::indexAt(const QPoint& pos) const
+{
+	const int y = pos.y() + verticalScrollBar()->value();
+	const int row = rowAt(y);
+	if (row < 0 || y >= m_rowTops[row] + m_itemHeight) {
+		return -1;
+	}
+
+	const int first = m_rowStarts[row];
+	const int last = rowEnd(row);
+
+	//      x
+	auto it = std::upper_bound(m_rects.constBegin() + first, m_rects.constBegin() + last, pos.x(),
+		[](int x, const QRect& rect) { return x < rect.left(); });
+	const int index = int(it - m_rects.constBegin()) - 1;
+	if (index < first || !m_rects[index].contains(pos.x(), y)) {
+		return -1;
+	}
+	return index;
+}
+
+void TagFlowView::paintEvent(QPaintEvent *event)
+{
+	QPainter painter(viewport());
+	const int offset = verticalScrollBar()->value();
+	const QRect area = event->rect().translated(0, offset);
+	const bool enabled = isEnabled();
+
+	//   ,   
+	int row = qMax(0, rowAt(area.top() - m_itemHeight));
+	for (; row < m_rowStarts.size() && m_rowTops[row] <= area.bottom(); ++row) {
+		const int last = rowEnd(row);
+		for (int i = m_rowStarts[row]; i < last; ++i) {
+			const Item item = m_source(i);
+			const QRect rect = m_rects[i].translated(0, -offset);
+			const bool checked = item.state != Qt::Unchecked;
+			const bool hovered = enabled && i == m_hovered;
+
+			QColor background = checked ? QColor("#e3f2fd") : QColor("#f5f5f5");
+			QColor border = checked ? QColor("#bbdefb") : QColor("#e0e0e0");
+			if (hovered) {
+				background = checked ? QColor("#bbdefb") : QColor("#eeeeee");
+			}
+			if (item.state == Qt::PartiallyChecked) {
+				background = hovered ? QColor("#e3f2fd") : QColor("#f1f8fe");
+			}
+
+			painter.setRenderHint(QPainter::Antialiasing, true);
+			painter.setPen(border);
+			painter.setBrush(background);
+			painter.drawRoundedRect(QRectF(rect).adjusted(0.5, 0.5, -0.5, -0.5), 4, 4);
+			painter.setRenderHint(QPainter::Antialiasing, false);
+
+			int left = rect.left() + PADDING_X;
+
+			//    
+			if (item.hasChildren) {
+				QStyleOption arrow;
+				arrow.initFrom(this);
+				arrow.rect = QRect(left - 2, rect.top() + (rect.height() - ARROW_SIZE) / 2, ARROW_SIZE, ARROW_SIZE);
+				style()->drawPrimitive(item.expanded ? QStyle::PE_IndicatorArrowDown : QStyle::PE_IndicatorArrowRight,
+					&arrow, &painter, this);
+				left += ARROW_SIZE;
+			}
+
+			//     
+			if (item.checkable) {
+				QStyleOptionButton option;
+				option.initFrom(this);
+				option.rect = QRect(left, rect.top() + (rect.height() - INDICATOR_SIZE) / 2,
+					INDICATOR_SIZE, INDICATOR_SIZE);
+				option.state &= ~QStyle::State_HasFocus;
+				option.state |= item.state == Qt::Checked ? QStyle::State_On
+					: item.state == Qt::PartiallyChecked ? QStyle::State_NoChange : QStyle::State_Off;
+				if (hovered) {
+					option.state |= QStyle::State_MouseOver;
+				}
+				style()->drawPrimitive(QStyle::PE_IndicatorCheckBox, &option, &painter, this);
+				left += INDICATOR_SIZE + INDICATOR_SPACING;
+			}
+
+			const QRect textRect(left, rect.top(), rect.right() - PADDING_X - left + 1, rect.height());
+			painter.setPen(palette().color(enabled ? QPalette::Active : QPalette::Disabled, QPalette::Text));
+			painter.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter,
+				fontMetrics().elidedText(item.label.isEmpty() ? item.tag : item.label,
+					Qt::ElideRight, textRect.width()));
+		}
+	}
+}
+
+void TagFlowView::resizeEvent(QResizeEvent *event)
+{
+	QAbstractScrollArea::resizeEvent(event);
+
+	//     -   
+	if (viewport()->width() != m_layoutWidth) {
+		relayout();
+	}
+	else {
+		layoutTo(verticalScrollBar()->value() + viewport()->height());
+		updateScrollBar();
+	}
+}
+
+void TagFlowView::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() == Qt::LeftButton) {
+		m_pressed = indexAt(event->pos());
+	}
+	QAbstractScrollArea::mousePressEvent(event);
+}
+
+void TagFlowView::mouseReleaseEvent(QMouseEvent *event)
+{
+	const int pressed = m_pressed;
+	m_pressed = -1;
+
+	//   QCheckBox:      
+	if (event->button() == Qt::LeftButton && pressed >= 0 && pressed == indexAt(event->pos())) {
+		const Item item = m_source(pressed);
+
+		//     -     
+		if (isOnArrow(pressed, event->pos()) || !item.checkable) {
+			emit expandToggled(item.tag);
+			QAbstractScrollArea::mouseReleaseEvent(event);
+			return;
+		}
+
+		//       
+		emit tagToggled(item.tag, item.state != Qt::Checked);
+	}
+	QAbstractScrollArea::mouseReleaseEvent(event);
+}
+
+bool TagFlowView::isOnArrow(int index, const QPoint& pos) const
+{
+	return m_source(index).hasChildren
+		&& pos.x() < m_rects[index].left() + PADDING_X + ARROW_SIZE;
+}
+
+void TagFlowView::mouseMoveEvent(QMouseEvent *event)
+{
+	setHovered(indexAt(event->pos()));
+	QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void TagFlowView::leaveEvent(QEvent *event)
+{
+	setHovered(-1);
+	QAbstractScrollArea::leaveEvent(event);
+}
+
+void TagFlowView::changeEvent(QEvent *event)
+{
+	//   -   
+	if (event->type() == QEvent::FontChange || event->type() == QEvent::StyleChange) {
+		m_widthCache.clear();
+		m_itemHeight = qMax(INDICATOR_SIZE, fontMetrics().height()) + PADDING_Y * 2 + 2;
+		relayout();
+		viewport()->update();
+	}
+	else if (event->type() == QEvent::EnabledChange) {
+		viewport()->update();
+	}
+	QAbstractScrollArea::changeEvent(event);
+}
+
+void TagFlowView::scrollContentsBy(int dx, int dy)
+{
+	Q_UNUSED(dx);
+	//  ,   
+	ensureLaidOut();
+	viewport()->scroll(0, dy);
+}
+
+void TagFlowView::setHovered(int index)
+{
+	if (index == m_hovered) {
+		return;
+	}
+
+	const int offset = verticalScrollBar()->value();
+	if (m_hovered >= 0 && m_hovered < m_rects.size()) {
+		viewport()->update(m_rects[m_hovered].translated(0, -offset));
+	}
+	m_hovered = index;
+	if (m_hovered >= 0) {
+		viewport()->update(m_rects[m_hovered].translated(0, -offset));
+	}
+}
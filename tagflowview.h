@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QHash>
+#include <QVector>
+#include <QRect>
+#include <functional>
+
+//    "   " (flow layout).
+//   ,    :    ,
+//  -   .     
+//   ( -   ),   .
+class TagFlowView : public QAbstractScrollArea
+{
+	Q_OBJECT
+
+public:
+	struct Item
+	{
+		QString tag;
+		Qt::CheckState state;
+		QString label;				//  ( - tag)
+		int depth = 0;				//    "a/b/c"
+		bool hasChildren = false;	//   
+		bool expanded = false;
+		bool checkable = true;		//      - 
+		bool groupStart = false;	//     
+	};
+
+	//   ;      
+	typedef std::function<Item(int)> ItemSource;
+
+	explicit TagFlowView(QWidget *parent = nullptr);
+	~TagFlowView();
+
+	//    ;   
+	void setItems(const QVector<Item>& items);
+	const QVector<Item>& items() const { return m_items; }	//  setItems(QVector)
+
+	//    :    
+	// (,   )   setItems
+	void setItems(int count, const ItemSource& source);
+	int count() const { return m_count; }
+
+	//     ( viewport)  -1
+	int indexAt(const QPoint& pos) const;
+
+signals:
+	void tagToggled(const QString& tag, bool checked);
+	void expandToggled(const QString& tag);
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
+	void mouseReleaseEvent(QMouseEvent *event) override;
+	void mouseMoveEvent(QMouseEvent *event) override;
+	void leaveEvent(QEvent *event) override;
+	void changeEvent(QEvent *event) override;
+	void scrollContentsBy(int dx, int dy) override;
+
+private:
+	QVector<Item> m_items;			//  setItems(QVector)
+	ItemSource m_source;
+	int m_count;
+
+	//   m_rects.size() 
+	QVector<QRect> m_rects;			//     
+	QVector<int> m_rowStarts;		//    
+	QVector<int> m_rowTops;			//   
+
+	//  :      
+	int m_nextX;
+	int m_nextY;
+	int m_lastDepth;
+	bool m_lastHasChildren;
+
+	QHash<QString, int> m_widthCache;	//  ->  
+	int m_itemHeight;
+	int m_layoutWidth;				// ,    
+
+	int m_hovered;
+	int m_pressed;
+
+	int itemWidth(const Item& item);
+	bool isOnArrow(int index, const QPoint& pos) const;
+	void reset();
+	void relayout();
+	void layoutTo(int bottom);
+	void ensureLaidOut();
+	int contentHeight() const;
+	int rowEnd(int row) const;
+	void updateScrollBar();
+	int rowAt(int y) const;
+	void setHovered(int index);
+};
@@ -0,0 +1,661 @@
+#include "tagindex.h"
+#include "tagquery.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDebug>
+#include <QtConcurrent>
+#include <algorithm>
+
+static const quint32 INDEX_MAGIC = 0x4D425449;	// "MBTI"
+static const quint32 INDEX_VERSION = 1;
+
+namespace
+{
+	//   QtConcurrent:    
+	struct ReadTagsFunctor
+	{
+		typedef QPair<QString, QSet<QString>> result_type;
+
+		TagIndex::TagReader reader;
+
+		result_type operator()(const QString& path) const
+		{
+			QSet<QString> tags;
+			reader(path, tags);
+			return qMakePair(path, tags);
+		}
+	};
+}
+
+TagIndex::TagIndex(TagDictionary *dictionary)
+	: m_dirty(false)
+	, m_dictionary(dictionary)
+	, m_sortedDirty(true)
+{
+}
+
+QString TagIndex::normalizePath(const QString& path)
+{
+	return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+}
+
+void TagIndex::clear()
+{
+	m_postings.clear();
+	m_objectIds.clear();
+	m_objectPaths.clear();
+	m_universe.clear();
+	m_sortedTags.clear();
+	m_sortedDirty = true;
+	m_treeCache.clear();
+	for (LiveQuery &live : m_liveQueries) {
+		live.result = TagBitmap();
+	}
+}
+
+bool TagIndex::load(const QString& indexPath)
+{
+	m_indexPath = indexPath;
+	clear();
+	m_roots.clear();
+	m_dirty = false;
+
+	QFile file(indexPath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		qDebug() << "Cannot open tag index:" << indexPath << file.errorString();
+		return false;
+	}
+
+	QDataStream in(&file);
+	quint32 magic = 0;
+	quint32 version = 0;
+	in >> magic >> version;
+	if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+		qDebug() << "Tag index has unknown format:" << indexPath;
+		return false;
+	}
+
+	QVector<QString> tagNames;
+	QVector<TagBitmap> postings;
+	in >> m_roots >> tagNames >> postings >> m_objectPaths;
+	if (in.status() != QDataStream::Ok || tagNames.size() != postings.size()) {
+		qDebug() << "Tag index is corrupted:" << indexPath;
+		//   setIndexRoots  
+		clear();
+		m_roots.clear();
+		return false;
+	}
+
+	//  -  id  ,   -  
+	for (int i = 0; i < tagNames.size(); ++i) {
+		m_postings[int(tagId(tagNames[i]))] = postings[i];
+	}
+	for (int i = 0; i < m_objectPaths.size(); ++i) {
+		if (!m_objectPaths[i].isEmpty()) {
+			m_objectIds.insert(m_objectPaths[i], quint32(i));
+			m_universe.add(quint32(i));
+		}
+	}
+
+	refreshLiveQueries();
+
+	qDebug() << "Loaded tag index:" << tagNames.size() << "tags,"
+		<< m_objectIds.size() << "objects";
+	return true;
+}
+
+bool TagIndex::save()
+{
+	if (m_indexPath.isEmpty()) {
+		return false;
+	}
+
+	// QSaveFile -       
+	QSaveFile file(m_indexPath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot save tag index:" << m_indexPath << file.errorString();
+		return false;
+	}
+
+	// Id     -    
+	QVector<QString> tagNames(m_postings.size());
+	for (int i = 0; i < tagNames.size(); ++i) {
+		tagNames[i] = m_dictionary->name(quint32(i));
+	}
+
+	QDataStream out(&file);
+	out << INDEX_MAGIC << INDEX_VERSION;
+	out << m_roots << tagNames << m_postings << m_objectPaths;
+
+	if (!file.commit()) {
+		qDebug() << "Cannot commit tag index:" << m_indexPath << file.errorString();
+		return false;
+	}
+
+	m_dirty = false;
+	return true;
+}
+
+quint32 TagIndex::tagId(const QString& tag)
+{
+	const quint32 id = m_dictionary->intern(tag);
+	if (int(id) >= m_postings.size()) {
+		m_postings.resize(int(id) + 1);
+		m_sortedDirty = true;
+	}
+	return id;
+}
+
+int TagIndex::postingOf(const QString& tag) const
+{
+	const int id = m_dictionary->id(tag);
+	return id < m_postings.size() ? id : -1;
+}
+
+quint32 TagIndex::objectId(const QString& path)
+{
+	auto it = m_objectIds.constFind(path);
+	if (it != m_objectIds.constEnd()) {
+		return it.value();
+	}
+
+	quint32 id = quint32(m_objectPaths.size());
+	m_objectIds.insert(path, id);
+	m_objectPaths.append(path);
+	m_universe.add(id);
+	return id;
+}
+
+void TagIndex::updateObject(const QString& objectPath, const QSet<QString>& oldTags, const QSet<QString>& newTags)
+{
+	const QString path = normalizePath(objectPath);
+	const quint32 id = objectId(path);
+
+	//    
+	for (const QString &tag : oldTags) {
+		if (newTags.contains(tag)) continue;
+		const int posting = postingOf(tag);
+		if (posting >= 0) {
+			m_postings[posting].remove(id);
+			updateTrees(tag, id, newTags);
+		}
+	}
+	for (const QString &tag : newTags) {
+		if (oldTags.contains(tag)) continue;
+		m_postings[int(tagId(tag))].add(id);
+		updateTrees(tag, id, newTags);
+	}
+
+	//   -   
+	for (LiveQuery &live : m_liveQueries) {
+		if (live.query.matches(newTags))
+			live.result.add(id);
+		else
+			live.result.remove(id);
+	}
+
+	m_dirty = true;
+}
+
+QVector<quint32> TagIndex::idsUnder(const QString& path) const
+{
+	QVector<quint32> ids;
+	auto exact = m_objectIds.constFind(path);
+	if (exact != m_objectIds.constEnd()) {
+		ids.append(exact.value());
+	}
+
+	//    "path/"     
+	const QString prefix = path + '/';
+	auto it = m_objectIds.lowerBound(prefix);
+	for (; it != m_objectIds.constEnd() && it.key().startsWith(prefix); ++it) {
+		ids.append(it.value());
+	}
+	return ids;
+}
+
+void TagIndex::takeObjects(const QString& path, TagBitmap& removed)
+{
+	for (quint32 id : idsUnder(path)) {
+		removed.add(id);
+		m_objectIds.remove(m_objectPaths[int(id)]);
+		m_objectPaths[int(id)].clear();
+	}
+}
+
+void TagIndex::removeObject(const QString& objectPath)
+{
+	removeObjects(QStringList() << objectPath);
+}
+
+void TagIndex::removeObjects(const QStringList& objectPaths)
+{
+	//        
+	TagBitmap removed;
+	for (const QString &objectPath : objectPaths) {
+		takeObjects(normalizePath(objectPath), removed);
+	}
+	dropObjects(removed);
+}
+
+void TagIndex::removeExactObject(const QString& objectPath)
+{
+	const QString path = normalizePath(objectPath);
+	auto it = m_objectIds.find(path);
+	if (it == m_objectIds.end()) {
+		return;
+	}
+
+	TagBitmap removed;
+	removed.add(it.value());
+	m_objectPaths[int(it.value())].clear();
+	m_objectIds.erase(it);
+	dropObjects(removed);
+}
+
+void TagIndex::dropObjects(const TagBitmap& removed)
+{
+	if (removed.isEmpty()) {
+		return;
+	}
+
+	for (TagBitmap &posting : m_postings) {
+		posting -= removed;
+	}
+	m_universe -= removed;
+	for (TagBitmap &tree : m_treeCache) {
+		tree -= removed;
+	}
+	for (LiveQuery &live : m_liveQueries) {
+		live.result -= removed;
+	}
+	m_dirty = true;
+}
+
+void TagIndex::moveObject(const QString& oldPath, const QString& newPath)
+{
+	moveObjects(QVector<QPair<QString, QString>>() << qMakePair(oldPath, newPath));
+}
+
+void TagIndex::moveObjects(const QVector<QPair<QString, QString>>& moves)
+{
+	TagBitmap overwritten;
+	for (const auto &move : moves) {
+		relocateObjects(normalizePath(move.first), normalizePath(move.second), overwritten);
+	}
+	dropObjects(overwritten);
+}
+
+void TagIndex::relocateObjects(const QString& from, const QString& to, TagBitmap& overwritten)
+{
+	if (from == to) return;
+
+	//      ( )
+	const QVector<quint32> moved = idsUnder(from);
+	if (moved.isEmpty()) return;
+
+	//        . 
+	//   :      
+	TagBitmap movedIds;
+	for (quint32 id : moved) {
+		movedIds.add(id);
+	}
+	for (quint32 id : moved) {
+		const QString renamed = to + m_objectPaths[int(id)].mid(from.size());
+		auto it = m_objectIds.find(renamed);
+		if (it != m_objectIds.end() && !movedIds.contains(it.value())) {
+			overwritten.add(it.value());
+			m_objectPaths[int(it.value())].clear();
+			m_objectIds.erase(it);
+		}
+	}
+
+	for (quint32 id : moved) {
+		m_objectIds.remove(m_objectPaths[int(id)]);
+	}
+	for (quint32 id : moved) {
+		const QString renamed = to + m_objectPaths[int(id)].mid(from.size());
+		m_objectIds.insert(renamed, id);
+		m_objectPaths[int(id)] = renamed;
+	}
+	m_dirty = true;
+}
+
+TagBitmap TagIndex::objectsWithTag(const QString& tag) const
+{
+	const int posting = postingOf(tag);
+	if (posting < 0) {
+		return TagBitmap();
+	}
+	return m_postings[posting];
+}
+
+TagBitmap TagIndex::objectsWithTagTree(const QString& tag) const
+{
+	auto cached = m_treeCache.constFind(tag);
+	if (cached != m_treeCache.constEnd()) {
+		return cached.value();
+	}
+
+	const QPair<int, int> range = descendantRange(tag);
+	if (range.first == range.second) {
+		return objectsWithTag(tag);	//  -  
+	}
+
+	TagBitmap result = objectsWithTag(tag);
+	for (int i = range.first; i < range.second; ++i) {
+		result |= m_postings[int(m_sortedTags[i])];
+	}
+
+	m_treeCache.insert(tag, result);
+	return result;
+}
+
+QPair<int, int> TagIndex::descendantRange(const QString& tag) const
+{
+	if (m_sortedDirty) {
+		m_sortedTags.resize(m_postings.size());
+		for (int i = 0; i < m_sortedTags.size(); ++i) {
+			m_sortedTags[i] = quint32(i);
+		}
+		std::sort(m_sortedTags.begin(), m_sortedTags.end(), [this](quint32 a, quint32 b) {
+			return m_dictionary->name(a) < m_dictionary->name(b);
+		});
+		m_sortedDirty = false;
+	}
+
+	//     "tag/"  
+	const QString prefix = tag + '/';
+	auto first = std::lower_bound(m_sortedTags.constBegin(), m_sortedTags.constEnd(), prefix,
+		[this](quint32 id, const QString& value) { return m_dictionary->name(id) < value; });
+	auto last = std::partition_point(first, m_sortedTags.constEnd(),
+		[this, &prefix](quint32 id) { return m_dictionary->name(id).startsWith(prefix); });
+
+	return qMakePair(int(first - m_sortedTags.constBegin()), int(last - m_sortedTags.constBegin()));
+}
+
+void TagIndex::updateTrees(const QString& tag, quint32 id, const QSet<QString>& newTags)
+{
+	//      : "a/b/c" -> "a/b", "a".
+	//    ,       
+	QString ancestor = tag;
+	for (;;) {
+		auto it = m_treeCache.find(ancestor);
+		if (it != m_treeCache.end()) {
+			const QString prefix = ancestor + '/';
+			bool inTree = false;
+			for (const QString &other : newTags) {
+				if (other == ancestor || other.startsWith(prefix)) {
+					inTree = true;
+					break;
+				}
+			}
+			if (inTree)
+				it.value().add(id);
+			else
+				it.value().remove(id);
+		}
+
+		const int slash = ancestor.lastIndexOf('/');
+		if (slash <= 0) break;
+		ancestor.truncate(slash);
+	}
+}
+
+TagBitmap TagIndex::query(const QString& expression) const
+{
+	TagQuery q(expression);
+	if (!q.isValid()) {
+		qDebug() << "Invalid tag query:" << expression << q.errorString();
+		return TagBitmap();
+	}
+	return q.evaluate(*this);
+}
+
+void TagIndex::addLiveQuery(const QString& expression)
+{
+	auto it = m_liveQueries.find(expression);
+	if (it != m_liveQueries.end()) {
+		++it.value().refs;
+		return;
+	}
+
+	LiveQuery live;
+	live.query = TagQuery(expression);
+	live.refs = 1;
+	if (live.query.isValid()) {
+		live.result = live.query.evaluate(*this);
+	}
+	else {
+		qDebug() << "Invalid tag query:" << expression << live.query.errorString();
+	}
+	m_liveQueries.insert(expression, live);
+}
+
+void TagIndex::removeLiveQuery(const QString& expression)
+{
+	auto it = m_liveQueries.find(expression);
+	if (it != m_liveQueries.end() && --it.value().refs <= 0) {
+		m_liveQueries.erase(it);
+	}
+}
+
+TagBitmap TagIndex::liveQuery(const QString& expression) const
+{
+	auto it = m_liveQueries.constFind(expression);
+	if (it != m_liveQueries.constEnd()) {
+		return it.value().result;
+	}
+	return query(expression);
+}
+
+QVector<quint64> TagIndex::matchMask(const QString& expression, const QStringList& objectPaths) const
+{
+	QVector<quint64> mask((objectPaths.size() + 63) / 64, 0);
+
+	TagQuery q(expression);
+	if (!q.isValid()) {
+		return mask;
+	}
+	const TagBitmap matched = liveQuery(expression);
+
+	//       -    
+	const bool untagged = q.matches(QSet<QString>());
+
+	for (int i = 0; i < objectPaths.size(); ++i) {
+		auto it = m_objectIds.constFind(normalizePath(objectPaths[i]));
+		const bool match = it != m_objectIds.constEnd() ? matched.contains(it.value()) : untagged;
+		if (match) {
+			mask[i >> 6] |= quint64(1) << (i & 63);
+		}
+	}
+	return mask;
+}
+
+//   -      
+void TagIndex::refreshLiveQueries()
+{
+	for (LiveQuery &live : m_liveQueries) {
+		live.result = live.query.isValid() ? live.query.evaluate(*this) : TagBitmap();
+	}
+}
+
+int TagIndex::tagCount(const QString& tag) const
+{
+	const int posting = postingOf(tag);
+	if (posting < 0) {
+		return 0;
+	}
+	return m_postings[posting].count();
+}
+
+QStringList TagIndex::tags() const
+{
+	QStringList result;
+	for (int i = 0; i < m_postings.size(); ++i) {
+		if (!m_postings[i].isEmpty()) {
+			result.append(m_dictionary->name(quint32(i)));
+		}
+	}
+	return result;
+}
+
+QSet<QString> TagIndex::objectTags(const QString& objectPath) const
+{
+	QSet<QString> result;
+	auto it = m_objectIds.constFind(normalizePath(objectPath));
+	if (it == m_objectIds.constEnd()) {
+		return result;
+	}
+
+	for (int i = 0; i < m_postings.size(); ++i) {
+		if (m_postings[i].contains(it.value())) {
+			result.insert(m_dictionary->name(quint32(i)));
+		}
+	}
+	return result;
+}
+
+TagIndex::ScanResult TagIndex::objects() const
+{
+	QHash<quint32, QSet<QString>> byObject;
+	for (int i = 0; i < m_postings.size(); ++i) {
+		const QString tag = m_dictionary->name(quint32(i));
+		m_postings[i].forEach([&byObject, &tag](quint32 id) {
+			byObject[id].insert(tag);
+		});
+	}
+
+	ScanResult result;
+	result.roots = m_roots;
+	result.objects.reserve(byObject.size());
+	for (auto it = byObject.constBegin(); it != byObject.constEnd(); ++it) {
+		result.objects.append(qMakePair(objectPath(it.key()), it.value()));
+	}
+	return result;
+}
+
+TagIndex::ScanResult TagIndex::objectsUnder(const QString& objectPath) const
+{
+	return objectsUnder(QStringList() << objectPath);
+}
+
+TagIndex::ScanResult TagIndex::objectsUnder(const QStringList& objectPaths) const
+{
+	TagBitmap ids;
+	for (const QString &objectPath : objectPaths) {
+		for (quint32 id : idsUnder(normalizePath(objectPath))) {
+			ids.add(id);
+		}
+	}
+
+	ScanResult result;
+	if (ids.isEmpty()) {
+		return result;
+	}
+
+	QHash<quint32, QSet<QString>> byObject;
+	for (int i = 0; i < m_postings.size(); ++i) {
+		const QString tag = m_dictionary->name(quint32(i));
+		(m_postings[i] & ids).forEach([&byObject, &tag](quint32 id) {
+			byObject[id].insert(tag);
+		});
+	}
+
+	result.objects.reserve(byObject.size());
+	for (auto it = byObject.constBegin(); it != byObject.constEnd(); ++it) {
+		result.objects.append(qMakePair(this->objectPath(it.key()), it.value()));
+	}
+	return result;
+}
+
+QString TagIndex::objectPath(quint32 id) const
+{
+	if (int(id) >= m_objectPaths.size()) {
+		return QString();
+	}
+	return m_objectPaths[int(id)];
+}
+
+QStringList TagIndex::objectPaths(const TagBitmap& ids) const
+{
+	QStringList result;
+	result.reserve(ids.count());
+	ids.forEach([&](quint32 id) {
+		const QString path = objectPath(id);
+		if (!path.isEmpty()) {
+			result.append(path);
+		}
+	});
+	return result;
+}
+
+TagIndex::ScanResult TagIndex::scan(const QStringList& roots, const TagReader& reader)
+{
+	ScanResult result;
+	result.roots = roots;
+
+	// 1.   ( -    )
+	QSet<QString> seen;
+	QStringList candidates;
+
+	for (const QString &root : roots) {
+		if (root.isEmpty() || !QDir(root).exists()) continue;
+
+#if defined(Q_OS_WINDOWS) || defined(Q_OS_LINUX)
+		// ADS/xattr     -   
+		QDirIterator it(root, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden,
+			QDirIterator::Subdirectories);
+#else
+		//   sidecar-
+		QDirIterator it(root, QStringList() << "*.tags", QDir::Files | QDir::Hidden,
+			QDirIterator::Subdirectories);
+#endif
+		while (it.hasNext()) {
+			QString path = normalizePath(it.next());
+			if (path.endsWith(".tags")) {
+				path.chop(5);
+			}
+			if (!seen.contains(path)) {
+				seen.insert(path);
+				candidates.append(path);
+			}
+		}
+	}
+
+	// 2.   
+	ReadTagsFunctor functor;
+	functor.reader = reader;
+	QVector<QPair<QString, QSet<QString>>> all =
+		QtConcurrent::blockingMapped<QVector<QPair<QString, QSet<QString>>>>(candidates, functor);
+
+	for (const auto &entry : all) {
+		if (!entry.second.isEmpty()) {
+			result.objects.append(entry);
+		}
+	}
+
+	qDebug() << "Tag index scan:" << candidates.size() << "candidates,"
+		<< result.objects.size() << "tagged objects";
+	return result;
+}
+
+void TagIndex::adopt(const ScanResult& result)
+{
+	clear();
+	m_roots = result.roots;
+
+	for (const auto &entry : result.objects) {
+		const quint32 id = objectId(entry.first);
+		for (const QString &tag : entry.second) {
+			m_postings[int(tagId(tag))].add(id);
+		}
+	}
+
+	refreshLiveQueries();
+	m_dirty = true;
+}
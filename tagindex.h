@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QPair>
+#include <functional>
+#include "tagbitmap.h"
+#include "tagquery.h"
+#include "tagdictionary.h"
+
+//   :  ->   .
+//          
+//       .
+// Id  -     (TagManager).
+class TagIndex
+{
+public:
+	//     (sidecar, ADS  ..)
+	typedef std::function<bool(const QString&, QSet<QString>&)> TagReader;
+
+	//     (  )
+	struct ScanResult
+	{
+		QStringList roots;
+		QVector<QPair<QString, QSet<QString>>> objects;
+	};
+
+	explicit TagIndex(TagDictionary *dictionary);
+
+	// /
+	bool load(const QString& indexPath);
+	bool save();
+	QString indexPath() const { return m_indexPath; }
+	bool isDirty() const { return m_dirty; }
+	QStringList roots() const { return m_roots; }
+
+	//  
+	void updateObject(const QString& objectPath, const QSet<QString>& oldTags, const QSet<QString>& newTags);
+	void removeObject(const QString& objectPath);					//   
+	void removeObjects(const QStringList& objectPaths);				// ,   
+	void removeExactObject(const QString& objectPath);				//   
+	void moveObject(const QString& oldPath, const QString& newPath);	//   
+	void moveObjects(const QVector<QPair<QString, QString>>& moves);	// ,  
+
+	// 
+	TagBitmap objectsWithTag(const QString& tag) const;
+	TagBitmap objectsWithTagTree(const QString& tag) const;	//    "tag/..."
+	TagBitmap allObjects() const { return m_universe; }
+	TagBitmap query(const QString& expression) const;
+	int tagCount(const QString& tag) const;
+	QStringList tags() const;
+	QSet<QString> objectTags(const QString& objectPath) const;	//   
+	ScanResult objects() const;		//     ( )
+	ScanResult objectsUnder(const QString& objectPath) const;	//   
+	ScanResult objectsUnder(const QStringList& objectPaths) const;
+
+	//  :      
+	//  ,   
+	void addLiveQuery(const QString& expression);
+	void removeLiveQuery(const QString& expression);
+	TagBitmap liveQuery(const QString& expression) const;	//   - query()
+
+	//  i -  objectPaths[i]    (  )
+	QVector<quint64> matchMask(const QString& expression, const QStringList& objectPaths) const;
+
+	QString objectPath(quint32 id) const;
+	QStringList objectPaths(const TagBitmap& ids) const;
+	int objectCount() const { return m_universe.count(); }
+
+	//  : scan()     
+	static ScanResult scan(const QStringList& roots, const TagReader& reader);
+	void adopt(const ScanResult& result);
+
+	static QString normalizePath(const QString& path);
+
+private:
+	QString m_indexPath;
+	QStringList m_roots;
+	bool m_dirty;
+
+	//   ;       
+	TagDictionary *m_dictionary;
+	QVector<TagBitmap> m_postings;	// id  -> 
+
+	//  ;    -      
+	//      
+	QMap<QString, quint32> m_objectIds;
+	QVector<QString> m_objectPaths;	// objectId ->  (  )
+	TagBitmap m_universe;			//   
+
+	// : id    -  "a/b/..."  
+	// ;       
+	//       
+	mutable QVector<quint32> m_sortedTags;
+	mutable bool m_sortedDirty;
+	mutable QHash<QString, TagBitmap> m_treeCache;
+
+	//     (   )
+	struct LiveQuery
+	{
+		TagQuery query;
+		TagBitmap result;
+		int refs;
+	};
+	QHash<QString, LiveQuery> m_liveQueries;
+
+	void refreshLiveQueries();
+
+	QPair<int, int> descendantRange(const QString& tag) const;
+	void updateTrees(const QString& tag, quint32 id, const QSet<QString>& newTags);
+
+	void clear();
+	QVector<quint32> idsUnder(const QString& path) const;	//   
+	void takeObjects(const QString& path, TagBitmap& removed);
+	void relocateObjects(const QString& from, const QString& to, TagBitmap& overwritten);
+	void dropObjects(const TagBitmap& removed);	//    m_objectIds
+	quint32 tagId(const QString& tag);				//  ,   
+	int postingOf(const QString& tag) const;		// -1 -  
+	quint32 objectId(const QString& path);
+};
@@ -0,0 +1,70 @@
+#include "tagloader.h"
+#include "tracer.h"
+#include <QDebug>
+
+//   ,    
+static const int CANCEL_CHECK_INTERVAL = 64;
+
+TagLoader::TagLoader(QObject *parent)
+	: QObject(parent)
+	, m_latestRequest(0)
+	, m_latestPrefetch(0)
+{
+}
+
+TagLoader::~TagLoader()
+{
+}
+
+void TagLoader::loadTags(int requestId, const QStringList& paths)
+{
+	TraceScope trace("tag_load_batch", QString::number(paths.size()));
+	TagMap result;
+	result.reserve(paths.size());
+
+	for (int i = 0; i < paths.size(); ++i) {
+		//   -      
+		if (i % CANCEL_CHECK_INTERVAL == 0 && m_latestRequest.loadAcquire() != requestId) {
+			if (!result.isEmpty()) {
+				emit tagsPrefetched(result);
+			}
+			return;
+		}
+
+		QSet<QString> tags;
+		m_storage.load(paths[i], tags);
+		result.insert(paths[i], tags);
+	}
+
+	emit tagsLoaded(requestId, result);
+}
+
+void TagLoader::prefetchTags(int prefetchId, const QStringList& paths)
+{
+	TraceScope trace("tag_prefetch_batch", QString::number(paths.size()));
+	TagMap result;
+	result.reserve(paths.size());
+
+	for (int i = 0; i < paths.size(); ++i) {
+		if (i % CANCEL_CHECK_INTERVAL == 0 && m_latestPrefetch.loadAcquire() != prefetchId) {
+			break;
+		}
+
+		QSet<QString> tags;
+		m_storage.load(paths[i], tags);
+		result.insert(paths[i], tags);
+	}
+
+	if (!result.isEmpty()) {
+		emit tagsPrefetched(result);
+	}
+}
+
+void TagLoader::loadDirectory(const QString& dirPath)
+{
+	TraceScope trace("tag_load_directory", dirPath);
+	TagMap result;
+	if (m_storage.loadDirectory(dirPath, result)) {
+		emit tagsPrefetched(result);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QAtomicInt>
+#include "tagstorage.h"
+
+typedef QHash<QString, QSet<QString>> TagMap;	//  -> 
+Q_DECLARE_METATYPE(TagMap)
+
+//    (   ,  ThumbnailLoader).
+//     .
+class TagLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit TagLoader(QObject *parent = nullptr);
+	~TagLoader();
+
+	//   GUI-     
+	void setLatestRequest(int requestId) { m_latestRequest.storeRelease(requestId); }
+	void setLatestPrefetch(int prefetchId) { m_latestPrefetch.storeRelease(prefetchId); }
+
+public slots:
+	void loadTags(int requestId, const QStringList& paths);
+	void prefetchTags(int prefetchId, const QStringList& paths);
+	void loadDirectory(const QString& dirPath);
+
+signals:
+	void tagsLoaded(int requestId, const TagMap& tags);
+	void tagsPrefetched(const TagMap& tags);
+
+private:
+	SidecarTagStorage m_storage;	//   -    
+	QAtomicInt m_latestRequest;
+	QAtomicInt m_latestPrefetch;
+};
@@ -1,21 +1,103 @@
 #include "tagmanager.h"
+#include "perfstats.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QTextStream>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QTimer>
+#include <QThread>
+#include <atomic>
+#include <QtConcurrent>
+
+namespace
+{
+	//   QtConcurrent:    
+	struct RewriteObjectFunctor
+	{
+		typedef TagRewrite::Result result_type;
+
+		const TagRewrite *rewrite;
+		TagStorage *storage;
+
+		result_type operator()(const QString& path) const
+		{
+			return rewrite->rewriteObject(storage, path);
+		}
+	};
+}
 
 TagManager::TagManager(QObject *parent)
 	: QObject(parent)
+	, m_snapshot(std::make_shared<TagSnapshot>())
+	, m_snapshotVersion(0)
+	, m_snapshotDirty(false)
+	, m_storage(&m_sidecars)
+	, m_index(&m_dictionary)
+	, m_indexSaveTimer(nullptr)
+	, m_rebuildWatcher(nullptr)
+	, m_rewriteWatcher(nullptr)
+	, m_loaderThread(nullptr)
+	, m_loader(nullptr)
+	, m_lastRequestId(0)
+	, m_lastPrefetchId(0)
 {
+	//    ,       
+	m_indexSaveTimer = new QTimer(this);
+	m_indexSaveTimer->setSingleShot(true);
+	m_indexSaveTimer->setInterval(2000);
+	connect(m_indexSaveTimer, &QTimer::timeout, this, &TagManager::saveIndex);
+
+	m_rebuildWatcher = new QFutureWatcher<TagIndex::ScanResult>(this);
+	connect(m_rebuildWatcher, &QFutureWatcher<TagIndex::ScanResult>::finished,
+		this, &TagManager::onIndexScanFinished);
+
+	m_rewriteWatcher = new QFutureWatcher<TagRewrite::Result>(this);
+	connect(m_rewriteWatcher, &QFutureWatcher<TagRewrite::Result>::finished,
+		this, &TagManager::onTagRewriteFinished);
+	connect(m_rewriteWatcher, &QFutureWatcher<TagRewrite::Result>::progressValueChanged,
+		this, [this](int value) {
+		emit tagOperationProgress(value, m_rewriteWatcher->progressMaximum());
+	});
+
+	//     
+	qRegisterMetaType<TagMap>("TagMap");
+	m_loaderThread = new QThread(this);
+	m_loaderThread->setObjectName("TagLoader");
+	m_loader = new TagLoader();
+	m_loader->moveToThread(m_loaderThread);
+	connect(m_loaderThread, &QThread::finished, m_loader, &QObject::deleteLater);
+	connect(m_loader, &TagLoader::tagsLoaded, this, &TagManager::onTagsLoaded);
+	connect(m_loader, &TagLoader::tagsPrefetched, this, &TagManager::onTagsPrefetched);
+	m_loaderThread->start();
 }
 
 TagManager::~TagManager()
 {
+	//      
+	m_loader->setLatestRequest(-1);
+	m_loader->setLatestPrefetch(-1);
+	m_loaderThread->quit();
+	m_loaderThread->wait();
+
+	//        
+	m_rewriteWatcher->waitForFinished();
+	m_rebuildWatcher->waitForFinished();
+	saveIndex();
+	m_database.close();
 }
 
 bool TagManager::loadTags(const QString& tagsFilePath)
 {
 	m_tagsFilePath = tagsFilePath;
+	m_index.load(m_tagsFilePath + ".idx");
+
+	//    ( ) -   
+	if (!m_cooccurrence.load(m_tagsFilePath + ".cooc") && m_index.objectCount() > 0) {
+		m_cooccurrence.rebuild(m_index.objects().objects);
+	}
+	loadSmartFolders();
 	return loadAllTags();
 }
 
@@ -76,47 +158,255 @@ bool TagManager::saveAllTags()
 	return true;
 }
 
+//  :   "<TAB>"
+bool TagManager::loadSmartFolders()
+{
+	for (const SmartFolder &folder : m_smartFolders) {
+		m_index.removeLiveQuery(folder.expression);
+	}
+	m_smartFolders.clear();
+
+	QFile file(m_tagsFilePath + ".smart");
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return false;
+	}
+
+	QTextStream in(&file);
+	while (!in.atEnd()) {
+		const QString line = in.readLine();
+		const int tab = line.indexOf('\t');
+		if (tab <= 0) {
+			continue;
+		}
+
+		SmartFolder folder;
+		folder.name = line.left(tab).trimmed();
+		folder.expression = line.mid(tab + 1).trimmed();
+		m_smartFolders.append(folder);
+		m_index.addLiveQuery(folder.expression);
+	}
+
+	file.close();
+	qDebug() << "Loaded" << m_smartFolders.size() << "smart folders";
+	return true;
+}
+
+bool TagManager::saveSmartFolders()
+{
+	if (m_tagsFilePath.isEmpty()) {
+		return false;
+	}
+
+	// QSaveFile -       
+	QSaveFile file(m_tagsFilePath + ".smart");
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		qDebug() << "Cannot save smart folders:" << file.fileName() << file.errorString();
+		return false;
+	}
+
+	QTextStream out(&file);
+	for (const SmartFolder &folder : m_smartFolders) {
+		out << folder.name << "\t" << folder.expression << "\n";
+	}
+	out.flush();
+
+	if (!file.commit()) {
+		qDebug() << "Cannot commit smart folders:" << file.fileName() << file.errorString();
+		return false;
+	}
+	return true;
+}
+
+int TagManager::findSmartFolder(const QString& name) const
+{
+	for (int i = 0; i < m_smartFolders.size(); ++i) {
+		if (m_smartFolders[i].name == name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool TagManager::addSmartFolder(const QString& name, const QString& expression)
+{
+	if (name.isEmpty() || name.contains('\t') || findSmartFolder(name) >= 0) {
+		return false;
+	}
+
+	TagQuery query(expression);
+	if (!query.isValid()) {
+		qDebug() << "Invalid smart folder query:" << expression << query.errorString();
+		return false;
+	}
+
+	SmartFolder folder;
+	folder.name = name;
+	folder.expression = query.expression();
+	m_smartFolders.append(folder);
+	m_index.addLiveQuery(folder.expression);
+
+	saveSmartFolders();
+	emit smartFoldersChanged();
+	return true;
+}
+
+bool TagManager::removeSmartFolder(const QString& name)
+{
+	const int i = findSmartFolder(name);
+	if (i < 0) {
+		return false;
+	}
+
+	m_index.removeLiveQuery(m_smartFolders[i].expression);
+	m_smartFolders.remove(i);
+
+	saveSmartFolders();
+	emit smartFoldersChanged();
+	return true;
+}
+
+QStringList TagManager::smartFolderObjects(const QString& name) const
+{
+	const int i = findSmartFolder(name);
+	if (i < 0) {
+		return QStringList();
+	}
+	PerfTimer timer(PerfStats::TagQuery);
+	return m_index.objectPaths(m_index.liveQuery(m_smartFolders[i].expression));
+}
+
+int TagManager::smartFolderCount(const QString& name) const
+{
+	const int i = findSmartFolder(name);
+	if (i < 0) {
+		return 0;
+	}
+	PerfTimer timer(PerfStats::TagQuery);
+	return m_index.liveQuery(m_smartFolders[i].expression).count();
+}
+
 QSet<QString> TagManager::getObjectTags(const QString& objectPath) 
 {
 	//    
-	if (m_objectTags.contains(objectPath)) {
-		return m_objectTags[objectPath];
+	const QString key = TagIndex::normalizePath(objectPath);
+	TagSet cached;
+	if (m_objectTags.value(key, cached)) {
+		return m_dictionary.toStrings(cached);
 	}
 
-	//   ADS (Windows)  
+	//    (ADS,   )
 	QSet<QString> tags;
-	loadTagsFromADS(objectPath, tags);
+	{
+		PerfTimer timer(PerfStats::TagLoad, objectPath);
+		m_storage->load(objectPath, tags);
+	}
 
-	//   
-	const_cast<QMap<QString, QSet<QString>>&>(m_objectTags)[objectPath] = tags;
+	//   ;    -   
+	m_objectTags.insert(key, m_dictionary.toSet(tags));
 
 	return tags;
 }
 
 bool TagManager::setObjectTags(const QString& objectPath, const QSet<QString>& tags)
 {
-	//   ADS
-	if (!saveTagsToADS(objectPath, tags)) {
+	TagMap changes;
+	changes.insert(objectPath, tags);
+	return applyTagChanges(changes);
+}
+
+bool TagManager::applyTagChanges(const TagMap& changes)
+{
+	//        -  
+	//    
+	if (isTagOperationRunning()) {
+		qDebug() << "Tag changes refused: tag operation is running";
 		return false;
 	}
 
-	//  
-	m_objectTags[objectPath] = tags;
+	bool success = true;
+	bool applied = false;
+	bool newGlobalTags = false;
+
+	for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		const QString &objectPath = it.key();
+		const QSet<QString> &tags = it.value();
 
-	//      
-	for (const QString &tag : tags) {
-		if (!m_allTags.contains(tag)) {
-			m_allTags.insert(tag);
+		//       
+		QSet<QString> oldTags = getObjectTags(objectPath);
+
+		//   
+		PerfTimer saveTimer(PerfStats::TagSave, objectPath);
+		if (!m_storage->save(objectPath, tags)) {
+			success = false;
+			continue;
+		}
+		saveTimer.stop();
+
+		//    
+		m_objectTags.insert(TagIndex::normalizePath(objectPath), m_dictionary.toSet(tags));
+		m_index.updateObject(objectPath, oldTags, tags);
+		m_cooccurrence.update(oldTags, tags);
+		applied = true;
+
+		//      
+		for (const QString &tag : tags) {
+			if (!m_allTags.contains(tag)) {
+				m_allTags.insert(tag);
+				newGlobalTags = true;
+			}
 		}
+
+		emit tagsChanged(objectPath);
 	}
 
-	//    
-	saveAllTags();
+	if (!applied) {
+		return success;
+	}
 
-	emit tagsChanged(objectPath);
+	//  ,         
+	schedulePublish();
+	scheduleIndexSave();
+	if (newGlobalTags) {
+		saveAllTags();
+	}
 	emit globalTagsChanged();
 
-	return true;
+	return success;
+}
+
+TagSnapshotPtr TagManager::snapshot()
+{
+	//      ,   
+	if (QThread::currentThread() == thread() && m_snapshotDirty) {
+		publishSnapshot();
+	}
+	return std::atomic_load(&m_snapshot);
+}
+
+void TagManager::schedulePublish()
+{
+	if (m_snapshotDirty) {
+		return;
+	}
+	m_snapshotDirty = true;
+	QTimer::singleShot(0, this, &TagManager::publishSnapshot);
+}
+
+void TagManager::publishSnapshot()
+{
+	if (!m_snapshotDirty) {
+		return;
+	}
+	m_snapshotDirty = false;
+	PerfTimer timer(PerfStats::SnapshotPublish);
+
+	//      ;   
+	//     ,      
+	TagSnapshotPtr published = std::make_shared<TagSnapshot>(m_dictionary, m_objectTags,
+		++m_snapshotVersion);
+	std::atomic_store(&m_snapshot, published);
+
+	emit snapshotPublished(m_snapshotVersion);
 }
 
 void TagManager::addGlobalTag(const QString& tag)
@@ -130,92 +420,556 @@ void TagManager::addGlobalTag(const QString& tag)
 
 bool TagManager::removeGlobalTag(const QString& tag)
 {
-	if (m_allTags.remove(tag)) {
-		saveAllTags();
+	if (!m_allTags.contains(tag)) {
+		return false;
+	}
 
-		//      
-		for (auto it = m_objectTags.begin(); it != m_objectTags.end(); ++it) {
-			it.value().remove(tag);
-		}
+	//        
+	return deleteTag(tag);
+}
 
-		emit globalTagsChanged();
-		return true;
+bool TagManager::renameTag(const QString& oldName, const QString& newName)
+{
+	//     -   
+	return mergeTags(QStringList() << oldName, newName);
+}
+
+bool TagManager::mergeTags(const QStringList& sources, const QString& target)
+{
+	if (target.trimmed().isEmpty()) {
+		return false;
 	}
-	return false;
+	return startTagRewrite(TagRewrite(sources, target));
 }
 
+bool TagManager::deleteTag(const QString& tag)
+{
+	return startTagRewrite(TagRewrite(QStringList() << tag, QString()));
+}
 
-bool TagManager::loadTagsFromADS(const QString& filePath, QSet<QString>& tags)
+bool TagManager::resumeTagOperation()
 {
-#ifdef Q_OS_WINDOWS
-	// Windows:  ADS,    - .tags 
-	QString streamPath = filePath + ":tags";
-	QFile adsFile(streamPath);
+	if (isTagOperationRunning() || journalPath().isEmpty() || !QFile::exists(journalPath())) {
+		return false;
+	}
 
-	if (adsFile.exists() && adsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		QTextStream in(&adsFile);
-		QString content = in.readAll();
-		adsFile.close();
+	TagRewrite rewrite;
+	if (!rewrite.loadJournal(journalPath())) {
+		return false;
+	}
 
-		QStringList tagList = content.split(' ', Qt::SkipEmptyParts);
-		for (const QString &tag : tagList) {
-			tags.insert(tag.trimmed());
-		}
-		return true;
+	//      - ,   
+	if (rewrite.storageName() != m_storage->name()) {
+		qDebug() << "Tag journal is for" << rewrite.storageName() << "storage, current is" << m_storage->name();
+		return false;
 	}
-#endif
 
-	//  fallback: .tags  
-	QString tagsFilePath = filePath + ".tags";
-	QFile file(tagsFilePath);
+	qDebug() << "Resuming interrupted tag operation:" << rewrite.sources() << "->" << rewrite.target();
+	return startTagRewrite(rewrite);
+}
 
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+QString TagManager::journalPath() const
+{
+	return m_tagsFilePath.isEmpty() ? QString() : m_tagsFilePath + ".journal";
+}
+
+bool TagManager::startTagRewrite(const TagRewrite& rewrite)
+{
+	if (!rewrite.isValid() || isTagOperationRunning()) {
 		return false;
 	}
 
-	QTextStream in(&file);
-	QString content = in.readAll();
-	file.close();
+	m_rewrite = rewrite;
+	m_rewriteMoves.clear();
+
+	//      (  -  )
+	if (m_rewrite.objectPaths().isEmpty()) {
+		TagBitmap affected;
+		for (const QString &source : m_rewrite.sources()) {
+			affected |= m_index.objectsWithTag(source);
+		}
+		QStringList paths = m_index.objectPaths(affected);
 
-	QStringList tagList = content.split(' ', Qt::SkipEmptyParts);
-	for (const QString &tag : tagList) {
-		tags.insert(tag.trimmed());
+		//      
+		QSet<QString> indexed;
+		for (const QString &path : paths) {
+			indexed.insert(path);
+		}
+		m_objectTags.forEach([&](const QString& path, const TagSet& tags) {
+			if (indexed.contains(path)) return;
+			for (const QString &source : m_rewrite.sources()) {
+				const int id = m_dictionary.id(source);
+				if (id >= 0 && tags.contains(quint32(id))) {
+					paths.append(path);
+					indexed.insert(path);
+					break;
+				}
+			}
+		});
+
+		m_rewrite.setObjectPaths(paths);
+		m_rewrite.setStorageName(m_storage->name());
+	}
+
+	//        -   
+	if (!journalPath().isEmpty()) {
+		m_rewrite.saveJournal(journalPath());
+	}
+
+	//     
+	for (const QString &source : m_rewrite.sources()) {
+		m_allTags.remove(source);
+	}
+	if (!m_rewrite.isDelete()) {
+		m_allTags.insert(m_rewrite.target());
+	}
+	saveAllTags();
+	emit globalTagsChanged();
+
+	qDebug() << "Rewriting tags" << m_rewrite.sources() << "->" << m_rewrite.target()
+		<< "in" << m_rewrite.objectPaths().size() << "objects";
+
+	//          
+	if (m_storage != &m_sidecars) {
+		QList<TagRewrite::Result> results;
+		for (const QString &path : m_rewrite.objectPaths()) {
+			results.append(m_rewrite.rewriteObject(m_storage, path));
+		}
+		finishTagRewrite(results);
+		return true;
 	}
 
+	// Sidecar-  xattr  -   
+	RewriteObjectFunctor functor = { &m_rewrite, &m_sidecars };
+	m_rewriteWatcher->setFuture(QtConcurrent::mapped(m_rewrite.objectPaths(), functor));
 	return true;
 }
 
-bool TagManager::saveTagsToADS(const QString& filePath, const QSet<QString>& tags)
+void TagManager::onTagRewriteFinished()
 {
-	QStringList tagList = tags.values();
-	std::sort(tagList.begin(), tagList.end());
-	QString content = tagList.join(' ');
+	finishTagRewrite(m_rewriteWatcher->future().results());
+}
 
-#ifdef Q_OS_WINDOWS
-	// Windows:  ADS 
-	QString streamPath = filePath + ":tags";
-	QFile adsFile(streamPath);
+void TagManager::finishTagRewrite(const QList<TagRewrite::Result>& results)
+{
+	//      ,   -
+	// :      , 
+	//  
+	QSet<QString> sources;
+	for (const QString &source : m_rewrite.sources()) {
+		sources.insert(source);
+	}
 
-	if (adsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-		QTextStream out(&adsFile);
-		out << content;
-		adsFile.close();
-		return true;
+	int changed = 0;
+	int failed = 0;
+	for (TagRewrite::Result result : results) {
+		//       : 
+		// ,      
+		QString path = result.path;
+		for (const auto &move : m_rewriteMoves) {
+			path = TagRewrite::relocatedPath(path, move.first, move.second);
+			if (path.isEmpty()) break;
+		}
+		if (path.isEmpty()) {
+			continue;
+		}
+		if (path != result.path) {
+			result = m_rewrite.rewriteObject(m_storage, path);
+		}
+
+		if (!result.ok) {
+			++failed;
+			continue;
+		}
+
+		QSet<QString> indexedTags = result.oldTags;
+		indexedTags.unite(sources);
+		indexedTags.remove(m_rewrite.target());
+		m_index.updateObject(result.path, indexedTags, result.newTags);
+
+		const QString key = TagIndex::normalizePath(result.path);
+		if (m_objectTags.contains(key)) {
+			m_objectTags.insert(key, m_dictionary.toSet(result.newTags));
+		}
+
+		if (result.changed) {
+			m_cooccurrence.update(result.oldTags, result.newTags);
+			++changed;
+			emit tagsChanged(result.path);
+		}
 	}
-#endif
 
-	//  fallback: .tags 
-	QString tagsFilePath = filePath + ".tags";
-	QFile file(tagsFilePath);
+	//  ,  -   -   
+	if (failed == 0 && !journalPath().isEmpty()) {
+		QFile::remove(journalPath());
+	}
 
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-		qDebug() << "Cannot save tags to:" << tagsFilePath << file.errorString();
+	qDebug() << "Tag rewrite finished:" << changed << "changed," << failed << "failed";
+	m_rewrite = TagRewrite();
+	m_rewriteMoves.clear();
+
+	scheduleIndexSave();
+	schedulePublish();
+	emit globalTagsChanged();
+	emit tagOperationFinished(changed, failed);
+}
+
+bool TagManager::openDatabase(const QString& dbPath)
+{
+	m_database.close();
+	m_storage = &m_sidecars;
+	m_objectTags.clear();
+	schedulePublish();
+
+	if (dbPath.isEmpty()) {
 		return false;
 	}
 
-	QTextStream out(&file);
-	out << content;
-	file.close();
+	if (!m_database.open(dbPath)) {
+		qDebug() << "Falling back to sidecar tags";
+		return false;
+	}
 
+	m_storage = &m_database;
+	rebuildIndex();
 	return true;
-}
\ No newline at end of file
+}
+
+int TagManager::importSidecars(bool removeSidecars)
+{
+	if (!m_database.isOpen()) {
+		return 0;
+	}
+
+	//     ,    
+	TagIndex::ScanResult scan = TagIndex::scan(m_indexRoots,
+		TagIndex::TagReader(&SidecarTagStorage::loadTagsFromADS));
+
+	int imported = 0;
+	for (const auto &entry : scan.objects) {
+		QSet<QString> oldTags = getObjectTags(entry.first);
+		QSet<QString> merged = oldTags;
+		merged.unite(entry.second);
+
+		if (!m_database.save(entry.first, merged)) {
+			continue;
+		}
+		m_objectTags.insert(entry.first, m_dictionary.toSet(merged));
+		m_index.updateObject(entry.first, oldTags, merged);
+		m_cooccurrence.update(oldTags, merged);
+		m_allTags.unite(merged);
+		++imported;
+
+		if (removeSidecars) {
+			m_sidecars.remove(entry.first);
+		}
+	}
+
+	saveAllTags();
+	scheduleIndexSave();
+	schedulePublish();
+	emit globalTagsChanged();
+
+	qDebug() << "Imported tags of" << imported << "objects from sidecars";
+	return imported;
+}
+
+int TagManager::exportSidecars()
+{
+	QVector<QPair<QString, QSet<QString>>> entries;
+	if (!m_database.isOpen() || !m_database.entries(entries)) {
+		return 0;
+	}
+
+	int exported = 0;
+	for (const auto &entry : entries) {
+		if (m_sidecars.save(entry.first, entry.second)) {
+			++exported;
+		}
+	}
+
+	qDebug() << "Exported tags of" << exported << "objects to sidecars";
+	return exported;
+}
+
+void TagManager::prefetchDirectory(const QString& dirPath)
+{
+	// Sidecar-  xattr   ,    GUI
+	if (m_storage == &m_sidecars) {
+		QMetaObject::invokeMethod(m_loader, "loadDirectory", Qt::QueuedConnection,
+			Q_ARG(QString, dirPath));
+		return;
+	}
+
+	TagMap tags;
+	if (m_storage->loadDirectory(dirPath, tags)) {
+		cacheLoadedTags(tags);
+	}
+}
+
+bool TagManager::cachedObjectTags(const QString& objectPath, TagSet& tags) const
+{
+	return m_objectTags.value(TagIndex::normalizePath(objectPath), tags);
+}
+
+int TagManager::requestObjectTags(const QStringList& objectPaths)
+{
+	const int requestId = ++m_lastRequestId;
+
+	QStringList missing;
+	for (const QString &path : objectPaths) {
+		if (!m_objectTags.contains(TagIndex::normalizePath(path))) {
+			missing.append(path);
+		}
+	}
+
+	//     -    
+	if (missing.isEmpty() || m_storage != &m_sidecars) {
+		for (const QString &path : missing) {
+			getObjectTags(path);
+		}
+		QMetaObject::invokeMethod(this, [this, requestId]() {
+			emit objectTagsReady(requestId);
+		}, Qt::QueuedConnection);
+		return requestId;
+	}
+
+	//    ,   
+	m_loader->setLatestRequest(requestId);
+	QMetaObject::invokeMethod(m_loader, "loadTags", Qt::QueuedConnection,
+		Q_ARG(int, requestId), Q_ARG(QStringList, missing));
+	return requestId;
+}
+
+void TagManager::prefetchObjectTags(const QStringList& objectPaths)
+{
+	if (m_storage != &m_sidecars) {
+		return;
+	}
+
+	QStringList missing;
+	for (const QString &path : objectPaths) {
+		if (!m_objectTags.contains(TagIndex::normalizePath(path))) {
+			missing.append(path);
+		}
+	}
+	if (missing.isEmpty()) {
+		return;
+	}
+
+	const int prefetchId = ++m_lastPrefetchId;
+	m_loader->setLatestPrefetch(prefetchId);
+	QMetaObject::invokeMethod(m_loader, "prefetchTags", Qt::QueuedConnection,
+		Q_ARG(int, prefetchId), Q_ARG(QStringList, missing));
+}
+
+void TagManager::onTagsLoaded(int requestId, const TagMap& tags)
+{
+	cacheLoadedTags(tags);
+	emit objectTagsReady(requestId);
+}
+
+void TagManager::onTagsPrefetched(const TagMap& tags)
+{
+	cacheLoadedTags(tags);
+}
+
+void TagManager::cacheLoadedTags(const TagMap& tags)
+{
+	//  ,    -   
+	if (m_storage != &m_sidecars) {
+		return;
+	}
+
+	//    :     
+	for (auto it = tags.constBegin(); it != tags.constEnd(); ++it) {
+		const QString key = TagIndex::normalizePath(it.key());
+		if (!m_objectTags.contains(key)) {
+			m_objectTags.insert(key, m_dictionary.toSet(it.value()));
+		}
+	}
+}
+
+void TagManager::rewriteObjectMoved(const QString& oldPath, const QString& newPath)
+{
+	if (!isTagOperationRunning()) {
+		return;
+	}
+	m_rewriteMoves.append(qMakePair(oldPath, newPath));
+
+	//         , 
+	//    .  ,    
+	//   
+	if (m_rewrite.relocateObjects(oldPath, newPath) && !journalPath().isEmpty()) {
+		m_rewrite.saveJournal(journalPath());
+	}
+}
+
+void TagManager::objectMoved(const QString& oldPath, const QString& newPath)
+{
+	objectsMoved(QVector<QPair<QString, QString>>() << qMakePair(oldPath, newPath));
+}
+
+void TagManager::objectRemoved(const QString& objectPath)
+{
+	objectsRemoved(QStringList() << objectPath);
+}
+
+void TagManager::objectsMoved(const QVector<QPair<QString, QString>>& moves)
+{
+	if (moves.isEmpty()) {
+		return;
+	}
+
+	for (const auto &move : moves) {
+		const QString &oldPath = move.first;
+		const QString &newPath = move.second;
+		const QString from = TagIndex::normalizePath(oldPath);
+		rewriteObjectMoved(oldPath, newPath);
+
+		// ,       
+		TagSet cached;
+		QSet<QString> expected = m_objectTags.value(from, cached)
+			? m_dictionary.toStrings(cached) : m_index.objectTags(from);
+
+		//    (  sidecar-)
+		m_storage->move(oldPath, newPath);
+
+		//       ,  xattr/ADS 
+		if (!expected.isEmpty() && QFileInfo(newPath).isFile()) {
+			QSet<QString> actual;
+			m_storage->load(newPath, actual);
+			if (actual != expected) {
+				m_storage->save(newPath, expected);
+			}
+		}
+
+		//    (  -   )
+		const QString to = TagIndex::normalizePath(newPath);
+		for (const auto &entry : m_objectTags.take(from)) {
+			m_objectTags.insert(to + entry.first.mid(from.size()), entry.second);
+		}
+	}
+
+	m_index.moveObjects(moves);
+	scheduleIndexSave();
+	schedulePublish();
+}
+
+void TagManager::objectsRemoved(const QStringList& objectPaths)
+{
+	if (objectPaths.isEmpty()) {
+		return;
+	}
+
+	for (const QString &objectPath : objectPaths) {
+		rewriteObjectMoved(objectPath, QString());
+		m_storage->remove(objectPath);
+		m_objectTags.take(TagIndex::normalizePath(objectPath));
+	}
+
+	//    :       
+	for (const auto &entry : m_index.objectsUnder(objectPaths).objects) {
+		m_cooccurrence.update(entry.second, QSet<QString>());
+	}
+
+	m_index.removeObjects(objectPaths);
+	scheduleIndexSave();
+	schedulePublish();
+}
+
+void TagManager::setIndexRoots(const QStringList& roots)
+{
+	QStringList normalized;
+	for (const QString &root : roots) {
+		if (root.isEmpty()) continue;
+		QString path = TagIndex::normalizePath(root);
+		if (!normalized.contains(path)) {
+			normalized.append(path);
+		}
+	}
+
+	m_indexRoots = normalized;
+
+	//      - 
+	if (m_index.roots() != m_indexRoots) {
+		rebuildIndex();
+	}
+}
+
+void TagManager::rebuildIndex()
+{
+	if (m_rebuildWatcher->isRunning()) {
+		return;
+	}
+
+	//     -    
+	TagIndex::ScanResult result;
+	if (m_storage->entries(result.objects)) {
+		result.roots = m_indexRoots;
+		m_index.adopt(result);
+		m_cooccurrence.rebuild(result.objects);
+		saveIndex();
+		emit indexRebuilt();
+		return;
+	}
+
+	//     ,    
+	qDebug() << "Rebuilding tag index for" << m_indexRoots;
+	const TagSnapshotPtr cached = snapshot();
+	m_rebuildWatcher->setFuture(QtConcurrent::run(&TagIndex::scan, m_indexRoots,
+		TagIndex::TagReader([cached](const QString& path, QSet<QString>& tags) {
+			TagSet ids;
+			if (cached->objectTags(path, ids)) {
+				tags = cached->dictionary().toStrings(ids);
+				return true;
+			}
+			return SidecarTagStorage::loadTagsFromADS(path, tags);
+		})));
+}
+
+bool TagManager::isIndexRebuilding() const
+{
+	return m_rebuildWatcher->isRunning();
+}
+
+void TagManager::onIndexScanFinished()
+{
+	m_index.adopt(m_rebuildWatcher->result());
+
+	// ,    ,    ,
+	//       -   . 
+	//  :         
+	m_objectTags.forEach([this](const QString& path, const TagSet& tags) {
+		m_index.removeExactObject(path);
+		if (!tags.isEmpty()) {
+			m_index.updateObject(path, QSet<QString>(), m_dictionary.toStrings(tags));
+		}
+	});
+	m_cooccurrence.rebuild(m_index.objects().objects);
+
+	saveIndex();
+	emit indexRebuilt();
+}
+
+QStringList TagManager::findObjects(const QString& expression) const
+{
+	PerfTimer timer(PerfStats::TagQuery);
+	return m_index.objectPaths(m_index.query(expression));
+}
+
+void TagManager::scheduleIndexSave()
+{
+	m_indexSaveTimer->start();
+}
+
+void TagManager::saveIndex()
+{
+	m_indexSaveTimer->stop();
+	if (m_index.isDirty()) {
+		m_index.save();
+	}
+	if (m_cooccurrence.isDirty()) {
+		m_cooccurrence.save();
+	}
+}
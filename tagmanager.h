@@ -2,8 +2,25 @@
 
 #include <QObject>
 #include <QSet>
-#include <QMap>
+#include <QHash>
+#include <QStringList>
+#include <QFutureWatcher>
+#include "tagindex.h"
+#include "tagstorage.h"
+#include "tagdatabase.h"
+#include "tagloader.h"
+#include "tagdictionary.h"
+#include "tagsnapshot.h"
+#include "tagcache.h"
+#include "tagrewrite.h"
+#include "tagcooccurrence.h"
 
+class QTimer;
+class QThread;
+
+//  .       (GUI);
+//   ( )   
+// ,      .
 class TagManager : public QObject
 {
 	Q_OBJECT
@@ -19,12 +36,66 @@ public:
 	//    
 	QSet<QString> getObjectTags(const QString& objectPath);
 	bool setObjectTags(const QString& objectPath, const QSet<QString>& tags);
+	bool applyTagChanges(const TagMap& changes);
+	void prefetchDirectory(const QString& dirPath);
+
+	//      
+	bool cachedObjectTags(const QString& objectPath, TagSet& tags) const;
+	int requestObjectTags(const QStringList& objectPaths);
+	void prefetchObjectTags(const QStringList& objectPaths);
 
 	//     
 	QSet<QString> getAllTags() const { return m_allTags; }
+	const TagDictionary& dictionary() const { return m_dictionary; }
 	void addGlobalTag(const QString& tag);
 	bool removeGlobalTag(const QString& tag);
 
+	//     
+	QStringList suggestTags(const QSet<QString>& tags, int count) const
+		{ return m_cooccurrence.suggest(tags, count); }
+
+	// ,        ( )
+	bool renameTag(const QString& oldName, const QString& newName);
+	bool mergeTags(const QStringList& sources, const QString& target);
+	bool deleteTag(const QString& tag);
+	bool resumeTagOperation();
+	bool isTagOperationRunning() const { return m_rewrite.isValid(); }
+
+	//  : sidecar-   
+	bool openDatabase(const QString& dbPath);
+	bool isDatabaseOpen() const { return m_database.isOpen(); }
+	QString storageName() const { return m_storage->name(); }
+	int importSidecars(bool removeSidecars);
+	int exportSidecars();
+
+	// /  (   )
+	void objectMoved(const QString& oldPath, const QString& newPath);
+	void objectRemoved(const QString& objectPath);
+	// :          
+	void objectsMoved(const QVector<QPair<QString, QString>>& moves);
+	void objectsRemoved(const QStringList& objectPaths);
+
+	//  
+	void setIndexRoots(const QStringList& roots);
+	void rebuildIndex();
+	bool isIndexRebuilding() const;
+	const TagIndex& index() const { return m_index; }
+	QStringList findObjects(const QString& expression) const;
+	QVector<quint64> matchObjects(const QString& expression, const QStringList& objectPaths) const
+		{ return m_index.matchMask(expression, objectPaths); }
+
+	//  :  ,   
+	struct SmartFolder
+	{
+		QString name;
+		QString expression;
+	};
+	QVector<SmartFolder> smartFolders() const { return m_smartFolders; }
+	bool addSmartFolder(const QString& name, const QString& expression);
+	bool removeSmartFolder(const QString& name);
+	QStringList smartFolderObjects(const QString& name) const;
+	int smartFolderCount(const QString& name) const;
+
 	// 
 	QString getTagsFilePath() const { return m_tagsFilePath; }
 	void setTagsFilePath(const QString& path) { m_tagsFilePath = path; }
@@ -32,16 +103,69 @@ public:
 signals:
 	void tagsChanged(const QString& objectPath);
 	void globalTagsChanged();
+	void indexRebuilt();
+	void smartFoldersChanged();
+	void objectTagsReady(int requestId);
+	void snapshotPublished(quint64 version);
+	void tagOperationProgress(int done, int total);
+	void tagOperationFinished(int changedObjects, int failedObjects);
 
 private:
 	QString m_tagsFilePath;
 	QSet<QString> m_allTags;
-	QMap<QString, QSet<QString>> m_objectTags;  // objectPath -> tags
+	TagDictionary m_dictionary;                 // tag <-> id
+	TagCache m_objectTags;                      //   -> tag ids
+
+	//   (  std::atomic_load)
+	TagSnapshotPtr m_snapshot;
+	quint64 m_snapshotVersion;
+	bool m_snapshotDirty;
+
+	//   
+	TagStorage *m_storage;
+	SidecarTagStorage m_sidecars;
+	TagDatabase m_database;
+
+	//   -> 
+	TagIndex m_index;
+	QStringList m_indexRoots;
+	TagCooccurrence m_cooccurrence;
+	QVector<SmartFolder> m_smartFolders;
+	QTimer *m_indexSaveTimer;
+	QFutureWatcher<TagIndex::ScanResult> *m_rebuildWatcher;
+
+	//    
+	TagRewrite m_rewrite;
+	QFutureWatcher<TagRewrite::Result> *m_rewriteWatcher;
+	//     :   -> 
+	// ( -  )
+	QVector<QPair<QString, QString>> m_rewriteMoves;
+
+	//   
+	QThread *m_loaderThread;
+	TagLoader *m_loader;
+	int m_lastRequestId;
+	int m_lastPrefetchId;
 
 	bool loadAllTags();
 	bool saveAllTags();
+	bool loadSmartFolders();
+	bool saveSmartFolders();
+	int findSmartFolder(const QString& name) const;
+	void scheduleIndexSave();
+	void cacheLoadedTags(const TagMap& tags);
+	void schedulePublish();
+	TagSnapshotPtr snapshot();
+	QString journalPath() const;
+	bool startTagRewrite(const TagRewrite& rewrite);
+	void finishTagRewrite(const QList<TagRewrite::Result>& results);
+	void rewriteObjectMoved(const QString& oldPath, const QString& newPath);
 
-	//  Windows ADS ( )
-	bool loadTagsFromADS(const QString& filePath, QSet<QString>& tags);
-	bool saveTagsToADS(const QString& filePath, const QSet<QString>& tags);
+private slots:
+	void saveIndex();
+	void onIndexScanFinished();
+	void onTagsLoaded(int requestId, const TagMap& tags);
+	void onTagsPrefetched(const TagMap& tags);
+	void publishSnapshot();
+	void onTagRewriteFinished();
 };
@@ -0,0 +1,63 @@
+#include "tagprefixindex.h"
+#include <algorithm>
+
+void TagPrefixIndex::build(const QSet<QString>& tags)
+{
+	m_entries.clear();
+	m_entries.reserve(tags.size());
+	for (const QString &tag : tags) {
+		m_entries.append({ tag.toCaseFolded(), tag });
+	}
+
+	std::sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+		return a.key < b.key || (a.key == b.key && a.tag < b.tag);
+	});
+}
+
+QPair<int, int> TagPrefixIndex::range(const QString& prefix) const
+{
+	const QString key = prefix.toCaseFolded();
+	if (key.isEmpty()) {
+		return qMakePair(0, m_entries.size());
+	}
+
+	auto first = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), key,
+		[](const Entry &entry, const QString &value) { return entry.key < value; });
+
+	//         first
+	auto last = std::partition_point(first, m_entries.constEnd(),
+		[&key](const Entry &entry) { return entry.key.startsWith(key); });
+
+	return qMakePair(int(first - m_entries.constBegin()), int(last - m_entries.constBegin()));
+}
+
+QString TagPrefixIndex::find(const QString& tag) const
+{
+	const QString key = tag.toCaseFolded();
+	auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), key,
+		[](const Entry &entry, const QString &value) { return entry.key < value; });
+	if (it == m_entries.constEnd() || it->key != key) {
+		return QString();
+	}
+
+	//      
+	for (auto exact = it; exact != m_entries.constEnd() && exact->key == key; ++exact) {
+		if (exact->tag == tag) {
+			return exact->tag;
+		}
+	}
+	return it->tag;
+}
+
+int TagPrefixIndex::indexOf(const QString& tag) const
+{
+	const QString key = tag.toCaseFolded();
+	auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), key,
+		[](const Entry &entry, const QString &value) { return entry.key < value; });
+	for (; it != m_entries.constEnd() && it->key == key; ++it) {
+		if (it->tag == tag) {
+			return int(it - m_entries.constBegin());
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QPair>
+
+//          .
+//       -     ,
+//      .
+class TagPrefixIndex
+{
+public:
+	TagPrefixIndex() {}
+
+	void build(const QSet<QString>& tags);
+	void clear() { m_entries.clear(); }
+
+	int size() const { return m_entries.size(); }
+	const QString& tag(int i) const { return m_entries[i].tag; }
+
+	//  [first, second) ,   prefix
+	QPair<int, int> range(const QString& prefix) const;
+
+	//  ,    ,   
+	QString find(const QString& tag) const;
+
+	//   ( )  -1
+	int indexOf(const QString& tag) const;
+
+private:
+	struct Entry
+	{
+		QString key;	// tag.toCaseFolded()
+		QString tag;
+	};
+
+	QVector<Entry> m_entries;	//  key
+};
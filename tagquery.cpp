@@ -0,0 +1,204 @@
+#include "tagquery.h"
+#include "tagindex.h"
+
+TagQuery::TagQuery(const QString& expression)
+	: m_expression(expression.trimmed())
+{
+	m_tokens = tokenize(m_expression);
+	m_pos = 0;
+
+	if (m_tokens.isEmpty()) {
+		m_error = "Empty expression";
+		return;
+	}
+
+	int root = parseOr();
+	if (root >= 0 && m_pos < m_tokens.size()) {
+		m_error = QString("Unexpected '%1'").arg(m_tokens[m_pos]);
+		root = -1;
+	}
+
+	m_root = m_error.isEmpty() ? root : -1;
+	m_tokens.clear();
+}
+
+QStringList TagQuery::tokenize(const QString& expression)
+{
+	QStringList tokens;
+	QString current;
+
+	auto flush = [&]() {
+		if (!current.isEmpty()) {
+			tokens.append(current);
+			current.clear();
+		}
+	};
+
+	for (QChar ch : expression) {
+		if (ch.isSpace()) {
+			flush();
+		}
+		else if (ch == '(' || ch == ')' || ch == '&' || ch == '|' || ch == '!') {
+			flush();
+			tokens.append(QString(ch));
+		}
+		else {
+			current += ch;
+		}
+	}
+	flush();
+	return tokens;
+}
+
+int TagQuery::addNode(Node::Type type, const QString& tag, int left, int right)
+{
+	Node node;
+	node.type = type;
+	node.tag = tag;
+	node.left = left;
+	node.right = right;
+	m_nodes.append(node);
+	return m_nodes.size() - 1;
+}
+
+// or := and { (OR | '|') and }
+int TagQuery::parseOr()
+{
+	int left = parseAnd();
+	while (left >= 0 && m_pos < m_tokens.size()
+		&& (m_tokens[m_pos] == "OR" || m_tokens[m_pos] == "|")) {
+		++m_pos;
+		int right = parseAnd();
+		if (right < 0) return -1;
+		left = addNode(Node::Or, QString(), left, right);
+	}
+	return left;
+}
+
+// and := unary { [AND | '&'] unary }
+int TagQuery::parseAnd()
+{
+	int left = parseUnary();
+	while (left >= 0 && m_pos < m_tokens.size()) {
+		const QString &token = m_tokens[m_pos];
+		if (token == "OR" || token == "|" || token == ")")
+			break;
+		if (token == "AND" || token == "&")
+			++m_pos;
+
+		int right = parseUnary();
+		if (right < 0) return -1;
+		left = addNode(Node::And, QString(), left, right);
+	}
+	return left;
+}
+
+// unary := (NOT | '!') unary | '(' or ')' | tag
+int TagQuery::parseUnary()
+{
+	if (m_pos >= m_tokens.size()) {
+		m_error = "Unexpected end of expression";
+		return -1;
+	}
+
+	const QString token = m_tokens[m_pos++];
+
+	if (token == "NOT" || token == "!") {
+		int child = parseUnary();
+		if (child < 0) return -1;
+		return addNode(Node::Not, QString(), child);
+	}
+
+	if (token == "(") {
+		int inner = parseOr();
+		if (inner < 0) return -1;
+		if (m_pos >= m_tokens.size() || m_tokens[m_pos] != ")") {
+			m_error = "Missing ')'";
+			return -1;
+		}
+		++m_pos;
+		return inner;
+	}
+
+	if (token == ")" || token == "AND" || token == "OR" || token == "&" || token == "|") {
+		m_error = QString("Unexpected '%1'").arg(token);
+		return -1;
+	}
+
+	return addNode(Node::Tag, token);
+}
+
+QSet<QString> TagQuery::tags() const
+{
+	QSet<QString> result;
+	for (const Node &node : m_nodes) {
+		if (node.type == Node::Tag) {
+			result.insert(node.tag);
+		}
+	}
+	return result;
+}
+
+bool TagQuery::matches(const QSet<QString>& objectTags) const
+{
+	if (!isValid()) return false;
+	return matchesNode(m_root, objectTags);
+}
+
+bool TagQuery::matchesNode(int index, const QSet<QString>& objectTags) const
+{
+	const Node &node = m_nodes[index];
+	switch (node.type) {
+	case Node::Tag:
+		return matchesTag(node.tag, objectTags);
+	case Node::And:
+		return matchesNode(node.left, objectTags) && matchesNode(node.right, objectTags);
+	case Node::Or:
+		return matchesNode(node.left, objectTags) || matchesNode(node.right, objectTags);
+	case Node::Not:
+		return !matchesNode(node.left, objectTags);
+	}
+	return false;
+}
+
+bool TagQuery::matchesTag(const QString& tag, const QSet<QString>& objectTags)
+{
+	if (objectTags.contains(tag)) {
+		return true;
+	}
+
+	//      
+	const QString prefix = tag + '/';
+	for (const QString &objectTag : objectTags) {
+		if (objectTag.startsWith(prefix)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+TagBitmap TagQuery::evaluate(const TagIndex& index) const
+{
+	if (!isValid()) return TagBitmap();
+	return evaluateNode(m_root, index);
+}
+
+TagBitmap TagQuery::evaluateNode(int i, const TagIndex& index) const
+{
+	const Node &node = m_nodes[i];
+	switch (node.type) {
+	case Node::Tag:
+		return index.objectsWithTagTree(node.tag);
+	case Node::And:
+		// NOT    ,   
+		if (m_nodes[node.right].type == Node::Not) {
+			return evaluateNode(node.left, index) - evaluateNode(m_nodes[node.right].left, index);
+		}
+		return evaluateNode(node.left, index) & evaluateNode(node.right, index);
+	case Node::Or:
+		return evaluateNode(node.left, index) | evaluateNode(node.right, index);
+	case Node::Not:
+		return index.allObjects() - evaluateNode(node.left, index);
+	}
+	return TagBitmap();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QVector>
+#include "tagbitmap.h"
+
+class TagIndex;
+
+//    : "todo AND NOT reviewed", "a | (b & !c)".
+//       AND.
+//  "place/europe"      ("place/europe/rome").
+class TagQuery
+{
+public:
+	TagQuery() {}
+	explicit TagQuery(const QString& expression);
+
+	bool isValid() const { return m_root >= 0; }
+	QString expression() const { return m_expression; }
+	QString errorString() const { return m_error; }
+
+	// ,   
+	QSet<QString> tags() const;
+
+	//       
+	bool matches(const QSet<QString>& objectTags) const;
+
+	//    
+	TagBitmap evaluate(const TagIndex& index) const;
+
+private:
+	struct Node
+	{
+		enum Type { Tag, And, Or, Not };
+		Type type;
+		QString tag;
+		int left;
+		int right;
+	};
+
+	QString m_expression;
+	QString m_error;
+	QVector<Node> m_nodes;
+	int m_root = -1;
+
+	//  
+	QStringList m_tokens;
+	int m_pos = 0;
+
+	static QStringList tokenize(const QString& expression);
+	int parseOr();
+	int parseAnd();
+	int parseUnary();
+	int addNode(Node::Type type, const QString& tag, int left = -1, int right = -1);
+
+	bool matchesNode(int node, const QSet<QString>& objectTags) const;
+	static bool matchesTag(const QString& tag, const QSet<QString>& objectTags);
+	TagBitmap evaluateNode(int node, const TagIndex& index) const;
+};
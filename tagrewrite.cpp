@@ -0,0 +1,127 @@
+#include "tagrewrite.h"
+#include "tagstorage.h"
+#include "tagindex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+
+static const quint32 JOURNAL_MAGIC = 0x4D42544A;	// "MBTJ"
+static const quint32 JOURNAL_VERSION = 1;
+
+TagRewrite::TagRewrite(const QStringList& sources, const QString& target)
+	: m_target(target.trimmed())
+{
+	for (const QString &source : sources) {
+		const QString tag = source.trimmed();
+		if (!tag.isEmpty() && tag != m_target && !m_sources.contains(tag)) {
+			m_sources.append(tag);
+		}
+	}
+}
+
+QSet<QString> TagRewrite::apply(const QSet<QString>& tags) const
+{
+	QSet<QString> result = tags;
+	bool found = false;
+	for (const QString &source : m_sources) {
+		found |= result.remove(source);
+	}
+	if (found && !m_target.isEmpty()) {
+		result.insert(m_target);
+	}
+	return result;
+}
+
+QString TagRewrite::relocatedPath(const QString& objectPath, const QString& oldPath, const QString& newPath)
+{
+	const QString path = TagIndex::normalizePath(objectPath);
+	const QString from = TagIndex::normalizePath(oldPath);
+	if (path != from && !path.startsWith(from + '/')) {
+		return objectPath;
+	}
+	return newPath.isEmpty() ? QString() : TagIndex::normalizePath(newPath) + path.mid(from.size());
+}
+
+bool TagRewrite::relocateObjects(const QString& oldPath, const QString& newPath)
+{
+	bool changed = false;
+	QStringList paths;
+	paths.reserve(m_objectPaths.size());
+	for (const QString &path : m_objectPaths) {
+		const QString relocated = relocatedPath(path, oldPath, newPath);
+		changed |= relocated != path;
+		if (!relocated.isEmpty()) {
+			paths.append(relocated);
+		}
+	}
+	if (changed) {
+		m_objectPaths = paths;
+	}
+	return changed;
+}
+
+TagRewrite::Result TagRewrite::rewriteObject(TagStorage *storage, const QString& objectPath) const
+{
+	Result result;
+	result.path = objectPath;
+
+	storage->load(objectPath, result.oldTags);
+	result.newTags = apply(result.oldTags);
+
+	//   (  )    
+	if (result.newTags == result.oldTags) {
+		return result;
+	}
+
+	result.changed = true;
+	result.ok = storage->save(objectPath, result.newTags);
+	if (!result.ok) {
+		qDebug() << "Cannot rewrite tags of" << objectPath;
+	}
+	return result;
+}
+
+bool TagRewrite::saveJournal(const QString& journalPath) const
+{
+	QSaveFile file(journalPath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot write tag journal:" << journalPath << file.errorString();
+		return false;
+	}
+
+	QDataStream out(&file);
+	out << JOURNAL_MAGIC << JOURNAL_VERSION;
+	out << m_storageName << m_sources << m_target << m_objectPaths;
+
+	if (!file.commit()) {
+		qDebug() << "Cannot commit tag journal:" << journalPath << file.errorString();
+		return false;
+	}
+	return true;
+}
+
+bool TagRewrite::loadJournal(const QString& journalPath)
+{
+	QFile file(journalPath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	QDataStream in(&file);
+	quint32 magic = 0;
+	quint32 version = 0;
+	in >> magic >> version;
+	if (magic != JOURNAL_MAGIC || version != JOURNAL_VERSION) {
+		qDebug() << "Unknown tag journal format:" << journalPath;
+		return false;
+	}
+
+	in >> m_storageName >> m_sources >> m_target >> m_objectPaths;
+	if (in.status() != QDataStream::Ok) {
+		qDebug() << "Corrupted tag journal:" << journalPath;
+		m_sources.clear();
+		return false;
+	}
+	return isValid();
+}
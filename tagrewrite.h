@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+
+class TagStorage;
+
+//   : , , .
+//          ;
+//   ,     
+//    .
+class TagRewrite
+{
+public:
+	//    
+	struct Result
+	{
+		QString path;
+		QSet<QString> oldTags;
+		QSet<QString> newTags;
+		bool changed = false;
+		bool ok = true;
+	};
+
+	TagRewrite() {}
+	TagRewrite(const QStringList& sources, const QString& target);
+
+	bool isValid() const { return !m_sources.isEmpty(); }
+	bool isDelete() const { return m_target.isEmpty(); }
+
+	QStringList sources() const { return m_sources; }
+	QString target() const { return m_target; }
+
+	QStringList objectPaths() const { return m_objectPaths; }
+	void setObjectPaths(const QStringList& paths) { m_objectPaths = paths; }
+
+	//  (   ) ;  newPath - .
+	//  true,    
+	bool relocateObjects(const QString& oldPath, const QString& newPath);
+	//    ;  -  
+	static QString relocatedPath(const QString& objectPath, const QString& oldPath, const QString& newPath);
+
+	QString storageName() const { return m_storageName; }
+	void setStorageName(const QString& name) { m_storageName = name; }
+
+	//    
+	QSet<QString> apply(const QSet<QString>& tags) const;
+
+	// ,       (,
+	//   )
+	Result rewriteObject(TagStorage *storage, const QString& objectPath) const;
+
+	//   
+	bool saveJournal(const QString& journalPath) const;
+	bool loadJournal(const QString& journalPath);
+
+private:
+	QStringList m_sources;
+	QString m_target;		//  - 
+	QStringList m_objectPaths;
+	QString m_storageName;
+};
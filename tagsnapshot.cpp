@@ -0,0 +1,33 @@
+#include "tagsnapshot.h"
+
+TagSnapshot::TagSnapshot(const TagDictionary& dictionary, const TagCache& objectTags, quint64 version)
+	: m_dictionary(dictionary)
+	, m_objectTags(objectTags)
+	, m_version(version)
+{
+}
+
+bool TagSnapshot::objectTags(const QString& objectPath, TagSet& tags) const
+{
+	return m_objectTags.value(objectPath, tags);
+}
+
+QSet<QString> TagSnapshot::objectTags(const QString& objectPath) const
+{
+	TagSet tags;
+	if (!objectTags(objectPath, tags)) {
+		return QSet<QString>();
+	}
+	return m_dictionary.toStrings(tags);
+}
+
+bool TagSnapshot::hasTag(const QString& objectPath, const QString& tag) const
+{
+	const int id = m_dictionary.id(tag);
+	if (id < 0) {
+		return false;
+	}
+
+	TagSet tags;
+	return objectTags(objectPath, tags) && tags.contains(quint32(id));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <QSet>
+#include <QString>
+#include "tagdictionary.h"
+#include "tagcache.h"
+
+//    .  TagManager 
+//  ;      . 
+//        (. TagCache), 
+//    ,    writer 
+//     .
+class TagSnapshot
+{
+public:
+	TagSnapshot() : m_version(0) {}
+	TagSnapshot(const TagDictionary& dictionary, const TagCache& objectTags, quint64 version);
+
+	quint64 version() const { return m_version; }
+	const TagDictionary& dictionary() const { return m_dictionary; }
+	int objectCount() const { return m_objectTags.size(); }
+
+	// false -     (   )
+	bool contains(const QString& objectPath) const { return m_objectTags.contains(objectPath); }
+	bool objectTags(const QString& objectPath, TagSet& tags) const;
+	QSet<QString> objectTags(const QString& objectPath) const;
+	bool hasTag(const QString& objectPath, const QString& tag) const;
+
+private:
+	TagDictionary m_dictionary;
+	TagCache m_objectTags;
+	quint64 m_version;
+};
+
+typedef std::shared_ptr<const TagSnapshot> TagSnapshotPtr;
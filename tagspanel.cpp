@@ -1,23 +1,29 @@
 #include "tagspanel.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QScrollArea>
-#include <QCheckBox>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QLabel>
 #include <QDebug>
 #include <QTimer>
+#include <QCompleter>
+#include <QStringListModel>
+#include <QAbstractItemView>
 #include <algorithm>
 
 TagsPanel::TagsPanel(QWidget *parent)
 	: QDockWidget(parent)
 	, m_titleLabel(nullptr)
-	, m_scrollArea(nullptr)
-	, m_tagsContainer(nullptr)
+	, m_filterEdit(nullptr)
+	, m_tagView(nullptr)
+	, m_suggestLabel(nullptr)
+	, m_suggestView(nullptr)
 	, m_newTagEdit(nullptr)
 	, m_addButton(nullptr)
+	, m_completer(nullptr)
+	, m_completerModel(nullptr)
 	, m_needsRefresh(false)
+	, m_loading(false)
 {
 	setAllowedAreas(Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea);
 
@@ -33,15 +39,24 @@ TagsPanel::TagsPanel(QWidget *parent)
 	m_titleLabel->setMinimumHeight(30); //  
 	mainLayout->addWidget(m_titleLabel);
 
-	//     
-	m_scrollArea = new QScrollArea();
-	m_scrollArea->setWidgetResizable(true);
-	m_scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-	m_scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-
-	m_tagsContainer = new QWidget();
-	m_scrollArea->setWidget(m_tagsContainer);
-	mainLayout->addWidget(m_scrollArea, 1); // 
+	//     
+	m_filterEdit = new QLineEdit();
+	m_filterEdit->setPlaceholderText("Filter tags...");
+	m_filterEdit->setClearButtonEnabled(true);
+	mainLayout->addWidget(m_filterEdit);
+
+	//      (  ,  )
+	m_tagView = new TagFlowView();
+	mainLayout->addWidget(m_tagView, 1); // 
+
+	//     (,   )
+	m_suggestLabel = new QLabel("Suggested:");
+	m_suggestLabel->setVisible(false);
+	mainLayout->addWidget(m_suggestLabel);
+	m_suggestView = new TagFlowView();
+	m_suggestView->setMaximumHeight(60);
+	m_suggestView->setVisible(false);
+	mainLayout->addWidget(m_suggestView);
 
 	//    
 	QHBoxLayout *addLayout = new QHBoxLayout();
@@ -50,6 +65,13 @@ TagsPanel::TagsPanel(QWidget *parent)
 	m_addButton = new QPushButton("Add");
 	m_addButton->setFixedWidth(60);
 
+	// :   ,   
+	m_completerModel = new QStringListModel(this);
+	m_completer = new QCompleter(m_completerModel, this);
+	m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+	m_completer->setCaseSensitivity(Qt::CaseInsensitive);
+	m_newTagEdit->setCompleter(m_completer);
+
 	addLayout->addWidget(m_newTagEdit);
 	addLayout->addWidget(m_addButton);
 
@@ -68,24 +90,89 @@ TagsPanel::TagsPanel(QWidget *parent)
 		this, &TagsPanel::onAddTagClicked);
 	connect(m_newTagEdit, &QLineEdit::returnPressed,
 		this, &TagsPanel::onAddTagClicked);
+	connect(m_tagView, &TagFlowView::tagToggled,
+		this, &TagsPanel::onTagToggled);
+	connect(m_tagView, &TagFlowView::expandToggled,
+		this, &TagsPanel::onExpandToggled);
+	connect(m_suggestView, &TagFlowView::tagToggled,
+		this, &TagsPanel::onSuggestionClicked);
+	connect(m_filterEdit, &QLineEdit::textChanged,
+		this, &TagsPanel::onFilterChanged);
+	connect(m_newTagEdit, &QLineEdit::textEdited,
+		this, &TagsPanel::onNewTagEdited);
 }
 
 TagsPanel::~TagsPanel()
 {
 }
 
-void TagsPanel::setObjectTags(const QSet<QString>& objectTags)
+void TagsPanel::setObjectTags(const QSet<QString>& objectTags, const QSet<QString>& partialTags)
 {
 	m_objectTags = objectTags;
+	m_partialTags = partialTags;
 	m_needsRefresh = true;
 
 	//      
 	QTimer::singleShot(0, this, &TagsPanel::refreshTags);
 }
 
+void TagsPanel::setLoading(bool loading)
+{
+	if (m_loading == loading)
+		return;
+	m_loading = loading;
+
+	//    ,    
+	m_tagView->setEnabled(!loading);
+	updateTitle();
+}
+
+void TagsPanel::setSuggestedTags(const QStringList& tags)
+{
+	QVector<TagFlowView::Item> items;
+	items.reserve(tags.size());
+	for (const QString &tag : tags) {
+		items.append({ tag, Qt::Unchecked });
+	}
+	m_suggestView->setItems(items);
+	m_suggestLabel->setVisible(!items.isEmpty());
+	m_suggestView->setVisible(!items.isEmpty());
+}
+
 void TagsPanel::setAllTags(const QSet<QString>& allTags)
 {
+	//    (  ) -   
+	if (allTags == m_allTags && m_prefixIndex.size() == m_allTags.size()) {
+		return;
+	}
+
 	m_allTags = allTags;
+	m_prefixIndex.build(m_allTags);
+
+	//   "a/b/c":      -
+	//   ,   
+	m_treeTags.clear();
+	bool hierarchical = false;
+	for (const QString &tag : m_allTags) {
+		if (tag.contains('/')) {
+			hierarchical = true;
+			break;
+		}
+	}
+	if (hierarchical) {
+		QVector<QPair<QString, QString>> keyed;
+		keyed.reserve(m_allTags.size());
+		for (const QString &tag : m_allTags) {
+			QString key = tag;
+			key.replace('/', QChar(1));
+			keyed.append(qMakePair(key, tag));
+		}
+		std::sort(keyed.begin(), keyed.end());
+		m_treeTags.reserve(keyed.size());
+		for (const auto &entry : keyed) {
+			m_treeTags.append(entry.second);
+		}
+	}
 	m_needsRefresh = true;
 
 	//      
@@ -101,57 +188,136 @@ void TagsPanel::refreshTags()
 	qDebug() << "TagsPanel::refreshTags - object tags:" << m_objectTags.size()
 		<< "all tags:" << m_allTags.size();
 
-	//   
-	for (QCheckBox *checkbox : m_tagCheckboxes) {
-		if (checkbox) {
-			checkbox->blockSignals(true);
-			delete checkbox;
+	//  ( ),   
+	QStringList checkedTagsSorted;
+	for (const QString &tag : m_objectTags) {
+		if (tag.startsWith(m_filter, Qt::CaseInsensitive)) {
+			checkedTagsSorted.append(tag);
+		}
+	}
+	for (const QString &tag : m_partialTags) {
+		if (tag.startsWith(m_filter, Qt::CaseInsensitive) && !m_objectTags.contains(tag)) {
+			checkedTagsSorted.append(tag);
 		}
 	}
-	m_tagCheckboxes.clear();
+	std::sort(checkedTagsSorted.begin(), checkedTagsSorted.end(),
+		[](const QString &a, const QString &b) {
+		return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+	});
 
-	if (!m_tagsContainer) {
+	if (m_filter.isEmpty() && !m_treeTags.isEmpty()) {
+		//     :  
+		// ( ),    
+		QVector<TagFlowView::Item> items;
+		for (const QString &tag : checkedTagsSorted) {
+			items.append({ tag, m_objectTags.contains(tag) ? Qt::Checked : Qt::PartiallyChecked });
+		}
+		const int firstOther = items.size();
+		appendTree(items);
+		if (firstOther > 0 && firstOther < items.size()) {
+			items[firstOther].groupStart = true;
+		}
+		m_tagView->setItems(items);
+		updateTitle();
 		return;
 	}
 
-	//   :   +   
-	QSet<QString> allTagsToShow = m_allTags.unite(m_objectTags);
+	//  -   ,   .
+	//   :   ,   
+	//  ( ),        
+	m_shownChecked = checkedTagsSorted;
+	m_shownIndex = m_prefixIndex;
+	m_shownRange = m_shownIndex.range(m_filter);
+	m_shownSkipped.clear();
+	for (const QString &tag : m_shownChecked) {
+		const int position = m_shownIndex.indexOf(tag);
+		if (position >= m_shownRange.first && position < m_shownRange.second) {
+			m_shownSkipped.append(position);
+		}
+	}
+	std::sort(m_shownSkipped.begin(), m_shownSkipped.end());
 
-	if (allTagsToShow.isEmpty()) {
-		m_tagsContainer->setMinimumHeight(0);
-		return;
+	const int count = m_shownChecked.size()
+		+ m_shownRange.second - m_shownRange.first - m_shownSkipped.size();
+	m_tagView->setItems(count, [this](int index) { return flatItem(index); });
+	updateTitle();
+}
+
+TagFlowView::Item TagsPanel::flatItem(int index) const
+{
+	const int checkedCount = m_shownChecked.size();
+	if (index < checkedCount) {
+		const QString &tag = m_shownChecked[index];
+		return { tag, m_objectTags.contains(tag) ? Qt::Checked : Qt::PartiallyChecked };
 	}
 
-	//    ( )  
-	QSet<QString> checkedTags = m_objectTags;
-	QSet<QString> uncheckedTags = allTagsToShow.subtract(m_objectTags);
+	//   :  ,    
+	int position = m_shownRange.first + index - checkedCount;
+	for (int skipped : m_shownSkipped) {
+		if (skipped > position) break;
+		++position;
+	}
 
-	//     
-	QStringList checkedTagsSorted = checkedTags.values();
-	QStringList uncheckedTagsSorted = uncheckedTags.values();
+	TagFlowView::Item item = { m_shownIndex.tag(position), Qt::Unchecked };
+	item.groupStart = index == checkedCount && checkedCount > 0;
+	return item;
+}
 
-	std::sort(checkedTagsSorted.begin(), checkedTagsSorted.end(),
-		[](const QString &a, const QString &b) {
-		return a.toLower() < b.toLower();
-	});
+void TagsPanel::appendTree(QVector<TagFlowView::Item>& items) const
+{
+	QStringList chain;	//     
 
-	std::sort(uncheckedTagsSorted.begin(), uncheckedTagsSorted.end(),
-		[](const QString &a, const QString &b) {
-		return a.toLower() < b.toLower();
-	});
+	for (int i = 0; i < m_treeTags.size(); ++i) {
+		const QString &tag = m_treeTags[i];
+		const QStringList segments = tag.split('/');
 
-	//     
-	for (const QString &tag : checkedTagsSorted) {
-		createTagCheckbox(tag, true);
-	}
+		QString path;
+		for (int depth = 0; depth < segments.size(); ++depth) {
+			path = depth == 0 ? segments[0] : path + '/' + segments[depth];
 
-	for (const QString &tag : uncheckedTagsSorted) {
-		createTagCheckbox(tag, false);
+			//    (     )
+			if (depth < chain.size() && chain[depth] == path) {
+				continue;
+			}
+			chain.erase(chain.begin() + qMin(depth, chain.size()), chain.end());
+			chain.append(path);
+
+			//     
+			bool visible = true;
+			for (int k = 0; k < depth && visible; ++k) {
+				visible = m_expandedTags.contains(chain[k]);
+			}
+			if (!visible) {
+				continue;
+			}
+
+			//        ;
+			//       
+			const bool isLast = depth == segments.size() - 1;
+			const bool hasChildren = !isLast
+				|| (i + 1 < m_treeTags.size() && m_treeTags[i + 1].startsWith(path + '/'));
+
+			TagFlowView::Item item;
+			item.tag = path;
+			item.label = segments[depth];
+			item.depth = depth;
+			item.state = m_objectTags.contains(path) ? Qt::Checked
+				: m_partialTags.contains(path) ? Qt::PartiallyChecked : Qt::Unchecked;
+			item.hasChildren = hasChildren;
+			item.expanded = m_expandedTags.contains(path);
+			item.checkable = isLast;
+			items.append(item);
+		}
 	}
+}
 
-	//  
-	rearrangeTags();
-	updateTitle();
+void TagsPanel::onExpandToggled(const QString& tag)
+{
+	if (!m_expandedTags.remove(tag)) {
+		m_expandedTags.insert(tag);
+	}
+	m_needsRefresh = true;
+	refreshTags();
 }
 
 void TagsPanel::setObjectName(const QString& name)
@@ -162,13 +328,7 @@ void TagsPanel::setObjectName(const QString& name)
 
 QSet<QString> TagsPanel::getSelectedTags() const
 {
-	QSet<QString> selected;
-	for (auto it = m_tagCheckboxes.constBegin(); it != m_tagCheckboxes.constEnd(); ++it) {
-		if (it.value()->isChecked()) {
-			selected.insert(it.key());
-		}
-	}
-	return selected;
+	return m_objectTags;
 }
 
 QString TagsPanel::getNewTagText() const
@@ -181,218 +341,12 @@ void TagsPanel::clearInput()
 	m_newTagEdit->clear();
 }
 
-void TagsPanel::createTagCheckbox(const QString& tag, bool checked)
-{
-	if (m_tagCheckboxes.contains(tag)) {
-		return; //  
-	}
-
-	QCheckBox *checkbox = new QCheckBox(tag, m_tagsContainer);
-	checkbox->setChecked(checked);
-	checkbox->setVisible(true);
-	//      
-	QString backgroundColor = checked ? "#e3f2fd" : "#f5f5f5";
-	QString borderColor = checked ? "#bbdefb" : "#e0e0e0";
-	QString hoverColor = checked ? "#bbdefb" : "#eeeeee";
-
-	checkbox->setStyleSheet(QString(
-		"QCheckBox {"
-		"    padding: 4px 8px;"
-		"    margin: 2px;"
-		"    border-radius: 4px;"
-		"    background-color: %1;"
-		"    border: 1px solid %2;"
-		"}"
-		"QCheckBox:hover {"
-		"    background-color: %3;"
-		"}"
-		"QCheckBox::indicator {"
-		"    width: 16px;"
-		"    height: 16px;"
-		"}"
-	).arg(backgroundColor, borderColor, hoverColor));
-
-	connect(checkbox, &QCheckBox::toggled,
-		this, &TagsPanel::onTagCheckboxToggled);
-
-	m_tagCheckboxes[tag] = checkbox;
-}
-
-void TagsPanel::createTagCheckboxes()
-{
-	//   
-	for (QCheckBox *checkbox : m_tagCheckboxes) {
-		disconnect(checkbox, &QCheckBox::toggled,
-			this, &TagsPanel::onTagCheckboxToggled);
-		delete checkbox;
-	}
-	m_tagCheckboxes.clear();
-
-	//   :     
-	QStringList assignedTags = m_objectTags.values();
-	QStringList otherTags = m_allTags.subtract(m_objectTags).values();
-
-	//    ()
-	std::sort(assignedTags.begin(), assignedTags.end(),
-		[](const QString &a, const QString &b) {
-		return a.toLower() < b.toLower();
-	});
-
-	std::sort(otherTags.begin(), otherTags.end(),
-		[](const QString &a, const QString &b) {
-		return a.toLower() < b.toLower();
-	});
-
-	//    
-	for (const QString &tag : assignedTags) {
-		QCheckBox *checkbox = new QCheckBox(tag, m_tagsContainer);
-		checkbox->setVisible(true);
-		checkbox->setChecked(true);
-
-		//    
-		checkbox->setStyleSheet(
-			"QCheckBox {"
-			"    padding: 4px 8px;"
-			"    margin: 2px;"
-			"    border-radius: 4px;"
-			"    background-color: #ffff9b;"  // -
-			"    border: 1px solid #bbdefb;"
-			"}"
-			"QCheckBox:hover {"
-			"    background-color: #ffff00;"  //   
-			"}"
-			"QCheckBox::indicator {"
-			"    width: 16px;"
-			"    height: 16px;"
-			"}"
-		);
-
-		connect(checkbox, &QCheckBox::toggled,
-			this, &TagsPanel::onTagCheckboxToggled);
-		m_tagCheckboxes[tag] = checkbox;
-	}
-
-	//    
-	for (const QString &tag : otherTags) {
-		QCheckBox *checkbox = new QCheckBox(tag, m_tagsContainer);
-		checkbox->setVisible(true);
-		checkbox->setChecked(false);
-
-		//     
-		checkbox->setStyleSheet(
-			"QCheckBox {"
-			"    padding: 4px 8px;"
-			"    margin: 2px;"
-			"    border-radius: 4px;"
-			"    background-color: #f5f5f5;"  // -
-			"    border: 1px solid #e0e0e0;"
-			"}"
-			"QCheckBox:hover {"
-			"    background-color: #eeeeee;"  //   
-			"}"
-			"QCheckBox::indicator {"
-			"    width: 16px;"
-			"    height: 16px;"
-			"}"
-		);
-
-		connect(checkbox, &QCheckBox::toggled,
-			this, &TagsPanel::onTagCheckboxToggled);
-		m_tagCheckboxes[tag] = checkbox;
-	}
-
-	//  
-	rearrangeTags();
-}
-
-//      
-void TagsPanel::rearrangeTags()
-{
-	if (m_tagCheckboxes.isEmpty() || !m_tagsContainer)
-		return;
-	
-
-	//    ( )
-	int containerWidth = m_tagsContainer->width();
-	if (containerWidth <= 0)
-		return;
-
-	int availableWidth = containerWidth - 20; // 10px    
-	int currentX = 10;  //    
-	int currentY = 10;  //    
-	int rowHeight = 0;
-	int hSpacing = 4;   //    
-	int vSpacing = 4;   //    
-
-	//      
-	QMap<QString, QCheckBox*> checkedBoxes;
-	QMap<QString, QCheckBox*> uncheckedBoxes;
-
-	for (auto it = m_tagCheckboxes.constBegin(); it != m_tagCheckboxes.constEnd(); ++it) {
-		if (!it.value()) continue;
-
-		if (it.value()->isChecked()) {
-			checkedBoxes[it.key()] = it.value();
-		}
-		else {
-			uncheckedBoxes[it.key()] = it.value();
-		}
-	}	
-
-	//     
-	auto layoutGroup = [&](QMap<QString, QCheckBox*>& group) {
-		for (auto it = group.constBegin(); it != group.constEnd(); ++it) {
-			QCheckBox* checkbox = it.value();
-			if (!checkbox) continue;
-
-			checkbox->adjustSize();
-			QSize size = checkbox->sizeHint();
-
-			//    
-			if (size.width() > availableWidth - 20) {
-				size.setWidth(availableWidth - 20);
-				checkbox->setFixedWidth(size.width());
-			}
-
-			//       
-			if (currentX + size.width() > availableWidth && currentX > 10) {
-				currentX = 10;
-				currentY += rowHeight + vSpacing;
-				rowHeight = 0;
-			}
-
-			checkbox->setGeometry(QRect(currentX, currentY, size.width(), size.height()));
-			currentX += size.width() + hSpacing;
-			rowHeight = qMax(rowHeight, size.height());
-		}
-	};
-
-	//    
-	layoutGroup(checkedBoxes);
-
-	//    
-	if (!checkedBoxes.isEmpty() && !uncheckedBoxes.isEmpty()) {
-		currentX = 10;
-		currentY += rowHeight + vSpacing * 2;
-		rowHeight = 0;
-	}
-
-	//    
-	layoutGroup(uncheckedBoxes);
-
-	//   
-	int totalHeight = currentY + rowHeight + 10;
-	m_tagsContainer->setMinimumHeight(totalHeight);
-}
-
 //   
 void TagsPanel::resizeEvent(QResizeEvent *event)
 {
 	QDockWidget::resizeEvent(event);
 	
 	QTimer::singleShot(0, this, &TagsPanel::updateTitle);
-	
-	QTimer::singleShot(0, this, &TagsPanel::rearrangeTags);
 }
 
 void TagsPanel::updateTitle()
@@ -444,6 +398,10 @@ void TagsPanel::updateTitle()
 		title += ": No object selected";
 	}	
 
+	if (m_loading) {
+		title += " (loading tags...)";
+	}
+
 	//    
 	m_titleLabel->setText(title);
 	m_titleLabel->setStyleSheet(styleSheet);
@@ -465,9 +423,13 @@ void TagsPanel::onAddTagClicked()
 		return;
 	}
 
-	// ,     
-	if (m_allTags.contains(newTag) || m_objectTags.contains(newTag)) {
+	//     (   ) -   
+	QString existing = m_objectTags.contains(newTag) ? newTag : m_prefixIndex.find(newTag);
+	if (!existing.isEmpty()) {
 		m_newTagEdit->clear();
+		if (!m_objectTags.contains(existing)) {
+			onTagToggled(existing, true);
+		}
 		return;
 	}
 
@@ -475,15 +437,25 @@ void TagsPanel::onAddTagClicked()
 	m_newTagEdit->clear();
 }
 
-void TagsPanel::onTagCheckboxToggled(bool checked)
+void TagsPanel::onSuggestionClicked(const QString& tag)
 {
-	QCheckBox *checkbox = qobject_cast<QCheckBox*>(sender());
-	if (!checkbox) return;
+	//   ,      
+	QVector<TagFlowView::Item> items = m_suggestView->items();
+	for (int i = 0; i < items.size(); ++i) {
+		if (items[i].tag == tag) {
+			items.remove(i);
+			break;
+		}
+	}
+	m_suggestView->setItems(items);
 
-	QString tag = checkbox->text();
-//	emit tagToggled(tag, checked);
+	onTagToggled(tag, true);
+}
 
-	//   
+void TagsPanel::onTagToggled(const QString& tag, bool checked)
+{
+	//    (     )
+	m_partialTags.remove(tag);
 	if (checked) {
 		m_objectTags.insert(tag);
 	}
@@ -491,34 +463,59 @@ void TagsPanel::onTagCheckboxToggled(bool checked)
 		m_objectTags.remove(tag);
 	}
 
-	//  
-	QString backgroundColor = checked ? "#e3f2fd" : "#f5f5f5";
-	QString borderColor = checked ? "#bbdefb" : "#e0e0e0";
-	QString hoverColor = checked ? "#bbdefb" : "#eeeeee";
-
-	checkbox->setStyleSheet(QString(
-		"QCheckBox {"
-		"    padding: 4px 8px;"
-		"    margin: 2px;"
-		"    border-radius: 4px;"
-		"    background-color: %1;"
-		"    border: 1px solid %2;"
-		"}"
-		"QCheckBox:hover {"
-		"    background-color: %3;"
-		"}"
-		"QCheckBox::indicator {"
-		"    width: 16px;"
-		"    height: 16px;"
-		"}"
-	).arg(backgroundColor, borderColor, hoverColor));
-
 	//  
 	emit tagToggled(tag, checked);
 	emit tagsChanged(getSelectedTags());
 
-	updateTitle();
+	//   :   ,   
+	m_needsRefresh = true;
+	refreshTags();
+}
+
+void TagsPanel::onFilterChanged(const QString& text)
+{
+	m_filter = text.trimmed();
+	m_needsRefresh = true;
+	refreshTags();
+}
+
+void TagsPanel::onNewTagEdited(const QString& text)
+{
+	static const int MAX_COMPLETIONS = 20;
+
+	const QString prefix = text.trimmed();
+	const QPair<int, int> range = m_prefixIndex.range(prefix);
+	if (prefix.isEmpty() || range.first == range.second) {
+		m_completerModel->setStringList(QStringList());
+		m_completer->popup()->hide();
+		return;
+	}
+
+	//     ( )
+	QVector<QPair<int, int>> candidates;	// (,   )
+	candidates.reserve(range.second - range.first);
+	for (int i = range.first; i < range.second; ++i) {
+		candidates.append(qMakePair(m_usage ? m_usage(m_prefixIndex.tag(i)) : 0, i));
+	}
+
+	const int count = qMin(MAX_COMPLETIONS, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+		[](const QPair<int, int> &a, const QPair<int, int> &b) {
+		return a.first > b.first || (a.first == b.first && a.second < b.second);
+	});
+
+	QStringList completions;
+	for (int i = 0; i < count; ++i) {
+		completions.append(m_prefixIndex.tag(candidates[i].second));
+	}
+
+	//      -  
+	if (completions.size() == 1 && completions.first() == prefix) {
+		m_completerModel->setStringList(QStringList());
+		m_completer->popup()->hide();
+		return;
+	}
 
-	//       
-	QTimer::singleShot(0, this, &TagsPanel::rearrangeTags);
+	m_completerModel->setStringList(completions);
+	m_completer->complete();
 }
@@ -2,14 +2,16 @@
 
 #include <QDockWidget>
 #include <QSet>
-#include <QMap>
+#include <functional>
+#include "tagprefixindex.h"
+#include "tagflowview.h"
 
 class QLabel;
-class QCheckBox;
 class QLineEdit;
 class QPushButton;
+class QCompleter;
+class QStringListModel;
 class QVBoxLayout;
-class QScrollArea;
 
 class TagsPanel : public QDockWidget
 {
@@ -20,9 +22,17 @@ public:
 	~TagsPanel();
 
 	//  
-	void setObjectTags(const QSet<QString>& objectTags);
+	// partialTags -     
+	void setObjectTags(const QSet<QString>& objectTags,
+		const QSet<QString>& partialTags = QSet<QString>());
 	void setAllTags(const QSet<QString>& allTags);
 	void setObjectName(const QString& name);
+	void setLoading(bool loading);
+	void setSuggestedTags(const QStringList& tags);	// "  "
+
+	//    (  )
+	typedef std::function<int(const QString&)> UsageFunc;
+	void setUsageProvider(const UsageFunc& usage) { m_usage = usage; }
 
 	//  
 	QSet<QString> getSelectedTags() const;
@@ -43,28 +53,46 @@ protected:
 private:
 	// UI 
 	QLabel *m_titleLabel;
-	QScrollArea *m_scrollArea;
-	QWidget *m_tagsContainer;
+	QLineEdit *m_filterEdit;
+	TagFlowView *m_tagView;
+	QLabel *m_suggestLabel;
+	TagFlowView *m_suggestView;
 	QLineEdit *m_newTagEdit;
 	QPushButton *m_addButton;
+	QCompleter *m_completer;
+	QStringListModel *m_completerModel;
 
 	// 
 	QSet<QString> m_objectTags;    //   
+	QSet<QString> m_partialTags;   //    
 	QSet<QString> m_allTags;       //   
 	QString m_objectName;
+	QString m_filter;              //    
+	TagPrefixIndex m_prefixIndex;  // m_allTags  
+	QStringList m_treeTags;        //      
+	QSet<QString> m_expandedTags;  //   
 
-	//  
-	QMap<QString, QCheckBox*> m_tagCheckboxes;
+	//   : ,   
+	//   .    -    
+	QStringList m_shownChecked;    //   ,  
+	TagPrefixIndex m_shownIndex;   //     ( )
+	QPair<int, int> m_shownRange;
+	QVector<int> m_shownSkipped;   //    ,  
+	UsageFunc m_usage;
 
 	//  
 	bool m_needsRefresh;
+	bool m_loading;		//    
 
 	//  
 	void refreshTags();
-	void createTagCheckboxes();
 	void updateTitle();
-	void rearrangeTags(); 
-	void createTagCheckbox(const QString& tag, bool checked);
+	void appendTree(QVector<TagFlowView::Item>& items) const;
+	TagFlowView::Item flatItem(int index) const;
 private slots:
-	void onTagCheckboxToggled(bool checked);
+	void onTagToggled(const QString& tag, bool checked);
+	void onSuggestionClicked(const QString& tag);
+	void onFilterChanged(const QString& text);
+	void onExpandToggled(const QString& tag);
+	void onNewTagEdited(const QString& text);
 };
@@ -0,0 +1,270 @@
+#include "tagstorage.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDir>
+#include <QMutex>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <errno.h>
+
+static const char XATTR_NAME[] = "user.mediabrowser.tags";
+
+//  xattr       
+static QMutex xattrMutex;
+static QHash<quint64, bool> xattrSupport;	// st_dev -> 
+
+static bool xattrSupported(const QByteArray& path)
+{
+	struct stat st;
+	if (::stat(path.constData(), &st) != 0) {
+		return false;
+	}
+
+	{
+		QMutexLocker locker(&xattrMutex);
+		auto it = xattrSupport.constFind(quint64(st.st_dev));
+		if (it != xattrSupport.constEnd()) {
+			return it.value();
+		}
+	}
+
+	// ENODATA -  ,    
+	errno = 0;
+	bool supported = ::getxattr(path.constData(), XATTR_NAME, nullptr, 0) >= 0 || errno != ENOTSUP;
+
+	QMutexLocker locker(&xattrMutex);
+	xattrSupport.insert(quint64(st.st_dev), supported);
+	return supported;
+}
+
+static void markXattrUnsupported(const QByteArray& path)
+{
+	struct stat st;
+	if (::stat(path.constData(), &st) == 0) {
+		QMutexLocker locker(&xattrMutex);
+		xattrSupport.insert(quint64(st.st_dev), false);
+	}
+}
+
+static bool readXattr(const QByteArray& path, QSet<QString>& tags)
+{
+	char buffer[4096];
+	ssize_t size = ::getxattr(path.constData(), XATTR_NAME, buffer, sizeof(buffer));
+
+	QByteArray large;
+	if (size < 0 && errno == ERANGE) {
+		//    -      
+		size = ::getxattr(path.constData(), XATTR_NAME, nullptr, 0);
+		if (size > 0) {
+			large.resize(int(size));
+			size = ::getxattr(path.constData(), XATTR_NAME, large.data(), size_t(large.size()));
+		}
+	}
+	if (size < 0) {
+		return false;
+	}
+
+	const char *data = large.isEmpty() ? buffer : large.constData();
+	QStringList tagList = QString::fromUtf8(data, int(size)).split(' ', Qt::SkipEmptyParts);
+	for (const QString &tag : tagList) {
+		tags.insert(tag.trimmed());
+	}
+	return true;
+}
+
+static bool writeXattr(const QByteArray& path, const QString& content)
+{
+	if (content.isEmpty()) {
+		return ::removexattr(path.constData(), XATTR_NAME) == 0 || errno == ENODATA;
+	}
+
+	const QByteArray data = content.toUtf8();
+	if (::setxattr(path.constData(), XATTR_NAME, data.constData(), size_t(data.size()), 0) == 0) {
+		return true;
+	}
+
+	if (errno == ENOTSUP) {
+		markXattrUnsupported(path);
+	}
+	return false;
+}
+#endif
+
+bool SidecarTagStorage::load(const QString& objectPath, QSet<QString>& tags)
+{
+	return loadTagsFromADS(objectPath, tags);
+}
+
+bool SidecarTagStorage::save(const QString& objectPath, const QSet<QString>& tags)
+{
+	return saveTagsToADS(objectPath, tags);
+}
+
+bool SidecarTagStorage::move(const QString& oldPath, const QString& newPath)
+{
+	// ADS  xattr    , .tags  - 
+	QString tagsSourcePath = oldPath + ".tags";
+	QString tagsTargetPath = newPath + ".tags";
+	if (!QFile::exists(tagsSourcePath)) {
+		return true;
+	}
+	if (QFile::exists(tagsTargetPath)) {
+		QFile::remove(tagsTargetPath);
+	}
+	return QFile::rename(tagsSourcePath, tagsTargetPath);
+}
+
+bool SidecarTagStorage::remove(const QString& objectPath)
+{
+	QString tagsPath = objectPath + ".tags";
+	if (QFile::exists(tagsPath)) {
+		return QFile::remove(tagsPath);
+	}
+	return true;
+}
+
+bool SidecarTagStorage::hasSidecar(const QString& filePath)
+{
+	return QFile::exists(filePath + ".tags");
+}
+
+bool SidecarTagStorage::readTagsFile(const QString& tagsFilePath, QSet<QString>& tags)
+{
+	QFile file(tagsFilePath);
+
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return false;
+	}
+
+	QTextStream in(&file);
+	QString content = in.readAll();
+	file.close();
+
+	QStringList tagList = content.split(' ', Qt::SkipEmptyParts);
+	for (const QString &tag : tagList) {
+		tags.insert(tag.trimmed());
+	}
+
+	return true;
+}
+
+bool SidecarTagStorage::loadDirectory(const QString& dirPath, QHash<QString, QSet<QString>>& result)
+{
+	//          
+	QDir dir(dirPath);
+	if (!dir.exists()) {
+		return false;
+	}
+	const QStringList names = dir.entryList(QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
+
+	QSet<QString> withSidecar;
+	for (const QString &name : names) {
+		if (name.endsWith(".tags")) {
+			withSidecar.insert(name.left(name.size() - 5));
+		}
+	}
+
+#ifdef Q_OS_LINUX
+	const bool useXattr = xattrSupported(QFile::encodeName(dirPath));
+#endif
+
+	for (const QString &name : names) {
+		if (name.endsWith(".tags")) continue;
+
+		const QString path = dir.absoluteFilePath(name);
+		QSet<QString> tags;
+
+#if defined(Q_OS_WINDOWS)
+		// ADS     -   
+		loadTagsFromADS(path, tags);
+#else
+#if defined(Q_OS_LINUX)
+		if (!useXattr || !readXattr(QFile::encodeName(path), tags))
+#endif
+		{
+			if (withSidecar.contains(name)) {
+				readTagsFile(path + ".tags", tags);
+			}
+		}
+#endif
+		result.insert(path, tags);
+	}
+
+	return true;
+}
+
+bool SidecarTagStorage::loadTagsFromADS(const QString& filePath, QSet<QString>& tags)
+{
+#ifdef Q_OS_WINDOWS
+	// Windows:  ADS,    - .tags 
+	QString streamPath = filePath + ":tags";
+	QFile adsFile(streamPath);
+
+	if (adsFile.exists() && adsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		QTextStream in(&adsFile);
+		QString content = in.readAll();
+		adsFile.close();
+
+		QStringList tagList = content.split(' ', Qt::SkipEmptyParts);
+		for (const QString &tag : tagList) {
+			tags.insert(tag.trimmed());
+		}
+		return true;
+	}
+#elif defined(Q_OS_LINUX)
+	// Linux:  ADS -  ,    
+	const QByteArray nativePath = QFile::encodeName(filePath);
+	if (xattrSupported(nativePath) && readXattr(nativePath, tags)) {
+		return true;
+	}
+#endif
+
+	//  fallback: .tags  
+	return readTagsFile(filePath + ".tags", tags);
+}
+
+bool SidecarTagStorage::saveTagsToADS(const QString& filePath, const QSet<QString>& tags)
+{
+	QStringList tagList = tags.values();
+	std::sort(tagList.begin(), tagList.end());
+	QString content = tagList.join(' ');
+
+#ifdef Q_OS_WINDOWS
+	// Windows:  ADS 
+	QString streamPath = filePath + ":tags";
+	QFile adsFile(streamPath);
+
+	if (adsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		QTextStream out(&adsFile);
+		out << content;
+		adsFile.close();
+		return true;
+	}
+#elif defined(Q_OS_LINUX)
+	// Linux:   xattr,  .tags    
+	const QByteArray nativePath = QFile::encodeName(filePath);
+	if (xattrSupported(nativePath) && writeXattr(nativePath, content)) {
+		QFile::remove(filePath + ".tags");
+		return true;
+	}
+#endif
+
+	//  fallback: .tags 
+	QString tagsFilePath = filePath + ".tags";
+	QFile file(tagsFilePath);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		qDebug() << "Cannot save tags to:" << tagsFilePath << file.errorString();
+		return false;
+	}
+
+	QTextStream out(&file);
+	out << content;
+	file.close();
+
+	return true;
+}
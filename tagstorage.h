@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QString>
+#include <QSet>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+
+//    (    )
+class TagStorage
+{
+public:
+	virtual ~TagStorage() {}
+
+	virtual QString name() const = 0;
+
+	// /   
+	virtual bool load(const QString& objectPath, QSet<QString>& tags) = 0;
+	virtual bool save(const QString& objectPath, const QSet<QString>& tags) = 0;
+
+	//   /  
+	virtual bool move(const QString& oldPath, const QString& newPath) = 0;
+	virtual bool remove(const QString& objectPath) = 0;
+
+	//       ( -> )
+	virtual bool loadDirectory(const QString& dirPath, QHash<QString, QSet<QString>>& result)
+	{
+		Q_UNUSED(dirPath);
+		Q_UNUSED(result);
+		return false;
+	}
+
+	//   ,     ( )
+	virtual bool entries(QVector<QPair<QString, QSet<QString>>>& result) const
+	{
+		Q_UNUSED(result);
+		return false;
+	}
+};
+
+//   ADS ":tags" (Windows),    user.mediabrowser.tags
+// (Linux,    xattr)    ".tags"   
+class SidecarTagStorage : public TagStorage
+{
+public:
+	QString name() const override { return "sidecar"; }
+
+	bool load(const QString& objectPath, QSet<QString>& tags) override;
+	bool save(const QString& objectPath, const QSet<QString>& tags) override;
+	bool move(const QString& oldPath, const QString& newPath) override;
+	bool remove(const QString& objectPath) override;
+	bool loadDirectory(const QString& dirPath, QHash<QString, QSet<QString>>& result) override;
+
+	//     -     
+	static bool loadTagsFromADS(const QString& filePath, QSet<QString>& tags);
+	static bool saveTagsToADS(const QString& filePath, const QSet<QString>& tags);
+	static bool hasSidecar(const QString& filePath);
+
+private:
+	static bool readTagsFile(const QString& tagsFilePath, QSet<QString>& tags);
+};
@@ -0,0 +1,241 @@
+#include "tracer.h"
+#include "perfstats.h"
+#include <QThread>
+#include <QProcess>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QVector>
+#include <QHash>
+#include <QSaveFile>
+#include <QDebug>
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+namespace
+{
+	// 64K   ;  
+	const quint32 RING_SIZE = 1 << 16;
+	//       :   
+	//  ,   
+	const quint32 RING_GUARD = 16;
+
+	struct TraceEvent
+	{
+		const char *name = nullptr;
+		qint64 ts = 0;
+		qint64 dur = 0;
+		qint64 pid = 0;
+		QString arg;
+	};
+
+	//   :   , head 
+	//   
+	struct ThreadBuffer
+	{
+		int tid = 0;
+		QString name;
+		QVector<TraceEvent> events;
+		std::atomic<quint32> head{ 0 };
+		quint32 base = 0;		//   base   start()
+	};
+
+	//     :    
+	//  
+	QMutex g_registryMutex;
+	QVector<ThreadBuffer*> g_buffers;
+	thread_local ThreadBuffer *t_buffer = nullptr;
+
+	ThreadBuffer* threadBuffer()
+	{
+		if (t_buffer) {
+			return t_buffer;
+		}
+
+		ThreadBuffer *buffer = new ThreadBuffer();
+		buffer->events.resize(RING_SIZE);
+
+		QThread *thread = QThread::currentThread();
+		QMutexLocker locker(&g_registryMutex);
+		buffer->tid = g_buffers.size() + 1;
+		if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+			buffer->name = "GUI";
+		}
+		else if (thread && !thread->objectName().isEmpty()) {
+			buffer->name = thread->objectName();
+		}
+		else {
+			buffer->name = QString("Thread %1").arg(buffer->tid);
+		}
+		g_buffers.append(buffer);
+
+		t_buffer = buffer;
+		return buffer;
+	}
+
+	void appendJsonString(QByteArray& out, const QString& value)
+	{
+		out += '"';
+		for (QChar c : value) {
+			switch (c.unicode()) {
+			case '"':	out += "\\\""; break;
+			case '\\':	out += "\\\\"; break;
+			case '\n':	out += "\\n"; break;
+			case '\r':	out += "\\r"; break;
+			case '\t':	out += "\\t"; break;
+			default:
+				if (c.unicode() < 0x20) {
+					out += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')).toLatin1();
+				}
+				else {
+					out += QString(c).toUtf8();
+				}
+			}
+		}
+		out += '"';
+	}
+
+	void appendMetadata(QByteArray& out, const char *kind, qint64 pid, qint64 tid, const QString& name)
+	{
+		out += QString("{\"name\":\"%1\",\"ph\":\"M\",\"pid\":%2,\"tid\":%3,\"args\":{\"name\":")
+			.arg(kind).arg(pid).arg(tid).toLatin1();
+		appendJsonString(out, name);
+		out += "}},\n";
+	}
+}
+
+void Tracer::start()
+{
+	QMutexLocker locker(&g_registryMutex);
+	for (ThreadBuffer *buffer : g_buffers) {
+		buffer->base = buffer->head.load(std::memory_order_acquire);
+	}
+	s_enabled.store(true, std::memory_order_release);
+}
+
+bool Tracer::stop(const QString& filePath)
+{
+	s_enabled.store(false, std::memory_order_release);
+	if (filePath.isEmpty()) {
+		return false;
+	}
+
+	const qint64 ownPid = QCoreApplication::applicationPid();
+	QByteArray out;
+	out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	appendMetadata(out, "process_name", ownPid, 0, QCoreApplication::applicationName());
+
+	QHash<qint64, const char*> processes;	// pid ->   
+	int written = 0;
+	{
+		QMutexLocker locker(&g_registryMutex);
+		for (const ThreadBuffer *buffer : g_buffers) {
+			appendMetadata(out, "thread_name", ownPid, buffer->tid, buffer->name);
+
+			const quint32 head = buffer->head.load(std::memory_order_acquire);
+			quint32 first = buffer->base;
+			if (head - first > RING_SIZE - RING_GUARD) {
+				first = head - (RING_SIZE - RING_GUARD);
+			}
+
+			for (quint32 i = first; i != head; ++i) {
+				const TraceEvent &event = buffer->events[int(i % RING_SIZE)];
+				const qint64 pid = event.pid ? event.pid : ownPid;
+				const qint64 tid = event.pid ? event.pid : buffer->tid;
+				if (event.pid) {
+					processes.insert(event.pid, event.name);
+				}
+
+				out += QString("{\"name\":\"%1\",\"cat\":\"pipeline\",\"ph\":\"X\",\"ts\":%2,\"dur\":%3,\"pid\":%4,\"tid\":%5")
+					.arg(event.name).arg(event.ts).arg(event.dur).arg(pid).arg(tid).toLatin1();
+				if (!event.arg.isEmpty()) {
+					out += ",\"args\":{\"arg\":";
+					appendJsonString(out, event.arg);
+					out += '}';
+				}
+				out += "},\n";
+				++written;
+			}
+		}
+	}
+
+	for (auto it = processes.constBegin(); it != processes.constEnd(); ++it) {
+		appendMetadata(out, "process_name", it.key(), it.key(), QString(it.value()));
+	}
+
+	//   
+	if (out.endsWith(",\n")) {
+		out.chop(2);
+	}
+	out += "\n]}\n";
+
+	QSaveFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "Cannot save trace:" << filePath << file.errorString();
+		return false;
+	}
+	file.write(out);
+	if (!file.commit()) {
+		qDebug() << "Cannot save trace:" << filePath << file.errorString();
+		return false;
+	}
+
+	qDebug() << "Saved trace:" << written << "events to" << filePath;
+	return true;
+}
+
+void Tracer::complete(const char *name, qint64 startUs, qint64 durUs, const QString& arg, qint64 pid)
+{
+	ThreadBuffer *buffer = threadBuffer();
+	const quint32 head = buffer->head.load(std::memory_order_relaxed);
+
+	TraceEvent &event = buffer->events[int(head % RING_SIZE)];
+	event.name = name;
+	event.ts = startUs;
+	event.dur = durUs;
+	event.pid = pid;
+	event.arg = arg;
+
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+TraceScope::TraceScope(const char *name, const QString& arg)
+	: m_name(name)
+	, m_start(-1)
+{
+	if (Tracer::isEnabled()) {
+		m_arg = arg;
+		m_start = PerfStats::now();
+	}
+}
+
+TraceScope::~TraceScope()
+{
+	if (m_start >= 0) {
+		Tracer::complete(m_name, m_start, PerfStats::now() - m_start, m_arg);
+	}
+}
+
+TraceProcess::TraceProcess(const char *name, const QString& arg)
+	: m_name(name)
+	, m_start(-1)
+	, m_pid(0)
+{
+	if (Tracer::isEnabled()) {
+		m_arg = arg;
+		m_start = PerfStats::now();
+	}
+}
+
+TraceProcess::~TraceProcess()
+{
+	if (m_start >= 0 && m_pid != 0) {
+		Tracer::complete(m_name, m_start, PerfStats::now() - m_start, m_arg, m_pid);
+	}
+}
+
+void TraceProcess::started(const QProcess& process)
+{
+	if (m_start >= 0) {
+		m_pid = process.processId();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+
+class QProcess;
+
+//      Trace Event (JSON  chrome://tracing
+//  Perfetto).      ,    
+// ;      .
+//      objectName()  QThread
+class Tracer
+{
+public:
+	static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+	//     
+	static void start();
+	//     (  
+	// );    -  
+	static bool stop(const QString& filePath);
+
+	//    [startUs, startUs + durUs]  
+	// PerfStats::now(). pid -   (0 - )
+	static void complete(const char *name, qint64 startUs, qint64 durUs,
+		const QString& arg = QString(), qint64 pid = 0);
+
+private:
+	static std::atomic<bool> s_enabled;
+};
+
+//     ; name -  
+class TraceScope
+{
+public:
+	explicit TraceScope(const char *name, const QString& arg = QString());
+	~TraceScope();
+
+private:
+	const char *m_name;
+	QString m_arg;
+	qint64 m_start;		// -1 -   
+
+	Q_DISABLE_COPY(TraceScope)
+};
+
+//     -       pid
+class TraceProcess
+{
+public:
+	explicit TraceProcess(const char *name, const QString& arg = QString());
+	~TraceProcess();
+
+	//   waitForStarted():  pid   
+	void started(const QProcess& process);
+
+private:
+	const char *m_name;
+	QString m_arg;
+	qint64 m_start;
+	qint64 m_pid;
+
+	Q_DISABLE_COPY(TraceProcess)
+};
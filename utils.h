@@ -1,6 +1,8 @@
 #pragma once
 #include <QList>
 #include <QStringList>
+#include <QVector>
+#include <algorithm>
 
 //        
 struct SelectedFilesInfo {
@@ -10,4 +12,36 @@ struct SelectedFilesInfo {
 	int size() const { return filenames.size(); }
 };
 
+//   :  ,  ,   [0, size)
+inline QVector<int> sortedRemovalIndices(const QList<int>& indices, int size)
+{
+	QVector<int> result;
+	result.reserve(indices.size());
+	for (int index : indices) {
+		if (index >= 0 && index < size) {
+			result.append(index);
+		}
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
 
+//        
+// (   removeAt   )
+template<typename T>
+void removeSortedIndices(QVector<T>& items, const QVector<int>& sortedIndices)
+{
+	if (sortedIndices.isEmpty()) return;
+
+	int write = sortedIndices.first();
+	int next = 0;
+	for (int read = write; read < items.size(); ++read) {
+		if (next < sortedIndices.size() && sortedIndices[next] == read) {
+			++next;
+			continue;
+		}
+		items[write++] = std::move(items[read]);
+	}
+	items.resize(write);
+}